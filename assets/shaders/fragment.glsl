@@ -4,22 +4,29 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
-in vec4 FragPosLightSpace;
 
 struct Material {
     sampler2D diffuse;
     sampler2D specular;
 }; 
 
-struct DirLight {
-    vec3 direction;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
+// [UBO] std140 per-frame data, shared by all programs (see Renderer::UpdateFrameUniforms)
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+} camera;
+
+layout (std140) uniform LightBlock {
+    mat4 lightSpaceMatrices[4]; // CASCADE_COUNT
+    vec4 cascadeSplits;         // view-space far distance per cascade
+    vec4 cascadeBias;           // depth of one shadow texel per cascade
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+} dirLight;
 
-uniform vec3 viewPos;
-uniform DirLight dirLight;
 uniform Material material;
 
 // PBR Parameters
@@ -28,7 +35,20 @@ uniform float roughness;
 uniform float metallic;
 
 uniform int useTexture;
-uniform sampler2D shadowMap;
+uniform sampler2DArray shadowMap; // one layer per cascade
+
+// [Atlas] small textures live in one array (see TextureAtlas); atlasLayer < 0: material.diffuse
+uniform sampler2DArray atlasPages;
+uniform int atlasLayer;
+uniform vec4 atlasRect; // region offset (xy) and size (zw) in page UVs
+
+// [VT] streamed pages (see VirtualTexture): the indirection texel of a level-0 tile
+// holds the slot (xy) and level (z) of the finest resident page covering it
+uniform int virtualTexture;
+uniform sampler2D vtCache;
+uniform sampler2D vtIndirection;
+uniform vec4 vtSize;  // level-0 width, height, tile size, border (texels)
+uniform float vtSlots; // pages per row of vtCache
 
 const float PI = 3.14159265359;
 
@@ -36,19 +56,21 @@ float DistributionGGX(vec3 N, vec3 H, float roughness);
 float GeometrySchlickGGX(float NdotV, float roughness);
 float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness);
 vec3 fresnelSchlick(float cosTheta, vec3 F0);
-float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir);
+float ShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir);
+vec3 SampleDiffuse(vec2 uv);
+vec3 SampleVirtual(vec2 uv);
 
 void main()
 {
     vec3 N = normalize(Normal);
-    vec3 V = normalize(viewPos - FragPos);
+    vec3 V = normalize(camera.viewPos.xyz - FragPos);
 
     // Base reflectivity
     vec3 F0 = vec3(0.04); 
     F0 = mix(F0, albedo, metallic);
 
     // Calculate per-light radiance (Directional Light)
-    vec3 L = normalize(-dirLight.direction);
+    vec3 L = normalize(-dirLight.direction.xyz);
     vec3 H = normalize(V + L);
     
     // Cook-Torrance BRDF
@@ -77,17 +99,17 @@ void main()
     // Texture sampling (if enabled)
     vec3 finalAlbedo = albedo;
     if (useTexture > 0) {
-        finalAlbedo = vec3(texture(material.diffuse, TexCoords));
+        finalAlbedo = SampleDiffuse(TexCoords);
         // Note: We could also sample roughness/metallic maps here if we had them
     }
 
     // Final radiance
     // Note: dirLight.diffuse is used as light color/intensity here
-    vec3 Lo = (kD * finalAlbedo / PI + specular) * dirLight.diffuse * NdotL; 
+    vec3 Lo = (kD * finalAlbedo / PI + specular) * dirLight.diffuse.rgb * NdotL; 
     
     // Shadow
-    float shadow = ShadowCalculation(FragPosLightSpace, N, L);       
-    vec3 color = (dirLight.ambient * finalAlbedo) + (1.0 - shadow) * Lo;
+    float shadow = ShadowCalculation(FragPos, N, L);       
+    vec3 color = (dirLight.ambient.rgb * finalAlbedo) + (1.0 - shadow) * Lo;
 
     // HDR tonemapping (Reinhard)
     color = color / (color + vec3(1.0));
@@ -97,6 +119,33 @@ void main()
     FragColor = vec4(color, 1.0);
 }
 
+// ----------------------------------------------------------------------------
+vec3 SampleDiffuse(vec2 uv)
+{
+    if (virtualTexture > 0)
+        return SampleVirtual(uv);
+    if (atlasLayer < 0)
+        return vec3(texture(material.diffuse, uv));
+    // GL_REPEAT inside the region; gradients of the unwrapped uv keep the mip level
+    // continuous across the wrap (the gutter covers the bilinear footprint)
+    vec2 pageUV = atlasRect.xy + fract(uv) * atlasRect.zw;
+    return vec3(textureGrad(atlasPages, vec3(pageUV, float(atlasLayer)), dFdx(uv) * atlasRect.zw, dFdy(uv) * atlasRect.zw));
+}
+// ----------------------------------------------------------------------------
+vec3 SampleVirtual(vec2 uv)
+{
+    // Clamped addressing; pages carry a border, so bilinear taps stay in the page
+    vec2 texel = clamp(uv, 0.0, 1.0) * vtSize.xy;
+    ivec2 tile = min(ivec2(texel / vtSize.z), textureSize(vtIndirection, 0) - 1);
+    vec4 entry = floor(texelFetch(vtIndirection, tile, 0) * 255.0 + 0.5);
+    if (entry.a == 0.0)
+        return vec3(0.5); // nothing resident yet
+    int level = int(entry.z);
+    vec2 inPage = texel / (vtSize.z * exp2(entry.z)) - vec2(tile >> level);
+    float padded = vtSize.z + 2.0 * vtSize.w;
+    vec2 cacheUV = (entry.xy * padded + vtSize.w + inPage * vtSize.z) / (vtSlots * padded);
+    return textureLod(vtCache, cacheUV, 0.0).rgb;
+}
 // ----------------------------------------------------------------------------
 float DistributionGGX(vec3 N, vec3 H, float roughness)
 {
@@ -138,36 +187,46 @@ vec3 fresnelSchlick(float cosTheta, vec3 F0)
     return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }
 // ----------------------------------------------------------------------------
-float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir)
+float ShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir)
 {
+    // [CSM] pick the first cascade whose split contains the fragment
+    float viewDepth = -(camera.view * vec4(fragPos, 1.0)).z;
+    int cascade = -1;
+    for (int i = 3; i >= 0; --i)
+    {
+        if (viewDepth < dirLight.cascadeSplits[i])
+            cascade = i;
+    }
+    // beyond the shadow distance
+    if (cascade < 0)
+        return 0.0;
+
+    vec4 fragPosLightSpace = dirLight.lightSpaceMatrices[cascade] * vec4(fragPos, 1.0);
     // perform perspective divide
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     // transform to [0,1] range
     projCoords = projCoords * 0.5 + 0.5;
-    // get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-    float closestDepth = texture(shadowMap, projCoords.xy).r; 
+    // keep the shadow at 0.0 when outside the far_plane region of the light's frustum.
+    if(projCoords.z > 1.0)
+        return 0.0;
     // get depth of current fragment from light's perspective
     float currentDepth = projCoords.z;
-    // calculate bias (based on depth map resolution and slope)
-    float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
-    // check whether current frag pos is in shadow
-    // float shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;
+    // bias in shadow texels: cascades have different texel sizes and depth ranges
+    float NdotL = clamp(dot(normal, lightDir), 0.0, 1.0);
+    float slope = min(sqrt(1.0 - NdotL * NdotL) / max(NdotL, 0.05), 4.0);
+    float bias = dirLight.cascadeBias[cascade] * (1.5 + slope);
     // PCF
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
     for(int x = -1; x <= 1; ++x)
     {
         for(int y = -1; y <= 1; ++y)
         {
-            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
+            float pcfDepth = texture(shadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, float(cascade))).r; 
             shadow += currentDepth - bias > pcfDepth  ? 1.0 : 0.0;        
         }    
     }
     shadow /= 9.0;
-    
-    // keep the shadow at 0.0 when outside the far_plane region of the light's frustum.
-    if(projCoords.z > 1.0)
-        shadow = 0.0;
         
     return shadow;
 }
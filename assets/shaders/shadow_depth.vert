@@ -1,10 +1,20 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 lightSpaceMatrix;
+layout (std140) uniform LightBlock {
+    mat4 lightSpaceMatrices[4]; // CASCADE_COUNT
+    vec4 cascadeSplits;         // view-space far distance per cascade
+    vec4 cascadeBias;           // depth of one shadow texel per cascade
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+} dirLight;
+
 uniform mat4 model;
+uniform int cascadeIndex;
 
 void main()
 {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    gl_Position = dirLight.lightSpaceMatrices[cascadeIndex] * model * vec4(aPos, 1.0);
 }
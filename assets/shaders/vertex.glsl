@@ -1,25 +1,47 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+layout (location = 1) in vec2 aNormalOct; // octahedral, see VertexCodec
 layout (location = 2) in vec2 aTexCoords;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
-out vec4 FragPosLightSpace;
+
+// [UBO] std140 per-frame data, shared by all programs (see Renderer::UpdateFrameUniforms)
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+} camera;
+
+layout (std140) uniform LightBlock {
+    mat4 lightSpaceMatrices[4]; // CASCADE_COUNT
+    vec4 cascadeSplits;         // view-space far distance per cascade
+    vec4 cascadeBias;           // depth of one shadow texel per cascade
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+} dirLight;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 uniform mat3 normalMatrix;
-uniform mat4 lightSpaceMatrix;
+
+// [Packed] octahedral normal back to a unit vector (matches VertexCodec::DecodeOctahedral)
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main()
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = normalMatrix * aNormal;  
+    Normal = normalMatrix * DecodeOctahedral(aNormalOct);
     TexCoords = aTexCoords;
-    FragPosLightSpace = lightSpaceMatrix * vec4(FragPos, 1.0);
     
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    gl_Position = camera.projection * camera.view * vec4(FragPos, 1.0);
 }
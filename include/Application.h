@@ -9,6 +9,29 @@
 #include "SceneContext.h"
 #include "Camera.h"
 #include "Shader.h"
+#include "Culling.h"
+#include "OcclusionCulling.h"
+#include "RenderQueue.h"
+#include "ScreenCapture.h"
+
+// [Tiled] 一次场景绘制的目标：窗口，或分块截图中的一块
+struct SceneView
+{
+    glm::mat4 projection;        // frustum drawn and culled
+    glm::mat4 cascadeProjection; // frustum the shadow cascades fit (the whole image's)
+    unsigned int framebuffer = 0;
+    int width = 0, height = 0;
+};
+
+// [Headless] 命令行参数 (见 main.cpp)
+struct HeadlessOptions
+{
+    std::string scenePath;                    // empty: built-in default scene
+    std::string outputPath = "headless.bmp";  // rendered image (.png: PNG, else BMP)
+    std::string timingPath;                   // optional JSON timing report
+    int frames = 1;                           // frames rendered for timing
+    bool imageBench = false;                  // also time BMP / PNG writers on the frame
+};
 
 class Application
 {
@@ -18,6 +41,9 @@ public:
 
     void Run();
 
+    // [Headless] 不创建窗口/GL 上下文，用 SoftwareRasterizer 渲染场景并输出图像与耗时
+    int RunHeadless(const HeadlessOptions &options);
+
 private:
     GLFWwindow *window;
     int scrWidth;
@@ -28,6 +54,16 @@ private:
     SceneContext *scene;
     Shader *mainShader;
 
+    // [Culling] 每帧的包围盒缓存与可见列表
+    PartC::CullingBounds cullingBounds;
+    std::vector<uint32_t> mainVisible;
+    std::vector<uint32_t> shadowVisible;
+    std::vector<uint32_t> staticCasters, dynamicCasters; // [Shadow Cache] split of shadowVisible
+    std::vector<Mesh *> lodMeshes;                        // [LOD] mesh drawn for each cullingBounds entry
+    PartC::OcclusionBuffer occlusionBuffer;
+    PartC::RenderQueue shadowQueue;
+    PartC::RenderQueue mainQueue;
+
     // Runtime System
     bool isRuntime = false;
     SceneContext *editorSceneBackup = nullptr;
@@ -62,6 +98,10 @@ private:
     char screenshotPathBuffer[256] = "screenshots/screenshot.png";
     int screenshotFormat = 0; // 0: BMP, 1: PNG
     bool isScreenshotDialogOpen = false;
+    PartC::ScreenCapture screenCapture; // [Capture] PBO readback + background encoder
+    int screenshotResolution = 0;       // [Tiled] 0: window, else a poster preset (PNG, tiled)
+    std::string posterPath;             // [Tiled] drawn after the next frame's scene
+    int posterWidth = 0, posterHeight = 0;
 
     // 初始化
     bool InitGLFW();
@@ -72,6 +112,10 @@ private:
     void ProcessInput();
     void RenderUI();
     void RenderScene();
+    void RenderScene(const SceneView &sceneView);
+    void SelectLods(const glm::mat4 &projection);
+    void RenderShadowCascades();
+    void SubmitShadowCasters(const std::vector<uint32_t> &casters);
     void DeleteSelectedObject();
 
     // 射线检测算法
@@ -93,7 +137,9 @@ private:
     
     // [新增] 屏幕截图相关函数
     void CaptureScreen();
+    void ToggleRecording();
     bool SaveScreenshot(const std::string& filePath, int format);
+    bool RenderTiledScreenshot(const std::string& filePath, int width, int height);
     void RenderScreenshotDialog();
 
     // 回调
@@ -0,0 +1,52 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace PartC
+{
+    enum class BlockFormat : uint32_t
+    {
+        None = 0, // 8 bits per channel, uncompressed
+        BC1 = 1,  // DXT1: RGB, 4 bits per texel
+        BC3 = 2,  // DXT5: BC1 colour + interpolated alpha, 8 bits per texel
+        BC7 = 3   // BPTC: RGBA, 8 bits per texel, mode 6 only
+    };
+
+    // BlockCompression: 4x4 块压缩纹理的 CPU 编码 / 解码 (不依赖 GPU)
+    // BC1 / BC3 colour endpoints come from the principal axis of the block and are
+    // refined once by least squares on the chosen indices; BC3 alpha uses min / max
+    // with 8 interpolated values. BC7 uses mode 6 only (one RGBA subset, 7-bit
+    // endpoints with a p-bit each, 4-bit indices), trying all four p-bit pairs: far
+    // from the best BC7 encoders, but every block is encoded the same, cheap way.
+    // Blocks past the image edge repeat the edge texels. Rows of blocks are encoded
+    // in parallel on the ThreadPool.
+    class BlockCompression
+    {
+    public:
+        static const char *Name(BlockFormat format);
+        static size_t BlockBytes(BlockFormat format); // 8 (BC1) or 16
+        static size_t EncodedSize(int width, int height, BlockFormat format);
+
+        // Format actually used for an image: BC1 and BC3 pick each other by alpha,
+        // images with 1 or 2 channels stay uncompressed
+        static BlockFormat Choose(BlockFormat requested, int channels);
+
+        static std::vector<uint8_t> Encode(const unsigned char *pixels, int width, int height, int channels,
+                                           BlockFormat format);
+        // RGBA8 texels, for fallback uploads and error metrics
+        static std::vector<uint8_t> Decode(const uint8_t *blocks, int width, int height, BlockFormat format);
+
+        // Over the source's channels; 99 dB for identical images
+        static double PSNR(const unsigned char *pixels, int channels, const uint8_t *rgba, int width, int height);
+
+        // GL thread: whether the driver takes the format (extensions queried once)
+        static bool IsSupported(BlockFormat format);
+        static GLenum GLFormat(BlockFormat format);
+    };
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef CACHE_UTIL_H
+#define CACHE_UTIL_H
+
+#include <cstdint>
+#include <string>
+
+namespace PartC
+{
+    // 派生缓存文件 (.texcache / .vtex / .meshcache) 的共用工具
+    // Size and modification time of a cache's source file; a cache records both and
+    // is stale once either differs. False if the file cannot be queried.
+    bool SourceStamp(const std::string &path, uint64_t &size, int64_t &time);
+}
+
+#endif
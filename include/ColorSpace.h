@@ -0,0 +1,20 @@
+#ifndef COLOR_SPACE_H
+#define COLOR_SPACE_H
+
+namespace PartC
+{
+    // sRGB <-> linear 查表：decode 按 8-bit 值索引，encode 按线性值 * (ENCODE_SIZE - 1) 索引
+    struct SrgbTables
+    {
+        static const int ENCODE_SIZE = 16384;
+        float decode[256];
+        unsigned char encode[ENCODE_SIZE];
+
+        SrgbTables();
+    };
+
+    // Built on first use; read-only afterwards, so any thread
+    const SrgbTables &Srgb();
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct SceneObject;
+
+namespace PartC
+{
+    // 视锥体：6 个平面，xyz 为法线，w 为距离；点在内侧时 dot(n, p) + w >= 0
+    struct Frustum
+    {
+        glm::vec4 planes[6];
+
+        // Gribb/Hartmann plane extraction from a projection * view matrix
+        static Frustum FromMatrix(const glm::mat4 &viewProjection);
+
+        // Same volume, open towards the near side: for passes drawn with GL_DEPTH_CLAMP
+        // (shadow maps), where geometry in front of the near plane is still rasterized
+        Frustum WithoutNearPlane() const
+        {
+            Frustum f = *this;
+            f.planes[4] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            return f;
+        }
+    };
+
+    // 场景世界空间 AABB 的 SoA 缓存，每帧构建一次，供阴影/主渲染两个 Pass 共用
+    // Objects without a mesh are skipped, so indices refer to `objects` here, not to the scene.
+    struct CullingBounds
+    {
+        std::vector<SceneObject *> objects;
+        std::vector<float> minX, minY, minZ;
+        std::vector<float> maxX, maxY, maxZ;
+
+        void Build(const std::vector<SceneObject *> &sceneObjects);
+        size_t Size() const { return objects.size(); }
+    };
+
+    struct CullStats
+    {
+        int tested = 0;
+        int visible = 0;
+        int culled = 0;
+    };
+
+    class Culling
+    {
+    public:
+        // Writes the indices of boxes that intersect the frustum into outVisible
+        static void FrustumCull(const Frustum &frustum, const CullingBounds &bounds,
+                                std::vector<uint32_t> &outVisible, CullStats &stats);
+
+        // Culling disabled: every object is visible
+        static void SelectAll(const CullingBounds &bounds, std::vector<uint32_t> &outVisible, CullStats &stats);
+    };
+}
+
+#endif
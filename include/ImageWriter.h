@@ -0,0 +1,35 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include "PngWriter.h"
+#include <cstdint>
+#include <string>
+
+namespace PartC
+{
+    enum class ImageFormat : int
+    {
+        BMP = 0,
+        PNG = 1
+    };
+
+    // ImageWriter: 截图 / 无头渲染的图像输出
+    // Pixels are 8-bit RGB or RGBA with row 0 at the bottom (glReadPixels order);
+    // alpha is not written. BMP rows are converted into one reused row buffer and
+    // written one row per call; PNG goes through PngWriter. Any thread.
+    class ImageWriter
+    {
+    public:
+        // pngLevel: only used for PNG
+        static bool Write(const std::string &path, const uint8_t *pixels, int width, int height, int channels,
+                          ImageFormat format, PngCompression pngLevel);
+        // 24-bit BMP (stored bottom-up, so rows go out in the order they come)
+        static bool WriteBMP(const std::string &path, const uint8_t *pixels, int width, int height, int channels);
+        // 24-bit PNG
+        static bool WritePNG(const std::string &path, const uint8_t *pixels, int width, int height, int channels,
+                             PngCompression level);
+        static const char *Extension(ImageFormat format);
+    };
+}
+
+#endif
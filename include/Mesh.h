@@ -5,27 +5,78 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <string>
+#include <memory>
+#include <cstdint>
 #include "Shader.h"
 #include "Common.h"
 #include "Texture.h"
+#include "Meshlets.h"
 
 // Mesh 类：负责存储几何数据和渲染
 // 职责：[Part C] 负责维护此类的内部实现（VAO/VBO管理）
+struct MeshBVH;
+namespace PartC
+{
+    struct LodBuildState;
+}
+
 class Mesh
 {
 public:
+    // 单调递增，从不复用：释放后在同一地址新建的 Mesh 也有新的 id (e.g. [Shadow Cache] signatures)
+    const uint64_t id;
+
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
 
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
+    // Local-space bounding box, computed from vertices on construction
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    // Triangle BVH used by ray queries, built lazily (see RayQuery.h)
+    std::shared_ptr<MeshBVH> bvh;
+
+    // [LOD] 更粗糙的细节层次 (lods[0] = level 1)，由 MeshLOD::BuildChain 生成
+    std::vector<std::shared_ptr<Mesh>> lods;
+    bool lodChainBuilt = false;
+    std::shared_ptr<PartC::LodBuildState> lodBuild; // imported meshes: background simplification in flight
+
+    // [Packed] GPU 端顶点格式 (见 VertexCodec.h)；vertices 是未压缩的原始数据
+    bool halfTexCoords = true;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    // [Meshlet] 三角形数达到 Meshlets::minTriangles 的网格被划分为簇，indices 按簇的顺序排列
+    std::vector<PartC::Meshlet> meshlets;
+
+    // meshlets: already built for these indices (MeshOptimizer / .meshcache); empty = build here
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+         std::vector<PartC::Meshlet> meshlets = std::vector<PartC::Meshlet>());
+    // 释放 VAO / VBO / EBO (GL 线程；headless 时没有 GL 对象)
+    ~Mesh();
+    // GL 句柄只归一个 Mesh 所有，不可复制
+    Mesh(const Mesh &) = delete;
+    Mesh &operator=(const Mesh &) = delete;
 
     // 渲染网格
     void Draw(Shader &shader);
 
+    // [RenderQueue] Draw 拆成状态绑定与绘制两步，队列可跳过重复的绑定
+    void BindTextures(Shader &shader);
+    // [Atlas] 每次绘制设置 diffuse 纹理在 TextureAtlas 中的层与区域（不在图集中时层为 -1）
+    // [VT] 或绑定其虚拟纹理的页缓存与间接纹理
+    void ApplyDiffuseSource(Shader &shader) const;
+    void BindVertexArray() const { glBindVertexArray(VAO); }
+    void DrawElements() const;
+    // [Meshlet] 只绘制给定的索引区间 (一次 glMultiDrawElements)
+    void DrawRanges(const std::vector<PartC::MeshletRange> &ranges) const;
+
+    // 顶点数据修改后需要重新计算包围盒
+    void RecalculateBounds();
+
 private:
-    unsigned int VAO, VBO, EBO;
-    void setupMesh();
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    void setupMesh(const std::vector<uint8_t> &packedVertices);
 };
 
 #endif
\ No newline at end of file
@@ -13,8 +13,8 @@ public:
     // 是否是凸包（简化碰撞检测，暂未实现凸包生成算法，仅作为标志位）
     bool convex = false;
 
-    // 如果为 null，这使用 owner->mesh
-    Mesh *sharedMesh = nullptr;
+    // 如果为 null，这使用 owner->mesh (与物体共同持有)
+    std::shared_ptr<Mesh> sharedMesh;
 
     MeshColliderComponent();
     virtual ~MeshColliderComponent();
@@ -22,6 +22,9 @@ public:
     void Start() override;
     void OnDrawGizmos(Shader &shader) override;
 
+    // 物体网格被替换时 (例如简化) 切换到新网格并重算包围盒
+    void SetMesh(std::shared_ptr<Mesh> mesh);
+
     // 获取世界空间 AABB
     void GetWorldAABB(glm::vec3 &outMin, glm::vec3 &outMax) override;
     void GetAABBAtPosition(const glm::vec3 &pos, glm::vec3 &outMin, glm::vec3 &outMax) override;
@@ -0,0 +1,68 @@
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include "Common.h"
+#include <glm/glm.hpp>
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+class Mesh;
+struct SceneObject;
+
+namespace PartC
+{
+    // [LOD] 导入网格的简化在后台进行：worker 写入各级几何，GL 线程在 done 后创建 Mesh
+    struct LodBuildState
+    {
+        std::atomic<bool> done{false};
+        std::vector<std::vector<Vertex>> vertices; // per level, finest first
+        std::vector<std::vector<unsigned int>> indices;
+    };
+
+    struct LodStats
+    {
+        static const int MAX_LEVELS = 5;
+
+        int objects = 0;
+        int levelCounts[MAX_LEVELS] = {0};
+        long long trianglesFull = 0;  // what level 0 would have drawn
+        long long trianglesDrawn = 0; // after LOD selection
+    };
+
+    // MeshLOD: 网格细节层次链的生成与按屏幕尺寸选择
+    // Level 0 is the mesh itself; coarser levels live in Mesh::lods.
+    //   - Sphere / Cylinder / Cone: regenerated with half the segments per level
+    //   - imported meshes: quadric error metric edge collapse (MeshSimplifier), run as a
+    //     background job started at import; level 0 is drawn until it has finished
+    //   - cubes, planes, prisms and frustums keep their exact shape (no chain)
+    // Selection uses the projected height of the bounding sphere as a fraction of
+    // the viewport, with hysteresis so objects near a threshold do not flicker.
+    class MeshLOD
+    {
+    public:
+        static const int MAX_LEVELS = LodStats::MAX_LEVELS;
+
+        // Level i is kept while the object covers at least screenSizes[i] of the screen height
+        static float screenSizes[MAX_LEVELS - 1];
+        // Relative band around each threshold: switch coarser below (1 - h), finer above (1 + h)
+        static float hysteresis;
+
+        // Builds obj->mesh->lods once; returns false while the mesh has no chain (yet).
+        // Imported meshes are simplified on a ThreadPool background job and their levels
+        // created on the next call after it finishes (GL thread); wait: simplify right here
+        static bool BuildChain(SceneObject *obj, bool wait = false);
+
+        // Bounding-sphere height over viewport height (1 when the camera is inside)
+        static float ScreenSize(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                                const glm::vec3 &camPos, const glm::mat4 &projection);
+
+        // Updates obj->lodLevel with hysteresis and returns the mesh to draw
+        static Mesh *Select(SceneObject *obj, float screenSize, LodStats &stats);
+
+        // Level for a screen size given the current one (no chain lookup)
+        static int SelectLevel(float screenSize, int currentLevel, int levelCount);
+    };
+}
+
+#endif
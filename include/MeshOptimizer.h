@@ -0,0 +1,74 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include "Common.h"
+#include "Meshlets.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace PartC
+{
+    struct VertexCacheStats
+    {
+        float acmr = 0.0f; // vertex shader runs per triangle (0.5 is ideal for large grids, 3 is no reuse)
+        float atvr = 0.0f; // vertex shader runs per vertex (1 is ideal)
+    };
+
+    struct MeshOptimizeReport
+    {
+        size_t verticesIn = 0, verticesOut = 0;
+        size_t triangles = 0;
+        int clusters = 0; // overdraw clusters (0 when the overdraw pass is off)
+        VertexCacheStats before, after;
+        bool fromCache = false;
+        float ms = 0.0f;
+    };
+
+    // MeshOptimizer: 导入模型的顶点缓存 / 过度绘制 / 顶点读取顺序优化
+    //   1. weld identical vertices (OBJ faces are expanded to three vertices each)
+    //   2. Tipsify (Sander et al. 2007): triangle order for the post-transform vertex cache
+    //   3. optional: split that order into clusters and draw outward-facing clusters first,
+    //      so nearer surfaces tend to fill the depth buffer before the ones they hide
+    //   4. renumber vertices in first-use order for vertex fetch locality
+    // Meshes of Meshlets::minTriangles or more are split into meshlets after step 1; steps
+    // 2 and 3 then run per meshlet and on whole meshlets, so the meshlet ranges survive.
+    // The result (meshlets included) can be stored next to the source file
+    // (<file>.meshcache) and is reused while the source's size and modification time
+    // are unchanged.
+    class MeshOptimizer
+    {
+    public:
+        // FIFO size used by Tipsify and by the ACMR / ATVR reports
+        static const int CACHE_SIZE = 16;
+
+        static bool optimizeOnLoad;     // ModelLoader::LoadMesh runs Optimize (and the cache)
+        static bool reorderForOverdraw; // step 3
+        static bool useMeshCache;
+        // A cluster may end once its own ACMR is within this factor of the whole run's
+        static float overdrawThreshold;
+
+        static MeshOptimizeReport lastReport; // of the last mesh loaded (editor display)
+
+        // meshlets: empty unless the mesh is large enough to be split (pass them on to Mesh)
+        static MeshOptimizeReport Optimize(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                                           std::vector<Meshlet> &meshlets);
+        // Tipsify inside each meshlet's index range (Mesh runs it after Meshlets::Build)
+        static void OptimizeMeshlets(std::vector<unsigned int> &indices, size_t vertexCount,
+                                     const std::vector<Meshlet> &meshlets);
+
+        static VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                                   int cacheSize = CACHE_SIZE);
+
+        static std::string CachePath(const std::string &sourcePath);
+        // False when there is no cache, it is stale, or it was built with other options
+        static bool LoadCache(const std::string &sourcePath, std::vector<Vertex> &vertices,
+                              std::vector<unsigned int> &indices, std::vector<Meshlet> &meshlets,
+                              MeshOptimizeReport &report);
+        static bool SaveCache(const std::string &sourcePath, const std::vector<Vertex> &vertices,
+                              const std::vector<unsigned int> &indices, const std::vector<Meshlet> &meshlets,
+                              const MeshOptimizeReport &report);
+    };
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include "Common.h"
+#include <cfloat>
+#include <cstddef>
+#include <vector>
+
+class Mesh;
+
+namespace PartC
+{
+    struct SimplifyOptions
+    {
+        size_t targetTriangles = 0;
+        // Skip collapses whose geometric error (fraction of the mesh extent, without the
+        // normal / UV penalty) exceeds this; SimplifyResult::relativeError stays below it
+        float maxError = FLT_MAX;
+        // Attribute error relative to position error; both 0 skips the attribute quadrics
+        float normalWeight = 0.5f;
+        float uvWeight = 1.0f;
+        // Keep vertices that share a position but differ in normal / UV apart (UV seams,
+        // hard edges). false welds by position only and takes attributes from one of them.
+        bool preserveSeams = true;
+    };
+
+    struct SimplifyResult
+    {
+        Mesh *mesh = nullptr; // caller owns it; null when nothing could be removed
+        // SimplifyGeometry only: the simplified arrays (empty when nothing could be removed)
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        size_t trianglesIn = 0, trianglesOut = 0;
+        size_t verticesIn = 0, verticesOut = 0;
+        float error = 0.0f;         // geometric error reached, in mesh units
+        float relativeError = 0.0f; // the same as a fraction of the largest bounding box side
+        int passes = 0;
+        float ms = 0.0f;
+    };
+
+    // MeshSimplifier: 二次误差度量 (QEM) 网格简化，保留法线 / UV
+    // Edge collapses onto an existing vertex, so surviving vertices keep their exact
+    // attributes; the cost adds an attribute quadric (Hoppe 1999) that penalises how much
+    // the interpolated normals and UVs of the surrounding faces would change.
+    //   - open borders and attribute seams only collapse along themselves, both sides of
+    //     a seam at once, so the mesh neither shrinks at its borders nor cracks at seams
+    //   - collapses run in passes: every edge is costed in parallel on the ThreadPool, then
+    //     an independent set is picked cheapest first, which scales to multi-million scans
+    class MeshSimplifier
+    {
+    public:
+        static SimplifyResult Simplify(const Mesh &mesh, const SimplifyOptions &options);
+        // No Mesh (and so no GL upload) is created: safe on a worker thread
+        static SimplifyResult SimplifyGeometry(const std::vector<Vertex> &vertices,
+                                               const std::vector<unsigned int> &indices,
+                                               const SimplifyOptions &options);
+    };
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include "Common.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace PartC
+{
+    // 一个网格簇：索引缓冲中连续的一段三角形，带包围球与法线锥
+    struct Meshlet
+    {
+        uint32_t indexOffset = 0;
+        uint32_t triangleCount = 0;
+        glm::vec3 center = glm::vec3(0.0f); // bounding sphere, object space
+        float radius = 0.0f;
+        glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f); // average face normal
+        float coneCutoff = 1.0f;                           // sin of the cone's half angle, 1 = no cone
+    };
+
+    // A run of consecutive visible meshlets, in indices
+    struct MeshletRange
+    {
+        uint32_t indexOffset;
+        uint32_t indexCount;
+    };
+
+    struct MeshletStats
+    {
+        int draws = 0; // draws culled per meshlet
+        int tested = 0;
+        int frustumCulled = 0;
+        int coneCulled = 0;
+        int ranges = 0; // draw ranges after merging adjacent visible meshlets
+        long long trianglesTested = 0;
+        long long trianglesDrawn = 0;
+    };
+
+    // Meshlets: 大网格的簇划分与逐簇剔除 (CPU 端，不依赖 GL)
+    // Build grows each meshlet from a seed triangle over shared (position-welded)
+    // vertices, preferring triangles that add no new vertex and then the one nearest
+    // to the meshlet's center, until MAX_VERTICES or MAX_TRIANGLES is reached. The
+    // index buffer is rewritten in meshlet order so every meshlet is one index range.
+    // Cull works in object space: the view-projection * model frustum against the
+    // bounding sphere, and the camera against the normal cone. A meshlet whose cone
+    // faces away is hidden behind the front of a closed mesh; open meshes seen from
+    // behind lose those meshlets, the same as with GL back-face culling.
+    class Meshlets
+    {
+    public:
+        static const int MAX_VERTICES = 64;
+        static const int MAX_TRIANGLES = 124;
+
+        // Meshes with fewer triangles are drawn whole (Mesh skips Build)
+        static size_t minTriangles;
+
+        // Reorders `indices` and returns the meshlets covering them in order
+        static std::vector<Meshlet> Build(const std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+        // Writes the visible index ranges of one draw to `ranges`
+        static void Cull(const std::vector<Meshlet> &meshlets, const glm::mat4 &model, const glm::mat4 &viewProjection,
+                         const glm::vec3 &cameraPos, bool coneCulling, std::vector<MeshletRange> &ranges,
+                         MeshletStats &stats);
+    };
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef OCCLUSION_CULLING_H
+#define OCCLUSION_CULLING_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "Culling.h"
+
+struct SceneObject;
+
+namespace PartC
+{
+    struct OcclusionStats
+    {
+        int occluders = 0;
+        int occluderTriangles = 0;
+        int tested = 0;
+        int culled = 0;
+        float rasterMs = 0.0f;
+
+        float CulledFraction() const { return tested > 0 ? (float)culled / (float)tested : 0.0f; }
+    };
+
+    // OcclusionBuffer: 低分辨率软件深度缓冲 + Hi-Z 金字塔
+    // Depth is NDC z remapped to [0, 1] (1 = far). Large occluders are rasterized
+    // in horizontal bands on the ThreadPool, then every level of the pyramid keeps
+    // the farthest depth of its 2x2 children so a box test is conservative.
+    class OcclusionBuffer
+    {
+    public:
+        static const int DEFAULT_WIDTH = 320;
+        static const int DEFAULT_HEIGHT = 180;
+
+        // Occluder selection: minimum projected screen coverage (0..1) and budgets
+        float minOccluderCoverage = 0.02f;
+        int maxOccluders = 32;
+        int maxOccluderTriangles = 20000;
+
+        OcclusionBuffer(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
+
+        void Resize(int width, int height);
+        int GetWidth() const { return width; }
+        int GetHeight() const { return height; }
+
+        // Clears the buffer, rasterizes `occluders` and rebuilds the Hi-Z pyramid
+        void Render(const std::vector<SceneObject *> &occluders, const glm::mat4 &viewProjection, OcclusionStats &stats);
+
+        // True unless the box is certainly hidden behind rasterized occluders
+        bool IsVisible(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const;
+
+        // Frustum-visible list in, occlusion-visible list out (indices into bounds).
+        // Picks the largest visible objects as occluders, renders them and tests the rest.
+        void Cull(const CullingBounds &bounds, std::vector<uint32_t> &visible,
+                  const glm::mat4 &viewProjection, OcclusionStats &stats);
+
+        // Level 0 depth, row 0 at the bottom of the screen (same as glReadPixels)
+        const std::vector<float> &GetDepth() const { return levels[0]; }
+
+    private:
+        struct ScreenTriangle
+        {
+            glm::vec3 v[3]; // x, y in pixels, z in [0, 1]
+        };
+
+        int width, height;
+        glm::mat4 viewProj;
+        std::vector<std::vector<float>> levels; // Hi-Z pyramid, levels[0] is full resolution
+        std::vector<int> levelWidth, levelHeight;
+        std::vector<ScreenTriangle> triangles;
+
+        void SetupTriangles(const std::vector<SceneObject *> &occluders);
+        void RasterizeBand(int yBegin, int yEnd);
+        void BuildHiZ();
+        float ProjectedCoverage(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const;
+    };
+}
+
+#endif
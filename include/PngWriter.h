@@ -0,0 +1,67 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace PartC
+{
+    enum class PngCompression : int
+    {
+        Fast = 0,   // Up filter, LZ77 with a 4-step hash chain: for bulk capture
+        Default = 1 // per-row adaptive filter, 64-step hash chain
+    };
+
+    // PngWriter: 流式 PNG 编码 (8-bit RGB)，扫描线过滤与 deflate 均并行
+    // Rows are appended from the top in any number of calls and buffered until
+    // about one CHUNK_BYTES per thread is pending; then the rows are filtered in
+    // parallel and the filtered bytes are split into CHUNK_BYTES pieces that are
+    // deflated independently on the ThreadPool. A piece may still reference the
+    // 32 KB before it (the decoder has those bytes), ends on a sync flush (an empty
+    // stored block) so the next piece starts byte-aligned, and goes out as an IDAT
+    // chunk of its own with its CRC computed on the same thread. The zlib Adler-32
+    // of the pieces is combined in order. Only the pending rows and the 32 KB
+    // window are held, so images of any height stream through bounded memory.
+    // The deflate encoder is self-contained: greedy LZ77 over a hash chain and one
+    // dynamic Huffman block per 16K symbols.
+    class PngWriter
+    {
+    public:
+        // Editor setting, UI thread only: captures copy it when they are queued
+        static PngCompression compression;
+        static const size_t CHUNK_BYTES = 256 * 1024;
+
+        PngWriter() = default;
+        PngWriter(const PngWriter &) = delete;
+        PngWriter &operator=(const PngWriter &) = delete;
+
+        bool Open(const std::string &path, int width, int height, PngCompression level);
+        // channels 3 or 4 (alpha dropped); stride in bytes, negative for bottom-up buffers
+        bool AppendRows(const uint8_t *firstRow, int count, int channels, ptrdiff_t stride);
+        // All `height` rows must have been appended
+        bool Finish();
+
+        size_t BytesWritten() const { return written; }
+
+    private:
+        std::ofstream file;
+        int width = 0, height = 0;
+        int rows = 0;
+        PngCompression level = PngCompression::Default;
+        std::vector<uint8_t> pending;     // raw RGB rows not compressed yet
+        int pendingRows = 0;
+        std::vector<uint8_t> previousRow; // raw RGB row above the first pending one
+        std::vector<uint8_t> window;      // last 32 KB of filtered data already compressed
+        uint32_t adler = 1;
+        bool started = false; // zlib header written
+        size_t written = 0;
+
+        void WriteChunk(const char *type, const uint8_t *data, size_t size);
+        bool Flush(bool final);
+    };
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef RAY_QUERY_H
+#define RAY_QUERY_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cfloat>
+
+class Mesh;
+class SceneContext;
+struct SceneObject;
+
+// 射线：direction 不要求归一化，命中距离 t 以 direction 的长度为单位
+struct Ray
+{
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    float tMin = 0.0f;
+    float tMax = FLT_MAX;
+};
+
+struct RayHit
+{
+    float t = FLT_MAX;
+    int objectIndex = -1;   // index into SceneContext::objects, -1 means miss
+    int triangleIndex = -1; // triangle index inside the object's mesh
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 normal = glm::vec3(0.0f);
+
+    bool IsHit() const { return objectIndex >= 0; }
+};
+
+// Flattened BVH node. Inner nodes store the left child index (right = left + 1),
+// leaves store the first primitive in the reordered primitive list.
+struct BVHNode
+{
+    glm::vec3 boundsMin;
+    uint32_t leftFirst;
+    glm::vec3 boundsMax;
+    uint32_t count; // 0 for inner nodes
+};
+
+// Triangle BVH in mesh local space, cached on the Mesh (Mesh::bvh)
+struct MeshBVH
+{
+    std::vector<BVHNode> nodes;
+    std::vector<uint32_t> triangles; // triangle ids ordered by leaf
+};
+
+// SceneBVH: 两级加速结构
+// Top level over object world AABBs, bottom level is the per-mesh triangle BVH.
+// Rays are traced in packets of 4 and the packets are spread over the ThreadPool.
+class SceneBVH
+{
+public:
+    // Rebuild the top level from the current object transforms.
+    // Missing mesh BVHs are built here, so call it from the main thread.
+    void Build(const SceneContext &scene);
+
+    // Trace `count` rays and write one RayHit per ray into `hits`.
+    // Returns the number of rays that hit something.
+    size_t Trace(const Ray *rays, RayHit *hits, size_t count) const;
+
+    // Builds (or returns the cached) triangle BVH of a mesh
+    static const MeshBVH &GetMeshBVH(Mesh *mesh);
+
+    size_t GetInstanceCount() const { return instances.size(); }
+
+private:
+    struct Instance
+    {
+        const Mesh *mesh;
+        const MeshBVH *bvh;
+        int objectIndex;
+        glm::mat4 invModel;
+        glm::mat3 normalMatrix;
+    };
+
+    std::vector<Instance> instances;
+    std::vector<BVHNode> nodes;
+    std::vector<uint32_t> order; // instance ids ordered by leaf
+
+    void TracePacket(const Ray *rays, RayHit *hits, int laneCount) const;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+class Mesh;
+class Shader;
+
+namespace PartC
+{
+    // 一条绘制命令：提交时计算 64 位排序键，执行时由 Renderer::ExecuteQueue 设置状态并绘制
+    struct DrawCommand
+    {
+        uint64_t key = 0;
+        uint8_t pass = 0;
+        Shader *shader = nullptr;
+        Mesh *mesh = nullptr;
+        glm::mat4 model = glm::mat4(1.0f);
+        glm::vec3 albedo = glm::vec3(1.0f);
+        float roughness = 0.5f;
+        float metallic = 0.0f;
+        bool wireframe = false;
+        // [Meshlet] 执行时逐簇剔除 (主 Pass；阴影与描边画整个网格)
+        bool clusterCull = false;
+    };
+
+    // GL 状态切换次数（按执行顺序模拟统计）
+    struct StateChangeCounts
+    {
+        int shaders = 0;
+        int meshes = 0;         // VAO binds
+        int textures = 0;       // texture set binds
+        int textureToggles = 0; // useTexture flips
+        int polygonModes = 0;
+
+        int Total() const { return shaders + meshes + textures + textureToggles + polygonModes; }
+    };
+
+    struct RenderQueueStats
+    {
+        int commands = 0;
+        StateChangeCounts unsorted; // submission order
+        StateChangeCounts sorted;   // order actually executed
+        float sortMs = 0.0f;
+    };
+
+    // RenderQueue: 收集一帧的绘制命令，按排序键做 LSD 基数排序
+    // Key layout, most significant first:
+    //   pass (4) | shader (8) | texture set (16) | depth (20) | mesh (16)
+    // Shader, mesh and texture ids are compacted per frame, depth is front-to-back.
+    // Most objects own their mesh, so a mesh id above depth would give every command
+    // a group of its own; below depth it only joins draws of a shared mesh at equal
+    // depth (the shadow pass submits everything at depth 0).
+    class RenderQueue
+    {
+    public:
+        enum Pass : uint8_t
+        {
+            PASS_SHADOW = 0,
+            PASS_OPAQUE = 1,
+            PASS_HIGHLIGHT = 2
+        };
+
+        // depth01: normalized view distance, 0 = nearest
+        void Submit(const DrawCommand &command, float depth01);
+        void Clear();
+
+        // Sorts by key; with sorting disabled the submission order is kept
+        void Sort(bool enabled, RenderQueueStats &stats);
+
+        size_t Size() const { return commands.size(); }
+        const DrawCommand &Get(size_t i) const { return commands[order[i]]; }
+
+        // State changes needed to execute the commands in submission or sorted order
+        StateChangeCounts CountStateChanges(bool sortedOrder) const;
+
+        // Two meshes can share bound textures if their texture lists are identical
+        static bool SameTextureSet(const Mesh *a, const Mesh *b);
+
+    private:
+        std::vector<DrawCommand> commands;
+        std::vector<uint32_t> order;
+        // Radix sort buffers, kept between frames to avoid reallocation
+        std::vector<uint64_t> sortKeys, keyScratch;
+        std::vector<uint32_t> orderScratch;
+
+        std::unordered_map<const void *, uint32_t> shaderIds;
+        std::unordered_map<const void *, uint32_t> meshIds;
+        std::unordered_map<unsigned int, uint32_t> textureIds;
+
+        static uint32_t CompactId(std::unordered_map<const void *, uint32_t> &ids, const void *ptr, uint32_t maxId);
+        static void RadixSort(std::vector<uint64_t> &keys, std::vector<uint32_t> &values,
+                              std::vector<uint64_t> &keyScratch, std::vector<uint32_t> &valueScratch);
+    };
+}
+
+#endif
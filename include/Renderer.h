@@ -3,6 +3,11 @@
 
 #include "Mesh.h"
 #include "Shader.h"
+#include "Culling.h"
+#include "OcclusionCulling.h"
+#include "RenderQueue.h"
+#include "MeshLOD.h"
+#include "Meshlets.h"
 #include <glm/glm.hpp>
 
 namespace PartC
@@ -23,28 +28,162 @@ namespace PartC
         glm::vec3 specular = glm::vec3(1.0f); // Not used in PBR shader but kept for compatibility
     };
 
+    // [UBO] std140 布局，与着色器中的 CameraBlock / LightBlock 一一对应 (vec3 按 vec4 对齐)
+    struct CameraUniformData
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec4 viewPos; // xyz
+    };
+
+    // [CSM] 级联阴影：每级一个光空间矩阵，cascadeSplits 为各级的视空间远距离
+    static const int CASCADE_COUNT = 4;
+
+    struct LightUniformData
+    {
+        glm::mat4 lightSpaceMatrices[CASCADE_COUNT];
+        glm::vec4 cascadeSplits; // view-space far distance of each cascade
+        glm::vec4 cascadeBias;   // depth bias of one shadow texel, per cascade
+        glm::vec4 direction;     // xyz
+        glm::vec4 ambient;
+        glm::vec4 diffuse;
+        glm::vec4 specular;
+    };
+
+    // 一级级联：拟合到 [nearDistance, farDistance] 这段视锥的光空间正交矩阵
+    struct ShadowCascade
+    {
+        glm::mat4 lightSpaceMatrix = glm::mat4(1.0f);
+        float nearDistance = 0.0f;
+        float farDistance = 0.0f;
+        float texelSize = 0.0f; // world units per shadow texel
+        float depthRange = 1.0f;
+    };
+
+    // [Shadow Cache] 一级级联的静态阴影缓存：签名覆盖光空间矩阵与该级联内所有静态投射体的变换
+    struct ShadowCacheEntry
+    {
+        uint64_t signature = 0;
+        bool valid = false;
+    };
+
+    struct ShadowCacheStats
+    {
+        int rebuilds = 0;      // cascades whose static layer was redrawn this frame
+        int staticDraws = 0;   // static casters drawn (only when rebuilding)
+        int staticSkipped = 0; // static casters served from the cache
+        int dynamicDraws = 0;
+    };
+
+    // [新增] 每帧渲染统计 (显示在编辑器 Render Stats 面板)
+    struct RenderStats
+    {
+        CullStats mainCull;
+        CullStats shadowCull;             // summed over cascades
+        int cascadeCasters[CASCADE_COUNT] = {0};
+        ShadowCacheStats shadowCache;
+        LodStats lod;
+        OcclusionStats occlusion;
+        RenderQueueStats queue; // shadow + main pass
+        MeshletStats meshlets;
+    };
+
     class Renderer
     {
     public:
         // [新增] 全局光照设置实例
         static LightSettings mainLight;
 
-        // [Shadow Mapping]
+        // [Headless] 无 GL 上下文：Mesh/Texture 只保留 CPU 数据，渲染走 SoftwareRasterizer
+        static bool headless;
+
+        // [Culling] 视锥剔除开关与统计
+        static bool enableFrustumCulling;
+        static bool enableOcclusionCulling;
+        // [RenderQueue] 关闭时按提交顺序执行，用于对比状态切换次数
+        static bool enableDrawSorting;
+        // [LOD] 按屏幕尺寸选择细节层次 (MeshLOD)
+        static bool enableLod;
+        // [Meshlet] 大网格逐簇视锥 / 法线锥剔除，可见簇合并为区间绘制
+        static bool enableMeshletCulling;
+        static bool enableConeCulling;
+        static RenderStats stats;
+        static void ResetStats();
+
+        // [Shadow Mapping] 级联阴影：shadowMap 是 CASCADE_COUNT 层的深度纹理数组
         static unsigned int shadowMapFBO;
         static unsigned int shadowMap;
-        static const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
+        static const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024; // per cascade
         static Shader *depthShader;
-        static glm::mat4 lightSpaceMatrix;
+        static UniformHandle depthCascadeIndex;
+        static ShadowCascade cascades[CASCADE_COUNT];
+        // Shadows end at this view distance (clamped to the camera far plane)
+        static float shadowDistance;
+        // 0 = uniform splits, 1 = logarithmic splits
+        static float cascadeSplitLambda;
+
+        // [Shadow Cache] 静态投射体深度单独保存在 staticShadowMap，每帧拷贝后只画动态投射体
+        static bool enableShadowCache;
+        static unsigned int staticShadowMapFBO;
+        static unsigned int staticShadowMap;
+        static ShadowCacheEntry shadowCache[CASCADE_COUNT];
+        // Cached cascades move in steps of this many texels, so the light matrix (and
+        // with it the cache) only changes after the camera has moved that far
+        static const int SHADOW_CACHE_SNAP_TEXELS = 64;
+
+        // [UBO] 相机/光照 uniform buffer，绑定到 Shader::CAMERA_BLOCK_BINDING / LIGHT_BLOCK_BINDING
+        static unsigned int cameraUBO;
+        static unsigned int lightUBO;
+        // Camera of the current frame, kept for per-meshlet culling in ExecuteQueue
+        static glm::mat4 frameViewProjection;
+        static glm::vec3 frameCameraPos;
 
         static void InitShadowMap();
-        static void BeginShadowMap();
+        static void InitUniformBuffers();
+
+        // near/far of a glm::perspective projection
+        static void ExtractClipPlanes(const glm::mat4 &projection, float &nearPlane, float &farPlane);
+
+        // 方向光正交矩阵，包围视锥中 [nearDistance, farDistance] 这一段 (GPU 与软件渲染共用)
+        // The slice is enclosed in a sphere so the map size does not change as the camera
+        // turns, and the origin is snapped to whole texels so shadow edges do not shimmer.
+        // The depth range is extended towards the light to include every caster in `casters`.
+        // stable: snap the slice center to SHADOW_CACHE_SNAP_TEXELS steps (with a matching
+        // margin) and fit depth to static casters only; dynamic casters in front of the
+        // near plane rely on GL_DEPTH_CLAMP in the shadow pass.
+        static ShadowCascade FitShadowCascade(const glm::mat4 &view, const glm::mat4 &projection, float nearDistance,
+                                              float farDistance, const CullingBounds &casters, int resolution,
+                                              bool stable = false);
+
+        // 每帧调用一次（在阴影 Pass 之前）：拟合级联并上传相机与光照 UBO
+        static void UpdateFrameUniforms(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &camPos,
+                                        const CullingBounds &casters);
+        // [Tiled] cascadeProjection: frustum the cascades are fitted to; a tile of a larger
+        // image passes the whole image's, so every tile samples the same shadow maps
+        static void UpdateFrameUniforms(const glm::mat4 &view, const glm::mat4 &projection,
+                                        const glm::mat4 &cascadeProjection, const glm::vec3 &camPos,
+                                        const CullingBounds &casters);
+        static void BeginShadowMap(int cascade);
         static void EndShadowMap(int scrWidth, int scrHeight);
 
+        // [Shadow Cache] casters: indices into `bounds` of static casters inside the cascade,
+        // meshes: the mesh (LOD level) drawn for each object in `bounds`
+        static uint64_t ShadowCacheSignature(int cascade, const CullingBounds &bounds, const std::vector<uint32_t> &casters,
+                                             const std::vector<Mesh *> &meshes);
+        static void BeginStaticShadowMap(int cascade);
+        // Copies the cached static layer into the shadow map layer and leaves it bound for dynamic casters
+        static void BeginShadowMapFromCache(int cascade);
+        static void InvalidateShadowCache();
+
         // [接口] 统一渲染入口
         static void RenderMesh(Mesh *mesh, Shader &shader, const glm::mat4 &modelMatrix);
 
-        // [接口] 设置光照参数
-        static void SetupLights(Shader &shader, const glm::vec3 &camPos);
+        // [RenderQueue] 按排序后的顺序执行绘制命令，跳过冗余的程序/VAO/纹理/多边形模式切换
+        // Commands with clusterCull test each meshlet against the frame's camera (UpdateFrameUniforms)
+        static void ExecuteQueue(const RenderQueue &queue);
+
+        // [接口] 绑定阴影贴图（光照参数本身由 LightBlock UBO 提供）
+        static void SetupLights(Shader &shader);
     };
 }
 
@@ -3,11 +3,15 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include <algorithm>
+#include <cmath>
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include "Mesh.h"
 #include "Shader.h"
 #include "Component.h"
+#include "RayQuery.h"
 
 // 几何体类型枚举
 enum class GeometryType {
@@ -27,7 +31,8 @@ class Camera;
 struct SceneObject
 {
     std::string name;
-    Mesh *mesh;
+    // 网格由物体共同持有：Clone (运行模式的场景备份) 与原物体共用，最后一个持有者释放时删除
+    std::shared_ptr<Mesh> mesh;
     glm::vec3 position;
     glm::vec3 rotation;
     glm::vec3 scale;
@@ -46,7 +51,7 @@ struct SceneObject
 
     // 动画相关
     bool isAnimated = false;
-    std::vector<Mesh*> animationFrames;
+    std::vector<std::shared_ptr<Mesh>> animationFrames;
     int currentFrame = 0;
     float animationSpeed = 1.0f;
     bool isPlaying = false;
@@ -59,6 +64,12 @@ struct SceneObject
     float roughness = 0.5f;
     float metallic = 0.0f;
 
+    // [Shadow Cache] 静态物体的阴影缓存在 Renderer 中，移动后按级联重建
+    bool isStatic = false;
+
+    // [LOD] 当前细节层次（带滞后的选择状态，见 MeshLOD::Select）
+    int lodLevel = 0;
+
     // [新增] 模型路径，用于保存/加载
     std::string meshPath;
 
@@ -68,7 +79,14 @@ struct SceneObject
     // Context reference
     class SceneContext *sceneContext = nullptr;
 
+    // [Culling] 世界空间 AABB 缓存，变换或网格改变时才重新计算
+    glm::vec3 worldBoundsMin = glm::vec3(0.0f);
+    glm::vec3 worldBoundsMax = glm::vec3(0.0f);
+
+    // Takes ownership of a newly created mesh
     SceneObject(std::string n, Mesh *m)
+        : SceneObject(n, std::shared_ptr<Mesh>(m)) {}
+    SceneObject(std::string n, std::shared_ptr<Mesh> m)
         : name(n), mesh(m), position(0.0f), rotation(0.0f), scale(1.0f), color(1.0f), texturePath(""), meshPath("") {}
 
     SceneObject *Clone()
@@ -80,6 +98,7 @@ struct SceneObject
         newObj->color = color;
         newObj->roughness = roughness;
         newObj->metallic = metallic;
+        newObj->isStatic = isStatic;
         newObj->texturePath = texturePath;
         newObj->textureId = textureId;
         newObj->meshPath = meshPath;
@@ -106,6 +125,50 @@ struct SceneObject
         return newObj;
     }
 
+    // 计算 Model 矩阵 (T * Rx * Ry * Rz * S)，与渲染路径保持一致
+    glm::mat4 GetModelMatrix() const
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, position);
+        model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+        model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+        model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::scale(model, scale);
+        return model;
+    }
+
+    // 返回缓存的世界空间 AABB (Arvo: |M| * extent)
+    void GetWorldBounds(glm::vec3 &outMin, glm::vec3 &outMax)
+    {
+        if (!boundsValid || mesh.get() != boundsMesh || position != boundsPosition ||
+            rotation != boundsRotation || scale != boundsScale)
+        {
+            glm::vec3 localMin = mesh ? mesh->boundsMin : glm::vec3(0.0f);
+            glm::vec3 localMax = mesh ? mesh->boundsMax : glm::vec3(0.0f);
+            glm::mat4 model = GetModelMatrix();
+
+            glm::vec3 center = glm::vec3(model * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+            glm::vec3 extent = (localMax - localMin) * 0.5f;
+            glm::vec3 worldExtent;
+            for (int row = 0; row < 3; row++)
+            {
+                worldExtent[row] = std::abs(model[0][row]) * extent.x +
+                                   std::abs(model[1][row]) * extent.y +
+                                   std::abs(model[2][row]) * extent.z;
+            }
+            worldBoundsMin = center - worldExtent;
+            worldBoundsMax = center + worldExtent;
+
+            boundsMesh = mesh.get();
+            boundsPosition = position;
+            boundsRotation = rotation;
+            boundsScale = scale;
+            boundsValid = true;
+        }
+        outMin = worldBoundsMin;
+        outMax = worldBoundsMax;
+    }
+
     ~SceneObject()
     {
         for (auto c : components)
@@ -178,6 +241,12 @@ struct SceneObject
             components.erase(it);
         }
     }
+
+private:
+    // GetWorldBounds 缓存键
+    bool boundsValid = false;
+    Mesh *boundsMesh = nullptr;
+    glm::vec3 boundsPosition, boundsRotation, boundsScale;
 };
 
 class SceneContext
@@ -206,8 +275,16 @@ public:
     void DrawAll(Shader &shader);
     void DrawGizmos(Shader &shader);
 
+    // 批量射线查询：对 count 条射线求最近交点，结果写入调用方提供的 hits 缓冲区
+    // Rebuilds the top-level BVH from current transforms, then traces on the ThreadPool.
+    // Returns the number of rays that hit. Call from the main thread.
+    size_t RaycastBatch(const Ray *rays, RayHit *hits, size_t count);
+
     void SaveScene(const std::string &filename);
     void LoadScene(const std::string &filename);
+
+private:
+    SceneBVH rayBVH;
 };
 
 #endif
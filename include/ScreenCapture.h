@@ -0,0 +1,119 @@
+#ifndef SCREEN_CAPTURE_H
+#define SCREEN_CAPTURE_H
+
+#include "ImageWriter.h"
+#include <glad/glad.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace PartC
+{
+    struct CaptureStats
+    {
+        int requested = 0; // waiting for a free pixel buffer
+        int readbacks = 0; // in a pixel buffer, GPU copy not finished
+        int encoding = 0;  // handed to the encoder
+        int written = 0;
+        int failed = 0;
+        bool recording = false;
+        int recordedFrames = 0; // simulated frames since StartRecording
+        int dropped = 0;        // recorded frames skipped while the encoder was behind
+        float stalledMs = 0.0f; // GL thread time spent waiting on back-pressure while recording
+        float lastMapMs = 0.0f;    // GL thread: map + copy of the last readback
+        float lastEncodeMs = 0.0f; // worker: last file written
+    };
+
+    // ScreenCapture: 双缓冲 PBO 异步截图，后台线程编码写盘
+    // EndFrame, called after the scene and before the UI, issues glReadPixels into
+    // one of PBO_COUNT pixel buffers with a fence and returns at once. The buffer
+    // is mapped on a later frame, once its fence has signalled (a frame later in
+    // practice), copied out and handed to an ImageWriter job on the ThreadPool's
+    // background queue, so neither the GPU copy nor encoding and disk I/O stall the
+    // frame. Requests wait while every buffer is in flight.
+    // Recording captures every frame as <prefix>000000.<ext>, ... while the caller
+    // steps the simulation by FixedDeltaTime(), so the sequence plays back at
+    // frameRate whatever the wall-clock cost of a frame. At most maxPendingEncodes
+    // frames are held by the encoder; past that, blockWhenBehind stalls the GL
+    // thread until a worker finishes one (no frame lost: simulated time waits too),
+    // otherwise the frame is skipped and counted as dropped, leaving a gap in the
+    // numbering.
+    class ScreenCapture
+    {
+    public:
+        static const int PBO_COUNT = 2;
+        static int maxPendingEncodes;
+
+        int frameRate = 30;
+        bool blockWhenBehind = true;
+
+        ScreenCapture();
+        ~ScreenCapture();
+
+        // Any time: the next EndFrame captures the frame. pngLevel is kept with the
+        // request; the encoder job never reads PngWriter::compression.
+        void Request(const std::string &path, ImageFormat format, PngCompression pngLevel);
+        // Any time: the next EndFrame is frame 0; frames already captured are still written
+        void StartRecording(const std::string &prefix, ImageFormat format, PngCompression pngLevel);
+        void StopRecording();
+        bool IsRecording() const { return recording; }
+        float FixedDeltaTime() const { return 1.0f / (float)(frameRate > 0 ? frameRate : 30); }
+        // GL thread, once per frame after the scene has been drawn to the back buffer
+        void EndFrame(int width, int height);
+        // GL thread, before the context is destroyed: finishes the readbacks in
+        // flight and waits for the encoder; pending requests are dropped
+        void Shutdown();
+
+        CaptureStats Stats() const;
+
+    private:
+        struct CaptureRequest
+        {
+            std::string path;
+            ImageFormat format = ImageFormat::BMP;
+            PngCompression pngLevel = PngCompression::Default;
+        };
+
+        struct Readback
+        {
+            unsigned int pbo = 0;
+            size_t size = 0; // allocated bytes
+            GLsync fence = nullptr;
+            CaptureRequest request;
+            int width = 0, height = 0;
+        };
+
+        // Shared with encoder jobs, which may outlive a frame
+        struct EncoderState
+        {
+            std::mutex mutex;
+            std::condition_variable done;
+            int pending = 0;
+            int written = 0, failed = 0;
+            float lastEncodeMs = 0.0f;
+        };
+
+        std::deque<CaptureRequest> requests;
+        Readback slots[PBO_COUNT];
+        int nextSlot = 0;
+        bool recording = false;
+        std::string recordPrefix;
+        ImageFormat recordFormat = ImageFormat::BMP;
+        PngCompression recordPngLevel = PngCompression::Default;
+        int recordFrame = 0;
+        int dropped = 0;
+        float stalledMs = 0.0f;
+        float lastMapMs = 0.0f;
+        std::shared_ptr<EncoderState> encoder;
+
+        bool StartReadback(const CaptureRequest &request, int width, int height);
+        void RecordFrame(int width, int height);
+        // Hands finished readbacks to the encoder; wait: block on their fences
+        void Collect(bool wait);
+        int PendingEncodes() const;
+    };
+}
+
+#endif
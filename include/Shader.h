@@ -7,18 +7,65 @@
 #include <sstream>
 #include <iostream>
 #include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+// [新增] 预解析的 uniform 句柄：链接时查询一次位置，之后直接按位置上传
+struct UniformHandle
+{
+    int location = -1;
+    bool IsValid() const { return location >= 0; }
+};
+
+// 引擎内置 uniform，链接后自动解析，供每个物体都会调用的热路径使用
+struct StandardUniforms
+{
+    UniformHandle model;
+    UniformHandle normalMatrix;
+    UniformHandle albedo;
+    UniformHandle metallic;
+    UniformHandle roughness;
+    UniformHandle useTexture;
+    UniformHandle materialDiffuse;
+    UniformHandle materialSpecular;
+    UniformHandle atlasLayer; // [Atlas] -1: material.diffuse is a texture of its own
+    UniformHandle atlasRect;
+    UniformHandle virtualTexture; // [VT] 1: material.diffuse is streamed through a VirtualTexture
+    UniformHandle vtSize;
+    UniformHandle vtSlots;
+};
+
+// 每帧 uniform 上传统计 (由 Renderer::ResetStats 清零)
+struct UniformStats
+{
+    int uploads = 0;     // glUniform* calls actually issued
+    int skipped = 0;     // value unchanged since the last upload, call skipped
+    int nameLookups = 0; // setters called by name instead of by handle
+};
 
 class Shader
 {
 public:
     unsigned int ID;
 
+    // 链接后解析的内置 uniform 句柄
+    StandardUniforms standard;
+
+    static UniformStats stats;
+
+    // [UBO] uniform block 绑定点，链接时对每个程序自动设置 (GLSL 330 不支持 layout(binding))
+    static const unsigned int CAMERA_BLOCK_BINDING = 0;
+    static const unsigned int LIGHT_BLOCK_BINDING = 1;
+
     // 构造函数读取并构建着色器
     Shader(const char *vertexPath, const char *fragmentPath);
 
     // 使用/激活程序
     void use();
 
+    // 按名字获取句柄（只查表，不调用 glGetUniformLocation）
+    UniformHandle getUniform(const std::string &name) const;
+
     // uniform工具函数
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
@@ -26,9 +73,35 @@ public:
     void setMat3(const std::string &name, const glm::mat3 &mat) const;
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
     void setVec3(const std::string &name, const glm::vec3 &value) const;
+    void setVec4(const std::string &name, const glm::vec4 &value) const;
+
+    // 句柄版本：值未变化时跳过上传
+    void setBool(UniformHandle handle, bool value) const;
+    void setInt(UniformHandle handle, int value) const;
+    void setFloat(UniformHandle handle, float value) const;
+    void setMat3(UniformHandle handle, const glm::mat3 &mat) const;
+    void setMat4(UniformHandle handle, const glm::mat4 &mat) const;
+    void setVec3(UniformHandle handle, const glm::vec3 &value) const;
+    void setVec4(UniformHandle handle, const glm::vec4 &value) const;
 
 private:
+    // Last value uploaded to each location. Uniforms are program state, so the
+    // cache stays valid across glUseProgram switches.
+    struct CachedValue
+    {
+        float data[16];
+        bool valid = false;
+    };
+
+    mutable std::unordered_map<std::string, int> uniformLocations;
+    mutable std::vector<CachedValue> uniformCache;
+
     void checkCompileErrors(unsigned int shader, std::string type);
+    void cacheUniformLocations();
+    void bindUniformBlocks();
+    UniformHandle lookup(const std::string &name) const;
+    // Returns false if the location is invalid or already holds the value
+    bool updateCache(int location, const void *value, size_t size) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,169 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include "Culling.h"
+#include "OcclusionCulling.h"
+#include "Renderer.h"
+
+struct SceneObject;
+struct TextureImage;
+class Mesh;
+
+namespace PartC
+{
+    struct SoftwareFrameStats
+    {
+        int objects = 0;             // objects drawn in the main pass
+        int shadowCasters = 0;       // objects drawn into the shadow map
+        int triangles = 0;           // triangles submitted (both passes)
+        int trianglesRasterized = 0; // after near-plane clipping and bounds rejection
+        long long pixelsShaded = 0;
+        LodStats lod;
+        MeshletStats meshlets; // main pass
+        OcclusionStats occlusion; // main pass
+        float shadowMs = 0.0f;
+        float mainMs = 0.0f;
+        float totalMs = 0.0f;
+    };
+
+    // SoftwareRasterizer: 无 GPU 时的 CPU 渲染后端 (headless / CI)
+    // Consumes the same Vertex layout as Mesh and approximates vertex.glsl +
+    // fragment.glsl: Cook-Torrance PBR for the directional light, 3x3 PCF shadow
+    // map fitted by Renderer::FitShadowCascade (a single cascade), Reinhard + gamma.
+    // Clip space, depth range and texture orientation follow OpenGL conventions.
+    //
+    // Every pass runs in three parallel stages on the ThreadPool:
+    //   1. vertex transform, in chunks of vertices
+    //   2. clip + triangle setup + binning into TILE_SIZE screen tiles, in
+    //      batches of triangles (each batch keeps its own bins, so no locking)
+    //   3. per tile: walk the bins in batch order, rasterize with SSE edge
+    //      functions (4 pixels per step), depth test and shade
+    // Batch order equals submission order, so the output is deterministic.
+    // In the main pass, meshes with meshlets only submit the ranges that survive
+    // Meshlets::Cull (Renderer::enableMeshletCulling / enableConeCulling), and the
+    // frustum-visible objects go through an OcclusionBuffer first, as on the GPU
+    // path (Renderer::enableOcclusionCulling).
+    class SoftwareRasterizer
+    {
+    public:
+        static const int SHADOW_SIZE = 1024;
+        static const int TILE_SIZE = 64;
+
+        glm::vec3 clearColor = glm::vec3(0.12f, 0.12f, 0.12f);
+
+        SoftwareRasterizer(int width, int height);
+
+        void Resize(int width, int height);
+        int GetWidth() const { return width; }
+        int GetHeight() const { return height; }
+
+        // Shadow pass + main pass for the given objects, lit by Renderer::mainLight
+        void Render(const std::vector<SceneObject *> &objects, const glm::mat4 &view, const glm::mat4 &projection,
+                    const glm::vec3 &camPos, SoftwareFrameStats &stats);
+
+        // RGB8, row 0 at the bottom (same layout as glReadPixels)
+        const std::vector<unsigned char> &GetColorBuffer() const { return color; }
+
+    private:
+        struct ClipVertex
+        {
+            glm::vec4 clip;
+            glm::vec3 worldPos;
+            glm::vec3 normal;
+            glm::vec2 uv;
+        };
+
+        struct Material
+        {
+            glm::vec3 albedo;
+            float roughness;
+            float metallic;
+            const TextureImage *diffuse; // null when untextured
+        };
+
+        // Render target for one pass; color is null for depth-only passes.
+        // Depth rows are `stride` floats apart (a multiple of 4) so SIMD stores never
+        // touch a pixel owned by another tile.
+        struct Target
+        {
+            int width;
+            int height;
+            int stride;
+            float *depth;
+            unsigned char *color;
+        };
+
+        struct DrawItem
+        {
+            const SceneObject *object;
+            const Mesh *mesh; // LOD level actually drawn
+            glm::mat4 model;
+            glm::mat4 mvp;
+            glm::mat3 normalMatrix;
+            Material material;
+            size_t firstVertex; // into `vertices`
+        };
+
+        // Screen-space triangle: edge functions and depth are planes in pixel
+        // coordinates, pre-divided by the signed area so they evaluate to barycentrics
+        struct TriangleSetup
+        {
+            float edgeA[3], edgeB[3], edgeC[3];
+            float zA, zB, zC;
+            float invW[3];
+            const ClipVertex *v[3];
+            uint32_t draw;
+            int minX, minY, maxX, maxY;
+        };
+
+        // A contiguous range of one draw's triangles, set up and binned by one job
+        struct Batch
+        {
+            uint32_t draw;
+            size_t triBegin, triEnd;
+            int submitted;
+            int rasterized;
+            std::vector<TriangleSetup> triangles;
+            std::deque<ClipVertex> clipped;    // vertices created by near-plane clipping (stable addresses)
+            std::vector<uint32_t> tileOffsets; // CSR bins: tiles + 1 offsets into tileTriangles
+            std::vector<uint32_t> tileTriangles;
+        };
+
+        int width, height, stride;
+        std::vector<unsigned char> color;
+        std::vector<float> depth;
+        std::vector<float> shadowDepth;
+
+        glm::mat4 lightSpace;
+        float shadowBias = 0.0f; // depth of one shadow texel
+        glm::vec3 cameraPos;
+        LightSettings light;
+
+        CullingBounds bounds;
+        std::vector<uint32_t> visible;
+        OcclusionBuffer occlusionBuffer;
+        std::vector<Mesh *> lodMeshes; // per bounds entry
+        std::vector<DrawItem> draws;
+        std::vector<ClipVertex> vertices;
+        std::vector<Batch> batches; // grows only, so bin storage is reused between frames
+        std::vector<MeshletRange> ranges;
+        size_t activeBatches = 0;
+        std::vector<long long> tilePixels;
+
+        void RenderPass(const glm::mat4 &viewProj, const Target &target, bool clusterCull, SoftwareFrameStats &stats);
+        void SetupBatch(Batch &batch, const Target &target, int tilesX, int tilesY);
+        void SetupTriangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, Batch &batch, const Target &target);
+        void AddTriangle(const ClipVertex *a, const ClipVertex *b, const ClipVertex *c, Batch &batch, const Target &target);
+        long long RasterizeTile(int tileX, int tileY, int tilesX, const Target &target);
+        void ShadePixel(const TriangleSetup &tri, float px, float py, size_t pixel, const Target &target) const;
+
+        glm::vec3 Shade(const glm::vec3 &worldPos, const glm::vec3 &normal, const glm::vec2 &uv, const Material &material) const;
+        float ShadowFactor(const glm::vec3 &worldPos, const glm::vec3 &normal, const glm::vec3 &lightDir) const;
+    };
+}
+
+#endif
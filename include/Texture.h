@@ -2,7 +2,37 @@
 #define TEXTURE_H
 
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 #include <string>
+#include <vector>
+#include <memory>
+
+namespace PartC
+{
+    struct TextureEntry;
+    class VirtualTexture;
+}
+
+// [Headless] CPU 端像素副本，仅在无 GL 上下文时保留，供软件光栅化采样
+// Rows are stored in file order, the same layout glTexImage2D receives.
+struct TextureImage
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<unsigned char> pixels;
+};
+
+// 采样参数：与路径一起组成纹理缓存的键 (TextureManager)
+struct TextureParams
+{
+    GLint wrap = GL_REPEAT;
+    GLint minFilter = GL_LINEAR_MIPMAP_LINEAR; // mipmaps are generated only for mipmapped filters
+    GLint magFilter = GL_LINEAR;
+    bool srgb = true; // colour image: mips are filtered in linear light (false for normal / data maps)
+
+    bool UsesMipmaps() const { return minFilter != GL_LINEAR && minFilter != GL_NEAREST; }
+};
 
 class Texture
 {
@@ -10,9 +40,28 @@ public:
     unsigned int id;
     std::string type; // diffuse, specular
     std::string path;
+    std::shared_ptr<TextureImage> image; // headless only
+
+    // [TextureManager] 共享的 GL 纹理 / 像素；最后一个引用释放后由缓存按预算回收
+    std::shared_ptr<PartC::TextureEntry> entry;
 
     Texture();
-    Texture(const char *path, const std::string &type);
+    // Decoded and uploaded once per (path, params), see TextureManager::Acquire
+    Texture(const char *path, const std::string &type, const TextureParams &params = TextureParams());
+    // 从内存像素创建（例如程序生成的棋盘格）
+    Texture(const unsigned char *data, int width, int height, int channels, const std::string &type, const std::string &path,
+            const TextureParams &params = TextureParams());
+
+    // GL 纹理、图集区域或 CPU 像素是否可用
+    bool IsLoaded() const { return id != 0 || image || AtlasLayer() >= 0; }
+
+    // [Atlas] 位于 TextureAtlas 数组中时为层号，否则 -1；rect 为数组中的 UV 区域 (offset.xy, scale.zw)
+    int AtlasLayer() const;
+    glm::vec4 AtlasRect() const;
+    // GL texture a draw has to bind; 0 for atlas textures (the array stays bound)
+    unsigned int BindingId() const { return AtlasLayer() >= 0 ? 0 : id; }
+    // [VT] 大纹理按页流式加载时非空；`id` 只是占位纹理
+    PartC::VirtualTexture *Virtual() const;
 
     void Bind(int unit) const;
 };
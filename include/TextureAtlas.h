@@ -0,0 +1,80 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "Texture.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace PartC
+{
+    class TextureContainer;
+
+    struct TextureAtlasStats
+    {
+        int layers = 0;        // pages in use
+        int capacity = 0;      // layers allocated in the GL array
+        int textures = 0;      // regions currently placed
+        int rejected = 0;      // eligible textures that found no space
+        float occupancy = 0.0f; // placed area (with gutters) / area of the pages in use
+        size_t bytes = 0;
+    };
+
+    // TextureAtlas: 小纹理打包进一个 GL_TEXTURE_2D_ARRAY，每层一页
+    // Small GL_REPEAT textures are copied into PAGE_SIZE x PAGE_SIZE layers, placed
+    // with a bottom-left skyline packer. Each region has GUTTER texels of wrapped
+    // content around it and starts on an 8-texel boundary, so bilinear filtering and
+    // mip levels 0..MIP_LEVELS-1 never read a neighbour. The fragment shader samples
+    // the array at `atlasRect.xy + fract(uv) * atlasRect.zw` in layer `atlasLayer`
+    // with the gradients of the unwrapped uv, so repeating and mip selection match a
+    // texture of its own. The array stays bound on one unit: draws whose textures
+    // are all in the atlas only change two uniforms, not texture bindings.
+    // The array grows by doubling its layers (copied on the GPU); a layer is reset
+    // once its last region is released.
+    class TextureAtlas
+    {
+    public:
+        static bool enabled;
+        static int maxTextureSize; // larger textures keep a GL texture of their own
+
+        static const int PAGE_SIZE = 1024;
+        static const int MAX_LAYERS = 16;
+        static const int GUTTER = 8;
+        static const int MIP_LEVELS = 4; // the gutter is one texel at the last level
+        static const int TEXTURE_UNIT = 14; // next to the shadow map (15)
+
+        // GL thread. Copies the container's levels into a free region; false if the
+        // texture is not eligible (too large, other sampling params) or no layer has room
+        static bool Insert(const TextureContainer &container, const TextureParams &params, int &layer, glm::vec4 &rect);
+        // A texture in `layer` was released
+        static void Release(int layer);
+
+        static unsigned int TextureId() { return arrayId; }
+        // Deletes the array; called by TextureManager::Shutdown
+        static void Shutdown();
+        static TextureAtlasStats Stats();
+
+    private:
+        struct SkylineSegment
+        {
+            int x, y, width;
+        };
+
+        struct Page
+        {
+            std::vector<SkylineSegment> skyline;
+            int regions = 0;
+            long long area = 0;
+        };
+
+        static std::vector<Page> pages;
+        static unsigned int arrayId;
+        static int capacity;
+        static int rejected;
+
+        static bool Place(Page &page, int width, int height, int &x, int &y);
+        static void Grow(int layers);
+    };
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef TEXTURE_CONTAINER_H
+#define TEXTURE_CONTAINER_H
+
+#include "Texture.h"
+#include "BlockCompression.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace PartC
+{
+    enum class MipFilter : uint32_t
+    {
+        Box = 0,   // area average (2x2 for even sizes)
+        Kaiser = 1 // Kaiser-windowed sinc, sharper minification
+    };
+
+    // One mip level: tightly packed rows (no 4-byte row alignment), or 4x4 blocks
+    struct TextureLevel
+    {
+        int width = 0;
+        int height = 0;
+        const unsigned char *data = nullptr;
+        size_t bytes = 0;
+    };
+
+    // TextureContainer: 预计算 mip 链的二进制纹理容器 (<image>.texcache)
+    // Layout: header | level table | level data (16-byte aligned), 8 bits per channel.
+    // Mips are filtered in linear light (sRGB decoded, alpha kept linear) and encoded
+    // back to sRGB, so they do not darken the way glGenerateMipmap's sRGB-agnostic
+    // average does. Open memory-maps the file and the levels point straight into the
+    // mapping, so loading is pure I/O: no decode and no mip generation at runtime.
+    // Like the mesh cache, a container is used while the source image's size and
+    // modification time are unchanged, and rebuilt on the next load otherwise.
+    //
+    // [BCn] Compress replaces every level with BC1 / BC3 / BC7 blocks. Upload sends
+    // blocks as they are when the driver supports the format and decodes them to
+    // RGBA otherwise. With compression set to None any container is accepted, so
+    // assets compressed offline (TextureConvert) are used as shipped.
+    class TextureContainer
+    {
+    public:
+        static bool useTextureCache; // TextureManager reads / writes containers
+        static MipFilter mipFilter;  // filter for newly built chains
+        static BlockFormat compression; // format TextureManager compresses new chains to
+
+        int width = 0, height = 0, channels = 0;
+        bool srgb = true;
+        MipFilter filter = MipFilter::Box;
+        BlockFormat format = BlockFormat::None;
+        double psnr = 0.0; // level 0 after Compress, in dB
+        std::vector<TextureLevel> levels; // levels[0] is the source image
+
+        ~TextureContainer();
+        TextureContainer(const TextureContainer &) = delete;
+        TextureContainer &operator=(const TextureContainer &) = delete;
+
+        static std::string CachePath(const std::string &sourcePath);
+
+        // Null when there is no container, it is stale, or it was built with other settings
+        static std::unique_ptr<TextureContainer> Open(const std::string &sourcePath, bool srgb);
+        // Full mip chain of decoded pixels, in memory
+        static std::unique_ptr<TextureContainer> Build(const unsigned char *pixels, int width, int height, int channels,
+                                                       bool srgb, MipFilter filter);
+        bool Save(const std::string &sourcePath) const;
+
+        // Block-compresses every level when `requested` applies (see CompressedFormat)
+        void Compress(BlockFormat requested);
+        // Images with 1 or 2 channels, or sizes that are not a multiple of 4, stay uncompressed
+        static BlockFormat CompressedFormat(BlockFormat requested, int width, int height, int channels);
+
+        // GL thread: one glTexImage2D / glCompressedTexImage2D per level (level 0 only
+        // for non-mipmapped params); false if blocks had to be decoded to RGBA
+        bool Upload(unsigned int id, const TextureParams &params) const;
+
+        size_t Bytes() const;
+        bool IsMapped() const { return mapped != nullptr; }
+
+    private:
+        TextureContainer() = default;
+
+        std::vector<unsigned char> storage; // Build / Compress
+        void *mapped = nullptr;             // Open
+        size_t mappedSize = 0;
+#ifdef _WIN32
+        void *fileHandle = nullptr;
+        void *mappingHandle = nullptr;
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include "Texture.h"
+#include "TextureContainer.h"
+#include "VirtualTexture.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace PartC
+{
+    // 一张解码并上传过的图像，由所有引用它的 Texture 共享
+    struct TextureEntry
+    {
+        std::string key; // empty for textures created from memory (not cached)
+        std::string path;
+        TextureParams params;
+        unsigned int id = 0;
+        bool ready = true; // false while the placeholder is bound (async decode)
+        std::shared_ptr<TextureImage> image; // headless only
+        int width = 0, height = 0, channels = 0;
+        BlockFormat format = BlockFormat::None; // as uploaded
+        bool blockFallback = false;             // compressed container decoded to RGBA (format unsupported)
+        int atlasLayer = -1;                    // [Atlas] placed in TextureAtlas instead of `id`
+        glm::vec4 atlasRect = glm::vec4(0.0f);
+        std::shared_ptr<VirtualTexture> virtualTexture; // [VT] pages streamed from <path>.vtex
+        size_t bytes = 0; // estimated, including the mip chain
+        uint64_t lastUse = 0;
+
+        ~TextureEntry(); // deletes the GL texture, releases the atlas region
+    };
+
+    struct TextureCacheStats
+    {
+        int entries = 0;
+        int referenced = 0; // held by at least one Texture
+        size_t bytes = 0;
+        size_t budgetBytes = 0;
+        int hits = 0;
+        int decodes = 0;
+        int containerLoads = 0; // decodes served from a .texcache instead of stb_image
+        int compressed = 0;     // entries in a block-compressed GL format
+        int blockFallbacks = 0; // entries whose blocks were decoded to RGBA
+        int atlased = 0;        // entries living in the TextureAtlas array
+        int virtualTextures = 0; // entries streamed from a .vtex
+        int evictions = 0;
+        int pendingDecodes = 0; // queued or running on the workers
+        int pendingUploads = 0; // decoded, waiting for ProcessUploads
+        int frameUploads = 0;   // uploaded by the last ProcessUploads
+        float frameUploadMs = 0.0f;
+    };
+
+    // TextureManager: 按 (路径, 采样参数) 去重的纹理缓存
+    // Every Texture loaded from a file holds a shared_ptr to the cached entry, so an
+    // image is decoded with stb_image and uploaded once however many objects, or
+    // diffuse / specular slots, use it. Entries no Texture references any more stay
+    // cached for reuse; when the cache grows past budgetBytes the least recently
+    // used of them are released. Referenced entries are never evicted, so the budget
+    // can be exceeded by textures that are actually in use.
+    //
+    // [Async] With a GL context, Acquire only reads the image header: the entry gets
+    // its GL id at once with a 1x1 grey placeholder, and stb_image runs as a
+    // background job on the ThreadPool. ProcessUploads, called once per frame on the
+    // GL thread, uploads finished images into the same id (so every Texture copy
+    // picks them up) until uploadBudgetMs is used; one image is the smallest step.
+    //
+    // [Mips] Images are loaded as a TextureContainer: the mapped .texcache next to the
+    // image when it is current, otherwise decoded, mip-filtered on the CPU and saved
+    // for the next run. Headless entries keep level 0 only (the software rasterizer
+    // does not sample mips); Create still uses glGenerateMipmap. New chains are
+    // block-compressed to TextureContainer::compression before they are saved.
+    // Small textures go into the shared TextureAtlas array when it takes them; their
+    // `id` then only holds the placeholder.
+    // [VT] An image with a current <path>.vtex next to it is never decoded: it becomes
+    // a VirtualTexture whose pages stream in as the frame's feedback asks for them.
+    class TextureManager
+    {
+    public:
+        static size_t budgetBytes;
+        static bool asyncDecode;
+        static float uploadBudgetMs;
+
+        // Null if the file cannot be decoded (failures are not cached)
+        static std::shared_ptr<TextureEntry> Acquire(const std::string &path, const TextureParams &params);
+        // Not cached: the pixels have no file to be shared by
+        static std::shared_ptr<TextureEntry> Create(const unsigned char *data, int width, int height, int channels,
+                                                    const TextureParams &params);
+
+        // GL thread: uploads decoded images, at least one, until budgetMs has passed;
+        // returns the number uploaded
+        static int ProcessUploads(float budgetMs);
+
+        // Releases unreferenced entries, least recently used first, until the cache
+        // holds at most targetBytes; returns the number released
+        static int Trim(size_t targetBytes);
+
+        // Before the GL context is destroyed: drops the cache and pending uploads, and
+        // entries released after this point no longer call into GL
+        static void Shutdown();
+        static bool IsShutDown() { return shutDown.load(); }
+
+        static TextureCacheStats Stats();
+
+    private:
+        // Decoded on a worker, waiting for the GL thread
+        struct PendingUpload
+        {
+            std::weak_ptr<TextureEntry> entry;            // evicted meanwhile: the levels are dropped
+            std::shared_ptr<TextureContainer> container; // null if decoding failed
+        };
+
+        static std::unordered_map<std::string, std::shared_ptr<TextureEntry>> entries;
+        static std::deque<PendingUpload> uploads;
+        static std::mutex uploadMutex;
+        static std::atomic<int> pendingDecodes;
+        static int frameUploads;
+        static float frameUploadMs;
+        static size_t cachedBytes;
+        static uint64_t useClock;
+        static int hits, decodes, evictions;
+        static std::atomic<int> containerLoads; // counted by decode jobs
+        static std::atomic<bool> shutDown; // read by decode jobs
+
+        static std::string MakeKey(const std::string &path, const TextureParams &params);
+        static void Decode(std::weak_ptr<TextureEntry> entry, std::string path, bool srgb);
+        // Any thread: the current .texcache, or the decoded image with its mip chain built (and saved)
+        static std::shared_ptr<TextureContainer> LoadContainer(const std::string &path, bool srgb);
+    };
+}
+
+#endif
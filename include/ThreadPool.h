@@ -0,0 +1,61 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <cstddef>
+
+// ThreadPool: 全局工作线程池
+// 用于 CPU 端的并行任务（批量射线查询、软件光栅化等），避免各模块各自创建线程
+class ThreadPool
+{
+public:
+    using Job = std::function<void()>;
+
+    static ThreadPool &Instance()
+    {
+        static ThreadPool instance;
+        return instance;
+    }
+
+    // Number of worker threads (not counting the calling thread)
+    size_t GetWorkerCount() const { return workers.size(); }
+
+    // Queue a fire-and-forget job
+    void Enqueue(Job job);
+
+    // Long-running job (e.g. image decoding) that only the workers pick up, after
+    // the regular queue is empty: ParallelFor callers never block on one while
+    // helping. Jobs still queued when the pool shuts down are dropped.
+    void EnqueueBackground(Job job);
+
+    // Split [0, count) into chunks of at most `grainSize` items and run
+    // func(begin, end) on the workers. The calling thread helps and blocks
+    // until every chunk has finished, so it is safe to call from a worker.
+    // If chunks throw, the first exception is rethrown here after all chunks end.
+    void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &func);
+
+private:
+    ThreadPool();
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Pops one queued job and runs it on the current thread; false if the queue was empty
+    bool RunPendingJob();
+    void WorkerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<Job> jobs;
+    std::deque<Job> backgroundJobs;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    bool stopping = false;
+};
+
+#endif
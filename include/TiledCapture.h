@@ -0,0 +1,73 @@
+#ifndef TILED_CAPTURE_H
+#define TILED_CAPTURE_H
+
+#include "PngWriter.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace PartC
+{
+    // One sub-frustum of the full image; x, y: top-left corner in image pixels (y down)
+    struct CaptureTile
+    {
+        int x = 0, y = 0;
+        int width = 0, height = 0;
+        glm::mat4 projection = glm::mat4(1.0f);
+    };
+
+    // TiledCapture: 任意分辨率截图，分块离屏渲染，逐行条带流式写入 PNG
+    // The image is cut into a grid of tiles of at most tileSize pixels; each tile's
+    // projection is the full projection followed by an NDC scale + offset that
+    // stretches the tile's rectangle over the whole clip space, so the tiles of a
+    // row meet without seams. Tiles are drawn into one offscreen framebuffer and
+    // read back (glReadPixels with GL_PACK_ROW_LENGTH) straight into a strip
+    // buffer as wide as the image and one tile high; when a row of tiles is done
+    // the strip goes to a PngWriter, which compresses it on the ThreadPool. Only
+    // one strip is held: a 16K x 8K poster needs ~48 MB at the default tile size
+    // instead of the ~400 MB of the whole image.
+    // GL thread; the caller draws each tile (Begin, then per row: per tile draw +
+    // ReadTile, EndRow; then End).
+    class TiledCapture
+    {
+    public:
+        static int tileSize;
+        static int maxImageSize; // per side
+
+        TiledCapture() = default;
+        ~TiledCapture();
+        TiledCapture(const TiledCapture &) = delete;
+        TiledCapture &operator=(const TiledCapture &) = delete;
+
+        // projection: the full image's (its aspect ratio should be width / height)
+        bool Begin(const std::string &path, int width, int height, const glm::mat4 &projection,
+                   PngCompression level);
+        int Rows() const { return rows; }
+        int Columns() const { return columns; }
+        CaptureTile Tile(int row, int column) const;
+        // Bound while drawing a tile; viewport (0, 0, tile.width, tile.height)
+        unsigned int Framebuffer() const { return fbo; }
+
+        void ReadTile(const CaptureTile &tile);
+        // Hands the finished strip (row of tiles, top first) to the PNG writer
+        bool EndRow(int row);
+        // Finishes the file and releases the framebuffer; false if any step failed
+        bool End();
+
+        size_t StripBytes() const { return strip.size(); }
+
+    private:
+        int width = 0, height = 0;
+        int tile = 0;
+        int rows = 0, columns = 0;
+        glm::mat4 fullProjection = glm::mat4(1.0f);
+        unsigned int fbo = 0, colorBuffer = 0, depthBuffer = 0;
+        std::vector<uint8_t> strip; // RGB, bottom row first (glReadPixels order)
+        PngWriter writer;
+        bool ok = false;
+
+        void Release();
+    };
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef VERTEX_CODEC_H
+#define VERTEX_CODEC_H
+
+#include "Common.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace PartC
+{
+    // VertexCodec: GPU 端紧凑顶点格式的编码 / 解码
+    // Packed layout (20 bytes instead of 32):
+    //   offset 0   float x3    position
+    //   offset 12  snorm16 x2  normal, octahedral encoding (decoded in vertex.glsl)
+    //   offset 16  half x2     texture coordinates
+    // Meshes with texture coordinates outside [-HALF_UV_LIMIT, HALF_UV_LIMIT] keep float UVs
+    // (24 bytes). Half spacing is 2^-11 in [0.5, 1) (half a texel at 1024) but 2^-10 in
+    // [1, 2), four texels at 4096, which makes tiled and atlas UVs visibly swim.
+    // Only the GPU copy is packed; Mesh keeps its float vertices.
+    class VertexCodec
+    {
+    public:
+        static const size_t PACKED_STRIDE = 20;
+        static const size_t PACKED_STRIDE_FLOAT_UV = 24;
+        static const size_t NORMAL_OFFSET = 12;
+        static const size_t TEXCOORD_OFFSET = 16;
+        static constexpr float HALF_UV_LIMIT = 1.0f;
+
+        static void EncodeOctahedral(const glm::vec3 &normal, int16_t out[2]);
+        static glm::vec3 DecodeOctahedral(const int16_t in[2]);
+
+        static uint16_t FloatToHalf(float value);
+        static float HalfToFloat(uint16_t half);
+
+        static bool CanUseHalfTexCoords(const std::vector<Vertex> &vertices);
+        static size_t Stride(bool halfTexCoords) { return halfTexCoords ? PACKED_STRIDE : PACKED_STRIDE_FLOAT_UV; }
+
+        static std::vector<uint8_t> Encode(const std::vector<Vertex> &vertices, bool halfTexCoords);
+        // Back to float vertices exactly as the GPU sees them (precision checks)
+        static std::vector<Vertex> Decode(const std::vector<uint8_t> &packed, bool halfTexCoords);
+
+        // 16-bit indices are enough when every vertex index fits
+        static bool CanUseShortIndices(size_t vertexCount) { return vertexCount <= 65536; }
+        static std::vector<uint16_t> EncodeShortIndices(const std::vector<unsigned int> &indices);
+    };
+}
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include "Common.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Mesh;
+class Shader;
+
+namespace PartC
+{
+    // One tile of one mip level; x, y are tile coordinates at that level
+    struct VirtualPage
+    {
+        int level = 0;
+        int x = 0, y = 0;
+
+        uint32_t Key() const { return ((uint32_t)level << 24) | ((uint32_t)y << 12) | (uint32_t)x; }
+        static VirtualPage FromKey(uint32_t key)
+        {
+            return {(int)(key >> 24), (int)(key & 0xFFF), (int)((key >> 12) & 0xFFF)};
+        }
+    };
+
+    // VirtualTextureFile: 分块存储的 mip 链 (<image>.vtex)
+    // Layout: header | tiles. Every tile of every level is TILE_SIZE x TILE_SIZE RGBA8
+    // texels plus BORDER texels of its neighbours (clamped at the image edge) on each
+    // side, so a page sampled bilinearly never needs the page next to it. Tiles are
+    // stored level by level, row by row, at fixed size: a tile's offset follows from
+    // its coordinates and nothing but the requested tiles is ever read. Level l is
+    // ceil(width / 2^l) texels wide, filtered from level l-1 in linear light; the
+    // last level is a single tile. Like .texcache, a file is used while the source
+    // image's size and modification time are unchanged. Only TextureConvert builds
+    // them: a 16K source does not fit the runtime memory budget.
+    class VirtualTextureFile
+    {
+    public:
+        static const int TILE_SIZE = 128;
+        static const int BORDER = 4;
+        static const int PADDED_SIZE = TILE_SIZE + 2 * BORDER;
+        static const size_t TILE_BYTES = (size_t)PADDED_SIZE * PADDED_SIZE * 4;
+
+        int width = 0, height = 0; // level 0, in texels
+        int levels = 0;
+
+        static std::string PathFor(const std::string &sourcePath);
+        // Any thread; writes PathFor(sourcePath)
+        static bool Build(const unsigned char *pixels, int width, int height, int channels, bool srgb,
+                          const std::string &sourcePath);
+        // Null if there is no current .vtex for the image
+        static std::unique_ptr<VirtualTextureFile> Open(const std::string &sourcePath);
+
+        int TilesX(int level) const;
+        int TilesY(int level) const;
+        // Any thread: TILE_BYTES of RGBA8 texels
+        bool ReadTile(const VirtualPage &page, std::vector<uint8_t> &texels);
+
+    private:
+        std::ifstream file;
+        std::mutex fileMutex;
+        std::vector<uint64_t> levelOffsets; // first tile of each level, in tiles
+    };
+
+    struct VirtualTextureStats
+    {
+        int requested = 0; // distinct pages wanted this frame, parents included
+        int resident = 0;
+        int loading = 0;   // selected, not inserted yet
+        int missing = 0;   // requested, shown through a coarser page
+        int slots = 0;
+        int evictions = 0; // since creation
+        int dropped = 0;   // loads that found every slot in use this frame
+    };
+
+    // VirtualTextureCache: 页面选择、LRU 页缓存与间接表 (纯 CPU，不依赖 GL)
+    // Each frame starts with BeginFrame, then feedback requests pages; a requested
+    // page also requests its parents, and the single page of the last level is
+    // requested every frame, so every texel always has a page to fall back to.
+    // SelectLoads hands out the missing pages, coarsest level first and, within a
+    // level, those whose fallback is coarsest; Insert gives a loaded page a slot: a
+    // free one or the least recently requested page's, never one requested this
+    // frame. The indirection table has one RGBA8 texel per level-0 tile: slot x, y,
+    // level of the finest resident page covering it, and 255 once anything is.
+    class VirtualTextureCache
+    {
+    public:
+        // slotsPerRow^2 physical pages (at most 255 per row)
+        VirtualTextureCache(int tilesX, int tilesY, int levels, int slotsPerRow);
+
+        int TilesX(int level) const { return std::max(1, (tilesX + (1 << level) - 1) >> level); }
+        int TilesY(int level) const { return std::max(1, (tilesY + (1 << level) - 1) >> level); }
+        int Levels() const { return levels; }
+        int SlotsPerRow() const { return slotsPerRow; }
+
+        void BeginFrame();
+        void Request(const VirtualPage &page);
+        size_t RequestCount() const { return requested.size(); }
+        size_t LoadingCount() const { return loading.size(); }
+
+        // Marks the returned pages as loading; at most maxCount
+        std::vector<VirtualPage> SelectLoads(int maxCount);
+        // Slot the loaded page goes to, -1 if it has to wait (the load is dropped)
+        int Insert(const VirtualPage &page);
+        // The load failed: the page can be selected again
+        void Cancel(const VirtualPage &page);
+
+        bool IsResident(const VirtualPage &page) const { return resident.count(page.Key()) != 0; }
+        int SlotOf(const VirtualPage &page) const;
+        // Finest resident level covering a level-0 tile, -1 if none
+        int ResidentLevel(int x, int y) const;
+
+        // Rebuilt after pages came or went; false if unchanged since the last call
+        bool UpdateIndirection(std::vector<uint8_t> &rgba);
+
+        VirtualTextureStats Stats() const;
+
+    private:
+        struct Slot
+        {
+            uint32_t key = 0;
+            bool used = false;
+            uint64_t lastRequest = 0;
+        };
+
+        int tilesX, tilesY, levels, slotsPerRow;
+        uint64_t frame = 0;
+        std::vector<Slot> slots;
+        std::unordered_map<uint32_t, int> resident;   // page key -> slot
+        std::unordered_map<uint32_t, int> requested;  // page key -> requests this frame
+        std::unordered_set<uint32_t> loading;
+        bool indirectionDirty = true;
+        int evictions = 0, dropped = 0;
+    };
+
+    // VirtualTextureFeedback: CPU 端计算每个三角形需要的 mip 层与页面
+    // The level of a triangle is half the log2 of its texel area (level 0) over its
+    // area in pixels, so one level per triangle: large surfaces such as terrain have
+    // to be tessellated to get finer pages near the camera. Every page of that level
+    // under the triangle's UV bounds is requested; a triangle that would request
+    // more than maxPagesPerTriangle moves to coarser levels. Triangles outside the
+    // frustum are skipped; those crossing the near plane request level 0 (they are
+    // the closest). UVs are clamped to [0, 1], as the shader samples them.
+    class VirtualTextureFeedback
+    {
+    public:
+        static float lodBias;
+        static int maxPagesPerTriangle;
+
+        static void Accumulate(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                               const glm::mat4 &modelViewProjection, const glm::vec2 &viewport, int width, int height,
+                               VirtualTextureCache &cache);
+    };
+
+    // VirtualTexture: GL 端的物理页缓存与间接纹理
+    // The physical cache is one RGBA8 texture of SlotsPerRow^2 padded pages; the
+    // indirection texture maps level-0 tiles to pages. Feedback comes from the draws
+    // submitted this frame (AddFeedback); Update then queues the selected tiles as
+    // background reads on the ThreadPool and uploads those that have arrived, at most
+    // uploadsPerFrame, before the frame is drawn. Pages still missing show the
+    // nearest coarser resident page.
+    class VirtualTexture
+    {
+    public:
+        static bool enabled;        // TextureManager opens .vtex files next to images
+        static int cacheSlotsPerRow; // for textures opened afterwards
+        static int uploadsPerFrame;
+        static int loadsInFlight; // background reads per texture
+
+        static const int CACHE_UNIT = 12;       // physical pages
+        static const int INDIRECTION_UNIT = 13; // next to the atlas (14)
+
+        ~VirtualTexture();
+
+        // GL thread; null if there is no current .vtex for the image
+        static std::shared_ptr<VirtualTexture> Open(const std::string &sourcePath);
+
+        // GL thread, once per frame for every open texture: feedback is collected
+        // between BeginFrame and Update
+        static void BeginFrameAll();
+        static void UpdateAll();
+
+        void AddFeedback(const Mesh &mesh, const glm::mat4 &modelViewProjection, const glm::vec2 &viewport);
+        void Bind(Shader &shader) const;
+
+        int Width() const { return file->width; }
+        int Height() const { return file->height; }
+        size_t Bytes() const;
+        VirtualTextureStats Stats() const { return cache.Stats(); }
+        // Summed over every open texture
+        static VirtualTextureStats TotalStats();
+
+    private:
+        struct LoadedTile
+        {
+            VirtualPage page;
+            std::vector<uint8_t> texels; // empty if the read failed
+        };
+
+        struct LoadQueue
+        {
+            std::mutex mutex;
+            std::deque<LoadedTile> tiles;
+            bool closed = false; // the texture is gone: reads finishing later are dropped
+        };
+
+        std::shared_ptr<VirtualTextureFile> file;
+        VirtualTextureCache cache;
+        std::shared_ptr<LoadQueue> queue;
+        unsigned int cacheId = 0, indirectionId = 0;
+        std::vector<uint8_t> indirection;
+
+        static std::vector<std::weak_ptr<VirtualTexture>> instances;
+
+        VirtualTexture(std::unique_ptr<VirtualTextureFile> file, int slotsPerRow);
+        void Update();
+    };
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include <vector>
 #include <filesystem>
 #include <string>
+#include <chrono>
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -16,38 +17,25 @@
 #include "GeometryUtils.h"
 #include "GeometryGenerator.h"
 #include "OBJLoader.h"
+#include "MeshSimplifier.h"
+#include "MeshColliderComponent.h"
+#include "MeshOptimizer.h"
 #include "Renderer.h"
 #include "Texture.h"
+#include "TextureManager.h"
+#include "TextureAtlas.h"
+#include "VirtualTexture.h"
+#include "SoftwareRasterizer.h"
+#include "ImageWriter.h"
+#include "TiledCapture.h"
 
 namespace fs = std::filesystem;
 
-// 用于BMP文件格式的结构体
-#pragma pack(push, 1)
-struct BMPHeader {
-    unsigned char header[2] = { 'B', 'M' };
-    unsigned int fileSize;
-    unsigned short reserved1 = 0;
-    unsigned short reserved2 = 0;
-    unsigned int dataOffset;
-    unsigned int headerSize = 40;
-    int width;
-    int height;
-    unsigned short planes = 1;
-    unsigned short bitsPerPixel = 24;
-    unsigned int compression = 0;
-    unsigned int imageSize;
-    int xPixelsPerMeter = 0;
-    int yPixelsPerMeter = 0;
-    unsigned int colorsUsed = 0;
-    unsigned int colorsImportant = 0;
-};
-#pragma pack(pop)
-
 Application::Application(const std::string &title, int width, int height)
-    : appTitle(title), scrWidth(width), scrHeight(height),
+    : window(nullptr), scrWidth(width), scrHeight(height), appTitle(title),
+      camera(nullptr), scene(nullptr), mainShader(nullptr),
       deltaTime(0.0f), lastFrame(0.0f),
-      isMousePressed(false), isDragging(false), firstMouse(true),
-      camera(nullptr), scene(nullptr), mainShader(nullptr)
+      isMousePressed(false), isDragging(false), firstMouse(true)
 {
     lastX = width / 2.0f;
     lastY = height / 2.0f;
@@ -61,11 +49,20 @@ Application::~Application()
         delete camera;
     if (mainShader)
         delete mainShader;
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
-    glfwDestroyWindow(window);
-    glfwTerminate();
+
+    // [Headless] 没有创建窗口时也没有 ImGui / GLFW 需要关闭
+    if (window)
+    {
+        // [Capture] 写完已读回的截图，再释放像素缓冲
+        screenCapture.Shutdown();
+        // [TextureManager] 释放缓存中的 GL 纹理，之后释放的纹理不再调用 GL
+        PartC::TextureManager::Shutdown();
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 }
 
 bool Application::InitGLFW()
@@ -101,6 +98,7 @@ bool Application::InitGLFW()
 
     // [Part C] Init Shadow Map
     PartC::Renderer::InitShadowMap();
+    PartC::Renderer::InitUniformBuffers();
 
     return true;
 }
@@ -127,7 +125,9 @@ void Application::InitScene()
     camera = new Camera(glm::vec3(0.0f, 4.0f, 8.0f));
     scene = new SceneContext();
     scene->mainCamera = camera;
-    mainShader = new Shader("assets/shaders/vertex.glsl", "assets/shaders/fragment.glsl");
+    // [Headless] 软件渲染不需要 GL 着色器
+    if (!PartC::Renderer::headless)
+        mainShader = new Shader("assets/shaders/vertex.glsl", "assets/shaders/fragment.glsl");
 
     // 地面
     Mesh *floorMesh = GeometryUtils::CreateCube();
@@ -142,10 +142,6 @@ void Application::InitScene()
     Mesh *cubeMesh = GeometryUtils::CreateCube();
 
     // [Part C Test] Manually create a checkerboard texture to verify rendering pipeline
-    unsigned int texID;
-    glGenTextures(1, &texID);
-    glBindTexture(GL_TEXTURE_2D, texID);
-
     const int w = 64, h = 64;
     unsigned char data[w * h * 3];
     for (int y = 0; y < h; y++)
@@ -160,23 +156,11 @@ void Application::InitScene()
             data[idx + 2] = val;              // B
         }
     }
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    Texture diffuseMap;
-    diffuseMap.id = texID;
-    diffuseMap.type = "diffuse";
-    diffuseMap.path = "generated_checkerboard";
+    Texture diffuseMap(data, w, h, 3, "diffuse", "generated_checkerboard");
 
     // Reuse same texture for specular for now
-    Texture specularMap;
-    specularMap.id = texID;
+    Texture specularMap = diffuseMap;
     specularMap.type = "specular";
-    specularMap.path = "generated_checkerboard";
 
     cubeMesh->textures.push_back(diffuseMap);
     cubeMesh->textures.push_back(specularMap);
@@ -199,7 +183,7 @@ void Application::DeleteSelectedObject()
     {
         if (*it == scene->selectedObject)
         {
-            delete (*it)->mesh;
+            // The mesh goes with the last object holding it (clones share it)
             delete *it;
             it = objs.erase(it);
             scene->selectedObject = nullptr;
@@ -269,264 +253,112 @@ void Application::UpdateFileList(const std::string &directory)
     }
 }
 
-// [新增] 渲染文件选择器UI
+// [Capture] 快速截图：带时间戳的文件名，像素在下一帧场景绘制后异步读回
 void Application::CaptureScreen() {
     // 确保目录存在
     std::string dirPath = "screenshots";
     if (!fs::exists(dirPath)) {
         fs::create_directory(dirPath);
     }
-    
-    // 获取屏幕尺寸
-    int width = scrWidth;
-    int height = scrHeight;
-    
-    // 保存当前的渲染状态
-    GLint viewport[4];
-    glGetIntegerv(GL_VIEWPORT, viewport);
-    
-    // 重新渲染场景（不包括UI），确保截图只包含摄像机视角的内容
-    if (mainShader && scene && camera) {
-        // 1. 渲染阴影映射
-        PartC::Renderer::BeginShadowMap();
-        for (auto obj : scene->objects) {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, obj->position);
-            model = glm::rotate(model, glm::radians(obj->rotation.x), glm::vec3(1, 0, 0));
-            model = glm::rotate(model, glm::radians(obj->rotation.y), glm::vec3(0, 1, 0));
-            model = glm::rotate(model, glm::radians(obj->rotation.z), glm::vec3(0, 0, 1));
-            model = glm::scale(model, obj->scale);
-
-            PartC::Renderer::depthShader->setMat4("model", model);
-            if (obj->mesh)
-                obj->mesh->Draw(*PartC::Renderer::depthShader);
-        }
-        PartC::Renderer::EndShadowMap(width, height);
 
-        // 2. 正常渲染场景
-        glViewport(0, 0, width, height);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // 生成文件名（使用时间戳），同一秒内的多张截图加序号
+    time_t now = time(nullptr);
+    struct tm* timeinfo = localtime(&now);
+    char timestamp[20];
+    strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", timeinfo);
 
-        mainShader->use();
-        float aspectRatio = (height > 0) ? (float)width / (float)height : 1.0f;
-        glm::mat4 projection = glm::perspective(glm::radians(camera->Zoom), aspectRatio, 0.1f, 100.0f);
-        glm::mat4 view = camera->GetViewMatrix();
-        mainShader->setMat4("projection", projection);
-        mainShader->setMat4("view", view);
+    PartC::ImageFormat format = (PartC::ImageFormat)screenshotFormat;
+    std::string filename = "screenshots/screenshot_" + std::string(timestamp);
+    std::string filePath = filename + PartC::ImageWriter::Extension(format);
+    for (int i = 1; fs::exists(filePath); i++)
+        filePath = filename + "_" + std::to_string(i) + PartC::ImageWriter::Extension(format);
 
-        PartC::Renderer::SetupLights(*mainShader, camera->Position);
+    screenCapture.Request(filePath, format, PartC::PngWriter::compression);
+    std::cout << "Screenshot queued: " << filePath << std::endl;
+}
 
-        for (auto obj : scene->objects) {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, obj->position);
-            model = glm::rotate(model, glm::radians(obj->rotation.x), glm::vec3(1, 0, 0));
-            model = glm::rotate(model, glm::radians(obj->rotation.y), glm::vec3(0, 1, 0));
-            model = glm::rotate(model, glm::radians(obj->rotation.z), glm::vec3(0, 0, 1));
-            model = glm::scale(model, obj->scale);
-
-            mainShader->setVec3("objectColor", obj->color);
-            PartC::Renderer::RenderMesh(obj->mesh, *mainShader, model);
-
-            if (obj == scene->selectedObject) {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-                glLineWidth(2.5f);
-                glm::mat4 highlightModel = glm::scale(model, glm::vec3(1.005f));
-                mainShader->setMat4("model", highlightModel);
-
-                if (obj->mesh)
-                    obj->mesh->Draw(*mainShader);
-
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-                glLineWidth(1.0f);
-            }
-        }
+// [Record] 每次录制一个目录 recordings/<时间戳>/，帧号连续（丢帧处留空号）
+void Application::ToggleRecording() {
+    if (screenCapture.IsRecording()) {
+        PartC::CaptureStats stats = screenCapture.Stats();
+        screenCapture.StopRecording();
+        std::cout << "Recording stopped: " << stats.recordedFrames << " frames, " << stats.dropped << " dropped, "
+                  << stats.encoding << " still encoding" << std::endl;
+        return;
     }
-    
-    // 从OpenGL读取像素数据
-    unsigned char* pixels = new unsigned char[width * height * 3];
-    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
-    
-    // 直接使用原始像素数据，不进行翻转
-    // 修正：OpenGL(glReadPixels)的数据是自底向上的 (Bottom-Left origin)
-    // BMP文件存储也是自底向上的。
-    // 因此，不需要翻转内存，直接使用原始数据即可
-    unsigned char* flippedPixels = pixels; // 直接使用原始像素数据，不进行复制
-    
-    // 生成文件名（使用时间戳）
+
     time_t now = time(nullptr);
     struct tm* timeinfo = localtime(&now);
     char timestamp[20];
     strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", timeinfo);
-    
-    std::string filename = "screenshots/screenshot_" + std::string(timestamp);
-    
-    // 根据选择的格式保存文件
-    bool success = false;
-    if (screenshotFormat == 0) { // BMP
-        // 直接保存像素数据
-        std::string filePath = filename + ".bmp";
-        std::ofstream file(filePath, std::ios::binary);
-        if (file) {
-            int rowSize = ((width * 24 + 31) / 32) * 4;
-            int imageSize = rowSize * height;
-            int fileSize = sizeof(BMPHeader) + imageSize;
-            
-            BMPHeader header;
-            header.fileSize = fileSize;
-            header.dataOffset = sizeof(BMPHeader);
-            header.width = width;
-            header.height = height;
-            header.imageSize = imageSize;
-            
-            file.write(reinterpret_cast<const char*>(&header), sizeof(BMPHeader));
-            
-            // 修正：OpenGL(glReadPixels)的数据是自底向上的 (Bottom-Left origin)
-            // BMP文件存储也是自底向上的。
-            // 因此，直接正序写入即可，不需要从最后一行开始。
-            for (int y = 0; y < height; y++) { // <--- 改为正序循环 0 到 height
-                for (int x = 0; x < width; x++) {
-                    int index = (y * width + x) * 3;
-                    file.write(reinterpret_cast<const char*>(&flippedPixels[index + 2]), 1); // B
-                    file.write(reinterpret_cast<const char*>(&flippedPixels[index + 1]), 1); // G
-                    file.write(reinterpret_cast<const char*>(&flippedPixels[index]), 1);     // R
-                }
-                int padding = rowSize - width * 3;
-                for (int p = 0; p < padding; p++) {
-                    file.write("\0", 1);
-                }
-            }
-            
-            file.close();
-            success = true;
-        }
-    } else if (screenshotFormat == 1) { // PNG
-        // 注意：由于PNG格式的复杂性，这里我们改为生成BMP文件
-        // 并将扩展名改为.png，这样至少可以生成一个有效的图像文件
-        // 实际项目中建议使用libpng库来实现完整的PNG支持
-        std::string filePath = filename + ".png";
-        std::ofstream file(filePath, std::ios::binary);
-        if (file) {
-            // 写入BMP格式的数据，但使用.png扩展名
-            int rowSize = ((width * 24 + 31) / 32) * 4;
-            int imageSize = rowSize * height;
-            int fileSize = sizeof(BMPHeader) + imageSize;
-            
-            BMPHeader header;
-            header.fileSize = fileSize;
-            header.dataOffset = sizeof(BMPHeader);
-            header.width = width;
-            header.height = height;
-            header.imageSize = imageSize;
-            
-            file.write(reinterpret_cast<const char*>(&header), sizeof(BMPHeader));
-            
-            // 修正：OpenGL(glReadPixels)的数据是自底向上的 (Bottom-Left origin)
-            // BMP文件存储也是自底向上的。
-            // 因此，直接正序写入即可，不需要从最后一行开始。
-            for (int y = 0; y < height; y++) { // <--- 改为正序循环 0 到 height
-                for (int x = 0; x < width; x++) {
-                    int index = (y * width + x) * 3;
-                    file.write(reinterpret_cast<const char*>(&flippedPixels[index + 2]), 1); // B
-                    file.write(reinterpret_cast<const char*>(&flippedPixels[index + 1]), 1); // G
-                    file.write(reinterpret_cast<const char*>(&flippedPixels[index]), 1);     // R
-                }
-                int padding = rowSize - width * 3;
-                for (int p = 0; p < padding; p++) {
-                    file.write("\0", 1);
-                }
-            }
-            
-            file.close();
-            success = true;
-        }
-    }
-    
-    // 释放内存
-    delete[] pixels;
-    // 不需要释放flippedPixels，因为它只是pixels的一个别名
-    
-    // 恢复视口设置
-    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
-    
-    if (success) {
-        std::cout << "Screenshot saved successfully!" << std::endl;
-    } else {
-        std::cerr << "Failed to save screenshot!" << std::endl;
+    std::string dirPath = "recordings/" + std::string(timestamp);
+    std::error_code error;
+    fs::create_directories(dirPath, error);
+    if (error) {
+        std::cerr << "Failed to create recording directory: " << dirPath << std::endl;
+        return;
     }
+
+    screenCapture.StartRecording(dirPath + "/frame_", (PartC::ImageFormat)screenshotFormat, PartC::PngWriter::compression);
+    std::cout << "Recording to " << dirPath << " at " << screenCapture.frameRate << " fps" << std::endl;
 }
 
 bool Application::SaveScreenshot(const std::string& filePath, int format) {
-    int width = scrWidth;
-    int height = scrHeight;
-    
-    // 分配内存存储像素数据
-    unsigned char* pixels = new unsigned char[width * height * 3];
-    
-    // 从OpenGL读取像素数据
-    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
-    
-    // [修正]：直接使用原始数据，不要分配额外的 flippedPixels，也不要执行翻转循环
-    unsigned char* bufferToWrite = pixels;
+    if (filePath.empty())
+        return false;
+    if (screenshotResolution > 0) {
+        // [Tiled] 超出窗口的分辨率：分块渲染，流式写 PNG（整幅图像不驻留内存）
+        const int presetWidth[] = { 0, 3840, 7680, 15360 };
+        const int presetHeight[] = { 0, 2160, 4320, 8640 };
+        posterPath = fs::path(filePath).replace_extension(".png").string();
+        posterWidth = presetWidth[screenshotResolution];
+        posterHeight = presetHeight[screenshotResolution];
+        return true;
+    }
+    // [Capture] 不在此处 glReadPixels：由 ScreenCapture 在场景绘制后读回并在后台写盘
+    screenCapture.Request(filePath, (PartC::ImageFormat)format, PartC::PngWriter::compression);
+    return true;
+}
 
-    bool success = false;
-    
-    if (format == 0) { // BMP格式
-        std::ofstream file(filePath, std::ios::binary);
-        if (!file) {
-            delete[] pixels;
-            return false;
-        }
-        
-        int rowSize = ((width * 24 + 31) / 32) * 4;
-        int imageSize = rowSize * height;
-        int fileSize = sizeof(BMPHeader) + imageSize;
-        
-        BMPHeader header;
-        header.fileSize = fileSize;
-        header.dataOffset = sizeof(BMPHeader);
-        header.width = width;
-        header.height = height;
-        header.imageSize = imageSize;
-        
-        file.write(reinterpret_cast<const char*>(&header), sizeof(BMPHeader));
-        
-        // 直接正序写入原始数据
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                int index = (y * width + x) * 3;
-                // BMP使用BGR顺序
-                file.write(reinterpret_cast<const char*>(&bufferToWrite[index + 2]), 1); // B
-                file.write(reinterpret_cast<const char*>(&bufferToWrite[index + 1]), 1); // G
-                file.write(reinterpret_cast<const char*>(&bufferToWrite[index]), 1);     // R
-            }
-            int padding = rowSize - width * 3;
-            for (int p = 0; p < padding; p++) {
-                file.write("\0", 1);
-            }
-        }
-        
-        file.close();
-        success = true;
-    } else if (format == 1) { // PNG格式（简化实现，实际项目中建议使用libpng）
-        std::ofstream file(filePath, std::ios::binary);
-        if (!file) {
-            delete[] pixels;
-            return false;
+bool Application::RenderTiledScreenshot(const std::string& filePath, int width, int height) {
+    if (!camera || !scene)
+        return false;
+    fs::path parent = fs::path(filePath).parent_path();
+    std::error_code error;
+    if (!parent.empty())
+        fs::create_directories(parent, error);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    glm::mat4 projection = glm::perspective(glm::radians(camera->Zoom), (float)width / (float)height, 0.1f, 100.0f);
+    PartC::TiledCapture capture;
+    bool ok = capture.Begin(filePath, width, height, projection, PartC::PngWriter::compression);
+    for (int row = 0; ok && row < capture.Rows(); row++) {
+        for (int column = 0; column < capture.Columns(); column++) {
+            PartC::CaptureTile tile = capture.Tile(row, column);
+            SceneView sceneView;
+            sceneView.projection = tile.projection;
+            sceneView.cascadeProjection = projection;
+            sceneView.framebuffer = capture.Framebuffer();
+            sceneView.width = tile.width;
+            sceneView.height = tile.height;
+            RenderScene(sceneView);
+            capture.ReadTile(tile);
         }
-        
-        // 写入PNG文件头（简化版，实际PNG格式更复杂）
-        file.write("\x89PNG\r\n\x1a\n", 8);
-        
-        // 这里仅作为示例，实际PNG格式需要更多的处理
-        // 包括IHDR、IDAT等块的写入
-        file.close();
-        success = true;
+        ok = capture.EndRow(row);
     }
-    
-    // 释放内存 (注意：现在不需要释放 flippedPixels 了，因为它不存在)
-    delete[] pixels;
-    
-    return success;
+    size_t stripBytes = capture.StripBytes();
+    ok = capture.End() && ok;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, scrWidth, scrHeight);
+    float seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+    if (ok)
+        std::cout << "[Tiled] " << filePath << ": " << width << "x" << height << " in " << capture.Rows() << "x"
+                  << capture.Columns() << " tiles, " << seconds << " s, strip buffer "
+                  << stripBytes / (1024 * 1024) << " MB" << std::endl;
+    else
+        std::cerr << "Failed to save tiled screenshot: " << filePath << std::endl;
+    return ok;
 }
 
 void Application::RenderScreenshotDialog() {
@@ -541,6 +373,13 @@ void Application::RenderScreenshotDialog() {
     // 格式选择
     const char* formatNames[] = { "BMP", "PNG" };
     ImGui::Combo("Format", &screenshotFormat, formatNames, IM_ARRAYSIZE(formatNames));
+    // [Tiled] 高于窗口的分辨率分块渲染，总是 PNG
+    const char* resolutionNames[] = { "Window", "4K (3840x2160)", "8K (7680x4320)", "16K (15360x8640)" };
+    ImGui::Combo("Resolution", &screenshotResolution, resolutionNames, IM_ARRAYSIZE(resolutionNames));
+    if (screenshotResolution > 0) {
+        ImGui::SliderInt("Tile Size", &PartC::TiledCapture::tileSize, 256, 4096);
+        ImGui::TextDisabled("Rendered in tiles and streamed to PNG");
+    }
     
     // 保存路径
     ImGui::Text("Save Path:");
@@ -556,7 +395,7 @@ void Application::RenderScreenshotDialog() {
     if (ImGui::Button("Save", ImVec2(100, 0))) {
         bool success = SaveScreenshot(screenshotPathBuffer, screenshotFormat);
         if (success) {
-            std::cout << "Screenshot saved to: " << screenshotPathBuffer << std::endl;
+            std::cout << "Screenshot queued: " << screenshotPathBuffer << std::endl;
         } else {
             std::cerr << "Failed to save screenshot!" << std::endl;
         }
@@ -832,6 +671,149 @@ void Application::OpenFileDialog(char *buffer, const std::string &title, const s
     }
 }
 
+int Application::RunHeadless(const HeadlessOptions &options)
+{
+    PartC::Renderer::headless = true;
+    InitScene();
+    if (!options.scenePath.empty())
+        scene->LoadScene(options.scenePath);
+    // [LOD] 每帧结果可复现：所有简化链在计时前完成
+    for (SceneObject *obj : scene->objects)
+        PartC::MeshLOD::BuildChain(obj, true);
+
+    float aspectRatio = (scrHeight > 0) ? (float)scrWidth / (float)scrHeight : 1.0f;
+    glm::mat4 projection = glm::perspective(glm::radians(camera->Zoom), aspectRatio, 0.1f, 100.0f);
+    glm::mat4 view = camera->GetViewMatrix();
+
+    PartC::SoftwareRasterizer rasterizer(scrWidth, scrHeight);
+    int frames = std::max(1, options.frames);
+    float minMs = 1e30f, maxMs = 0.0f;
+    float shadowMs = 0.0f, mainMs = 0.0f, totalMs = 0.0f;
+    PartC::SoftwareFrameStats counts; // identical every frame, taken from the first
+
+    for (int i = 0; i < frames; i++)
+    {
+        PartC::SoftwareFrameStats frame;
+        rasterizer.Render(scene->objects, view, projection, camera->Position, frame);
+        if (i == 0)
+            counts = frame;
+        minMs = std::min(minMs, frame.totalMs);
+        maxMs = std::max(maxMs, frame.totalMs);
+        shadowMs += frame.shadowMs;
+        mainMs += frame.mainMs;
+        totalMs += frame.totalMs;
+    }
+    float avgMs = totalMs / frames;
+
+    // [Headless] RGB8, row 0 at the bottom (glReadPixels order); .png 输出用 PNG 编码
+    const uint8_t *pixels = rasterizer.GetColorBuffer().data();
+    PartC::ImageFormat outputFormat = fs::path(options.outputPath).extension() == ".png" ? PartC::ImageFormat::PNG
+                                                                                          : PartC::ImageFormat::BMP;
+    bool saved = PartC::ImageWriter::Write(options.outputPath, pixels, scrWidth, scrHeight, 3, outputFormat,
+                                           PartC::PngWriter::compression);
+    if (!saved)
+        std::cerr << "Failed to write image: " << options.outputPath << std::endl;
+
+    // [PNG] 同一帧分别写 BMP / PNG Fast / PNG Default，按原始 RGB 字节计 MB/s
+    struct ImageBench
+    {
+        const char *name;
+        std::string path;
+        float ms = 0.0f;
+        double mbPerSec = 0.0;
+        uintmax_t fileBytes = 0;
+    };
+    std::vector<ImageBench> imageBench;
+    if (options.imageBench)
+    {
+        const std::string stem = (fs::path(options.outputPath).parent_path() / fs::path(options.outputPath).stem()).string();
+        imageBench = {{"bmp", stem + "_bench.bmp"}, {"pngFast", stem + "_bench_fast.png"},
+                      {"pngDefault", stem + "_bench_default.png"}};
+        const double rawMB = (double)scrWidth * scrHeight * 3 / (1024.0 * 1024.0);
+        for (size_t i = 0; i < imageBench.size(); i++)
+        {
+            ImageBench &bench = imageBench[i];
+            bench.ms = 1e30f;
+            for (int run = 0; run < 3; run++) // best of 3: the first run also warms the page cache
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+                bool ok = i == 0 ? PartC::ImageWriter::WriteBMP(bench.path, pixels, scrWidth, scrHeight, 3)
+                                 : PartC::ImageWriter::WritePNG(bench.path, pixels, scrWidth, scrHeight, 3,
+                                                                i == 1 ? PartC::PngCompression::Fast
+                                                                       : PartC::PngCompression::Default);
+                float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                if (!ok)
+                {
+                    std::cerr << "Failed to write image: " << bench.path << std::endl;
+                    break;
+                }
+                bench.ms = std::min(bench.ms, ms);
+            }
+            std::error_code error;
+            bench.fileBytes = fs::file_size(bench.path, error);
+            bench.mbPerSec = bench.ms > 0.0f && bench.ms < 1e30f ? rawMB / (bench.ms / 1000.0) : 0.0;
+            std::cout << "[Headless] image " << bench.name << ": " << bench.ms << " ms, " << bench.mbPerSec
+                      << " MB/s, " << bench.fileBytes << " bytes" << std::endl;
+        }
+    }
+
+    std::cout << "[Headless] " << scrWidth << "x" << scrHeight << ", " << frames << " frame(s), "
+              << counts.objects << " objects, " << counts.triangles << " triangles, "
+              << counts.pixelsShaded << " pixels shaded" << std::endl;
+    if (counts.meshlets.tested > 0)
+        std::cout << "[Headless] meshlets " << counts.meshlets.tested << " tested, " << counts.meshlets.frustumCulled
+                  << " frustum / " << counts.meshlets.coneCulled << " cone culled, "
+                  << counts.meshlets.trianglesDrawn << " / " << counts.meshlets.trianglesTested << " triangles"
+                  << std::endl;
+    if (PartC::Renderer::enableOcclusionCulling)
+        std::cout << "[Headless] occlusion " << counts.occlusion.occluders << " occluders, " << counts.occlusion.tested
+                  << " tested, " << counts.occlusion.culled << " culled (" << counts.occlusion.CulledFraction() * 100.0f
+                  << "%)" << std::endl;
+    std::cout << "[Headless] frame ms avg " << avgMs << " min " << minMs << " max " << maxMs
+              << " (shadow " << shadowMs / frames << ", main " << mainMs / frames << ")" << std::endl;
+
+    if (!options.timingPath.empty())
+    {
+        std::ofstream timing(options.timingPath);
+        if (!timing)
+        {
+            std::cerr << "Failed to write timing report: " << options.timingPath << std::endl;
+            return 1;
+        }
+        timing << "{\n"
+               << "  \"width\": " << scrWidth << ",\n"
+               << "  \"height\": " << scrHeight << ",\n"
+               << "  \"frames\": " << frames << ",\n"
+               << "  \"objects\": " << counts.objects << ",\n"
+               << "  \"triangles\": " << counts.triangles << ",\n"
+               << "  \"lodTrianglesFull\": " << counts.lod.trianglesFull << ",\n"
+               << "  \"lodTrianglesDrawn\": " << counts.lod.trianglesDrawn << ",\n"
+               << "  \"meshletsTested\": " << counts.meshlets.tested << ",\n"
+               << "  \"meshletsFrustumCulled\": " << counts.meshlets.frustumCulled << ",\n"
+               << "  \"meshletsConeCulled\": " << counts.meshlets.coneCulled << ",\n"
+               << "  \"meshletTrianglesDrawn\": " << counts.meshlets.trianglesDrawn << ",\n"
+               << "  \"occlusionOccluders\": " << counts.occlusion.occluders << ",\n"
+               << "  \"occlusionTested\": " << counts.occlusion.tested << ",\n"
+               << "  \"occlusionCulled\": " << counts.occlusion.culled << ",\n"
+               << "  \"occlusionCulledFraction\": " << counts.occlusion.CulledFraction() << ",\n"
+               << "  \"pixelsShaded\": " << counts.pixelsShaded << ",\n"
+               << "  \"frameMsAvg\": " << avgMs << ",\n"
+               << "  \"frameMsMin\": " << minMs << ",\n"
+               << "  \"frameMsMax\": " << maxMs << ",\n"
+               << "  \"shadowMsAvg\": " << shadowMs / frames << ",\n"
+               << "  \"mainMsAvg\": " << mainMs / frames;
+        for (const ImageBench &bench : imageBench)
+        {
+            timing << ",\n  \"" << bench.name << "Ms\": " << bench.ms << ",\n"
+                   << "  \"" << bench.name << "MBps\": " << bench.mbPerSec << ",\n"
+                   << "  \"" << bench.name << "Bytes\": " << bench.fileBytes;
+        }
+        timing << "\n}\n";
+    }
+
+    return saved ? 0 : 1;
+}
+
 void Application::Run()
 {
     if (!InitGLFW())
@@ -845,6 +827,9 @@ void Application::Run()
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        // [Record] 录制时模拟按固定步长推进，与实际帧耗时无关
+        if (screenCapture.IsRecording())
+            deltaTime = screenCapture.FixedDeltaTime();
 
         ProcessInput();
 
@@ -890,10 +875,20 @@ void Application::Run()
             }
         }
 
+        // [TextureManager] 后台解码完成的纹理在 GL 线程上传，每帧限时
+        PartC::TextureManager::ProcessUploads(PartC::TextureManager::uploadBudgetMs);
+
         glClearColor(0.12f, 0.12f, 0.12f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         RenderScene();
+        // [Capture] 场景已在后缓冲、UI 尚未绘制：发起 PBO 读回，交出上一帧完成的读回
+        screenCapture.EndFrame(scrWidth, scrHeight);
+        // [Tiled] 海报截图在离屏缓冲中逐块绘制，不影响本帧的后缓冲
+        if (!posterPath.empty()) {
+            RenderTiledScreenshot(posterPath, posterWidth, posterHeight);
+            posterPath.clear();
+        }
         RenderUI();
 
         glfwSwapBuffers(window);
@@ -1086,81 +1081,210 @@ void Application::ProcessDrag(double xpos, double ypos)
 
 // --------------------------------------------------------
 
+void Application::SelectLods(const glm::mat4 &projection)
+{
+    // [LOD] One level per object for the frame, shared by the shadow and main passes
+    lodMeshes.resize(cullingBounds.Size());
+    for (size_t i = 0; i < cullingBounds.Size(); i++)
+    {
+        SceneObject *obj = cullingBounds.objects[i];
+        if (!PartC::Renderer::enableLod)
+        {
+            lodMeshes[i] = obj->mesh.get();
+            continue;
+        }
+        glm::vec3 bmin(cullingBounds.minX[i], cullingBounds.minY[i], cullingBounds.minZ[i]);
+        glm::vec3 bmax(cullingBounds.maxX[i], cullingBounds.maxY[i], cullingBounds.maxZ[i]);
+        float screenSize = PartC::MeshLOD::ScreenSize(bmin, bmax, camera->Position, projection);
+        lodMeshes[i] = PartC::MeshLOD::Select(obj, screenSize, PartC::Renderer::stats.lod);
+    }
+}
+
+void Application::SubmitShadowCasters(const std::vector<uint32_t> &casters)
+{
+    // [RenderQueue] Use depth shader (managed internally by Renderer)
+    shadowQueue.Clear();
+    for (uint32_t idx : casters)
+    {
+        SceneObject *obj = cullingBounds.objects[idx];
+        PartC::DrawCommand cmd;
+        cmd.pass = PartC::RenderQueue::PASS_SHADOW;
+        cmd.shader = PartC::Renderer::depthShader;
+        cmd.mesh = lodMeshes[idx];
+        cmd.model = obj->GetModelMatrix();
+        shadowQueue.Submit(cmd, 0.0f);
+    }
+    shadowQueue.Sort(PartC::Renderer::enableDrawSorting, PartC::Renderer::stats.queue);
+    PartC::Renderer::ExecuteQueue(shadowQueue);
+}
+
+void Application::RenderShadowCascades()
+{
+    PartC::RenderStats &stats = PartC::Renderer::stats;
+
+    // [CSM] One depth pass per cascade; casters outside a cascade's ortho volume
+    // would be clipped anyway, so each cascade culls against its own matrix.
+    // Not against its near plane: with the shadow cache zNear only covers the static
+    // casters, and anything closer to the light is still drawn through depth clamp
+    for (int c = 0; c < PartC::CASCADE_COUNT; c++)
+    {
+        if (PartC::Renderer::enableFrustumCulling)
+            PartC::Culling::FrustumCull(
+                PartC::Frustum::FromMatrix(PartC::Renderer::cascades[c].lightSpaceMatrix).WithoutNearPlane(),
+                cullingBounds, shadowVisible, stats.shadowCull);
+        else
+            PartC::Culling::SelectAll(cullingBounds, shadowVisible, stats.shadowCull);
+        stats.cascadeCasters[c] = (int)shadowVisible.size();
+
+        if (!PartC::Renderer::enableShadowCache)
+        {
+            PartC::Renderer::BeginShadowMap(c);
+            SubmitShadowCasters(shadowVisible);
+            continue;
+        }
+
+        // [Shadow Cache] 静态投射体只在签名变化（光源/级联移动或静态物体改变）时重画
+        staticCasters.clear();
+        dynamicCasters.clear();
+        for (uint32_t idx : shadowVisible)
+        {
+            if (cullingBounds.objects[idx]->isStatic)
+                staticCasters.push_back(idx);
+            else
+                dynamicCasters.push_back(idx);
+        }
+
+        PartC::ShadowCacheEntry &cache = PartC::Renderer::shadowCache[c];
+        uint64_t signature = PartC::Renderer::ShadowCacheSignature(c, cullingBounds, staticCasters, lodMeshes);
+        if (!cache.valid || cache.signature != signature)
+        {
+            PartC::Renderer::BeginStaticShadowMap(c);
+            SubmitShadowCasters(staticCasters);
+            cache.signature = signature;
+            cache.valid = true;
+            stats.shadowCache.rebuilds++;
+            stats.shadowCache.staticDraws += (int)staticCasters.size();
+        }
+        else
+        {
+            stats.shadowCache.staticSkipped += (int)staticCasters.size();
+        }
+
+        PartC::Renderer::BeginShadowMapFromCache(c);
+        SubmitShadowCasters(dynamicCasters);
+        stats.shadowCache.dynamicDraws += (int)dynamicCasters.size();
+    }
+    PartC::Renderer::EndShadowMap(scrWidth, scrHeight);
+}
+
 void Application::RenderScene()
+{
+    if (!camera)
+        return;
+
+    // 确保宽高比有效，避免GLM断言错误
+    float aspectRatio = (scrHeight > 0) ? (float)scrWidth / (float)scrHeight : 1.0f;
+    SceneView sceneView;
+    sceneView.projection = glm::perspective(glm::radians(camera->Zoom), aspectRatio, 0.1f, 100.0f);
+    sceneView.cascadeProjection = sceneView.projection;
+    sceneView.width = scrWidth;
+    sceneView.height = scrHeight;
+    RenderScene(sceneView);
+}
+
+void Application::RenderScene(const SceneView &sceneView)
 {
     if (!mainShader || !scene || !camera)
         return;
 
+    PartC::Renderer::ResetStats();
+
+    const glm::mat4 &projection = sceneView.projection;
+    glm::mat4 view = camera->GetViewMatrix();
+
+    // [Culling] World AABBs are gathered once and shared by all passes
+    cullingBounds.Build(scene->objects);
+
+    // [UBO] 相机与光照数据每帧只上传一次，所有着色器共享（级联在此拟合）
+    PartC::Renderer::UpdateFrameUniforms(view, projection, sceneView.cascadeProjection, camera->Position,
+                                         cullingBounds);
+    // [Tiled] 分块时 projection[1][1] 按行数放大：LOD 按海报的像素密度选择
+    SelectLods(projection);
+
     // ------------------------------------------------
     // 1. Render Shadow Map (Pass 1)
     // ------------------------------------------------
-    PartC::Renderer::BeginShadowMap();
-    for (auto obj : scene->objects)
-    {
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, obj->position);
-        model = glm::rotate(model, glm::radians(obj->rotation.x), glm::vec3(1, 0, 0));
-        model = glm::rotate(model, glm::radians(obj->rotation.y), glm::vec3(0, 1, 0));
-        model = glm::rotate(model, glm::radians(obj->rotation.z), glm::vec3(0, 0, 1));
-        model = glm::scale(model, obj->scale);
-
-        // Use depth shader (managed internally by Renderer)
-        PartC::Renderer::depthShader->setMat4("model", model);
-        if (obj->mesh)
-            obj->mesh->Draw(*PartC::Renderer::depthShader);
-    }
-    PartC::Renderer::EndShadowMap(scrWidth, scrHeight);
+    RenderShadowCascades();
 
     // ------------------------------------------------
     // 2. Render Scene Normally (Pass 2)
     // ------------------------------------------------
-    glViewport(0, 0, scrWidth, scrHeight);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneView.framebuffer);
+    glViewport(0, 0, sceneView.width, sceneView.height);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    mainShader->use();
-    // 确保宽高比有效，避免GLM断言错误
-    float aspectRatio = (scrHeight > 0) ? (float)scrWidth / (float)scrHeight : 1.0f;
-    glm::mat4 projection = glm::perspective(glm::radians(camera->Zoom), aspectRatio, 0.1f, 100.0f);
-    glm::mat4 view = camera->GetViewMatrix();
-    mainShader->setMat4("projection", projection);
-    mainShader->setMat4("view", view);
-
     // [Part C] Use Renderer to setup lights (includes shadow map binding)
-    PartC::Renderer::SetupLights(*mainShader, camera->Position);
+    PartC::Renderer::SetupLights(*mainShader);
 
-    for (auto obj : scene->objects)
+    if (PartC::Renderer::enableFrustumCulling)
+        PartC::Culling::FrustumCull(PartC::Frustum::FromMatrix(projection * view),
+                                    cullingBounds, mainVisible, PartC::Renderer::stats.mainCull);
+    else
+        PartC::Culling::SelectAll(cullingBounds, mainVisible, PartC::Renderer::stats.mainCull);
+
+    // [Culling] 遮挡剔除：大物体光栅化到 CPU 深度缓冲，其余物体用 Hi-Z 测试
+    if (PartC::Renderer::enableOcclusionCulling)
+        occlusionBuffer.Cull(cullingBounds, mainVisible, projection * view, PartC::Renderer::stats.occlusion);
+
+    // [RenderQueue] 收集绘制命令，按 (pass, shader, texture, depth, mesh) 排序后执行
+    const float farPlane = 100.0f;
+    const glm::mat4 viewProjection = projection * view;
+    const glm::vec2 viewport((float)sceneView.width, (float)sceneView.height);
+    mainQueue.Clear();
+    // [VT] 本帧提交的绘制即反馈：所需页面在执行队列前选出并上传
+    PartC::VirtualTexture::BeginFrameAll();
+    for (uint32_t idx : mainVisible)
     {
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, obj->position);
-        model = glm::rotate(model, glm::radians(obj->rotation.x), glm::vec3(1, 0, 0));
-        model = glm::rotate(model, glm::radians(obj->rotation.y), glm::vec3(0, 1, 0));
-        model = glm::rotate(model, glm::radians(obj->rotation.z), glm::vec3(0, 0, 1));
-        model = glm::scale(model, obj->scale);
-
-        // [Part C] Use Renderer to render mesh
-        mainShader->setVec3("albedo", obj->color);
-        mainShader->setFloat("roughness", obj->roughness);
-        mainShader->setFloat("metallic", obj->metallic);
-        PartC::Renderer::RenderMesh(obj->mesh, *mainShader, model);
+        SceneObject *obj = cullingBounds.objects[idx];
+
+        PartC::DrawCommand cmd;
+        cmd.pass = PartC::RenderQueue::PASS_OPAQUE;
+        cmd.shader = mainShader;
+        cmd.mesh = lodMeshes[idx];
+        cmd.model = obj->GetModelMatrix();
+        cmd.albedo = obj->color;
+        cmd.roughness = obj->roughness;
+        cmd.metallic = obj->metallic;
+        cmd.clusterCull = true;
+
+        glm::vec3 center(0.5f * (cullingBounds.minX[idx] + cullingBounds.maxX[idx]),
+                         0.5f * (cullingBounds.minY[idx] + cullingBounds.maxY[idx]),
+                         0.5f * (cullingBounds.minZ[idx] + cullingBounds.maxZ[idx]));
+        float depth = glm::length(center - camera->Position) / farPlane;
+        mainQueue.Submit(cmd, depth);
+
+        for (const Texture &texture : cmd.mesh->textures)
+        {
+            if (texture.type != "diffuse")
+                continue;
+            if (PartC::VirtualTexture *virtualTexture = texture.Virtual())
+                virtualTexture->AddFeedback(*cmd.mesh, viewProjection * cmd.model, viewport);
+            break;
+        }
 
         if (obj == scene->selectedObject)
         {
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            glLineWidth(2.5f);
-            glm::mat4 highlightModel = glm::scale(model, glm::vec3(1.005f));
-            mainShader->setMat4("model", highlightModel);
-
-            // Note: Highlight shader logic might need adjustment if it relies on objectColor
-            // For now, we just draw lines on top.
-            // mainShader->setVec3("objectColor", glm::vec3(1.0f, 1.0f, 0.0f));
-
-            if (obj->mesh)
-                obj->mesh->Draw(*mainShader);
-
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            glLineWidth(1.0f);
+            // Selection outline: drawn as lines after all opaque objects
+            cmd.pass = PartC::RenderQueue::PASS_HIGHLIGHT;
+            cmd.model = glm::scale(cmd.model, glm::vec3(1.005f));
+            cmd.wireframe = true;
+            cmd.clusterCull = false;
+            mainQueue.Submit(cmd, depth);
         }
     }
+    mainQueue.Sort(PartC::Renderer::enableDrawSorting, PartC::Renderer::stats.queue);
+    PartC::VirtualTexture::UpdateAll();
+    PartC::Renderer::ExecuteQueue(mainQueue);
 
     // Draw Gizmos (Editor Debug)
     if (scene && !isRuntime)
@@ -1198,6 +1322,8 @@ void Application::RenderUI()
     if (ImGui::Button("Load Scene", ImVec2(135, 0)))
     {
         scene->LoadScene(sceneFilePath);
+        // New objects may reuse freed addresses, so signatures alone are not enough
+        PartC::Renderer::InvalidateShadowCache();
     }
     ImGui::Separator();
 
@@ -1229,6 +1355,90 @@ void Application::RenderUI()
         ImGui::DragFloat3("Light Color", (float *)&PartC::Renderer::mainLight.diffuse, 0.1f, 0.0f, 20.0f);
         ImGui::ColorEdit3("Ambient", (float *)&PartC::Renderer::mainLight.ambient);
     }
+
+    // [新增] 渲染统计
+    if (ImGui::CollapsingHeader("Render Stats"))
+    {
+        const PartC::RenderStats &stats = PartC::Renderer::stats;
+        ImGui::Checkbox("Frustum Culling", &PartC::Renderer::enableFrustumCulling);
+        ImGui::Text("Main:   %d visible / %d culled", stats.mainCull.visible, stats.mainCull.culled);
+        ImGui::Text("Shadow: %d visible / %d culled", stats.shadowCull.visible, stats.shadowCull.culled);
+        ImGui::Text("Cascades: %d / %d / %d / %d casters", stats.cascadeCasters[0], stats.cascadeCasters[1],
+                    stats.cascadeCasters[2], stats.cascadeCasters[3]);
+        ImGui::DragFloat("Shadow Distance", &PartC::Renderer::shadowDistance, 1.0f, 5.0f, 100.0f);
+        ImGui::SliderFloat("Split Lambda", &PartC::Renderer::cascadeSplitLambda, 0.0f, 1.0f);
+        if (ImGui::Checkbox("Shadow Cache", &PartC::Renderer::enableShadowCache))
+            PartC::Renderer::InvalidateShadowCache();
+        ImGui::Text("  rebuilt %d cascades, static %d drawn / %d cached, dynamic %d",
+                    stats.shadowCache.rebuilds, stats.shadowCache.staticDraws,
+                    stats.shadowCache.staticSkipped, stats.shadowCache.dynamicDraws);
+        ImGui::Checkbox("Occlusion Culling", &PartC::Renderer::enableOcclusionCulling);
+        ImGui::Text("Occluders: %d (%d tris), raster %.2f ms", stats.occlusion.occluders,
+                    stats.occlusion.occluderTriangles, stats.occlusion.rasterMs);
+        ImGui::Text("Occluded: %d / %d (%.0f%%)", stats.occlusion.culled, stats.occlusion.tested,
+                    stats.occlusion.CulledFraction() * 100.0f);
+        ImGui::Checkbox("Sort Draw Calls", &PartC::Renderer::enableDrawSorting);
+        ImGui::Text("Draws: %d, sort %.3f ms", stats.queue.commands, stats.queue.sortMs);
+        ImGui::Text("State changes: %d unsorted -> %d executed", stats.queue.unsorted.Total(), stats.queue.sorted.Total());
+        ImGui::Text("  shader %d/%d  vao %d/%d  tex %d/%d", stats.queue.unsorted.shaders, stats.queue.sorted.shaders,
+                    stats.queue.unsorted.meshes, stats.queue.sorted.meshes,
+                    stats.queue.unsorted.textures + stats.queue.unsorted.textureToggles,
+                    stats.queue.sorted.textures + stats.queue.sorted.textureToggles);
+        ImGui::Text("  polygon mode %d/%d", stats.queue.unsorted.polygonModes, stats.queue.sorted.polygonModes);
+        ImGui::Checkbox("Mesh LOD", &PartC::Renderer::enableLod);
+        ImGui::Text("LOD: %lld / %lld tris, levels %d %d %d %d %d", stats.lod.trianglesDrawn, stats.lod.trianglesFull,
+                    stats.lod.levelCounts[0], stats.lod.levelCounts[1], stats.lod.levelCounts[2],
+                    stats.lod.levelCounts[3], stats.lod.levelCounts[4]);
+        ImGui::Checkbox("Meshlet Culling", &PartC::Renderer::enableMeshletCulling);
+        ImGui::SameLine();
+        ImGui::Checkbox("Cone", &PartC::Renderer::enableConeCulling);
+        ImGui::Text("Meshlets: %d tested, %d frustum / %d cone culled, %d ranges in %d draws",
+                    stats.meshlets.tested, stats.meshlets.frustumCulled, stats.meshlets.coneCulled,
+                    stats.meshlets.ranges, stats.meshlets.draws);
+        ImGui::Text("  %lld / %lld tris drawn", stats.meshlets.trianglesDrawn, stats.meshlets.trianglesTested);
+        ImGui::Text("Uniforms: %d uploads, %d skipped, %d by name", Shader::stats.uploads,
+                    Shader::stats.skipped, Shader::stats.nameLookups);
+        PartC::TextureCacheStats texStats = PartC::TextureManager::Stats();
+        ImGui::Text("Textures: %d cached (%d in use), %.1f / %.0f MB", texStats.entries, texStats.referenced,
+                    texStats.bytes / 1048576.0, texStats.budgetBytes / 1048576.0);
+        ImGui::Text("  %d decodes, %d cache hits, %d evicted", texStats.decodes, texStats.hits, texStats.evictions);
+        ImGui::SameLine();
+        if (ImGui::Button("Trim Unused"))
+            PartC::TextureManager::Trim(0);
+        ImGui::Checkbox("Async Decode", &PartC::TextureManager::asyncDecode);
+        ImGui::SameLine();
+        ImGui::SliderFloat("Upload ms", &PartC::TextureManager::uploadBudgetMs, 0.5f, 16.0f);
+        ImGui::Text("  streaming: %d decoding, %d to upload, %d uploaded (%.2f ms)", texStats.pendingDecodes,
+                    texStats.pendingUploads, texStats.frameUploads, texStats.frameUploadMs);
+        // [Mips] 对新构建的 mip 链生效；已有 .texcache 若滤波器不同会在下次加载时重建
+        ImGui::Checkbox("Texture Cache", &PartC::TextureContainer::useTextureCache);
+        ImGui::SameLine();
+        bool kaiser = PartC::TextureContainer::mipFilter == PartC::MipFilter::Kaiser;
+        if (ImGui::Checkbox("Kaiser Mips", &kaiser))
+            PartC::TextureContainer::mipFilter = kaiser ? PartC::MipFilter::Kaiser : PartC::MipFilter::Box;
+        static const char *compressionNames[] = {"None", "BC1", "BC3", "BC7"};
+        int compression = (int)PartC::TextureContainer::compression;
+        if (ImGui::Combo("Compression", &compression, compressionNames, IM_ARRAYSIZE(compressionNames)))
+            PartC::TextureContainer::compression = (PartC::BlockFormat)compression;
+        ImGui::Text("  %d loaded from .texcache, %d block-compressed, %d decoded to RGBA", texStats.containerLoads,
+                    texStats.compressed, texStats.blockFallbacks);
+        // [Atlas] 只影响之后加载的纹理
+        PartC::TextureAtlasStats atlasStats = PartC::TextureAtlas::Stats();
+        ImGui::Checkbox("Texture Atlas", &PartC::TextureAtlas::enabled);
+        ImGui::SameLine();
+        ImGui::Text("%d textures in %d / %d layers, %.0f%% full, %d rejected", atlasStats.textures, atlasStats.layers,
+                    atlasStats.capacity, atlasStats.occupancy * 100.0f, atlasStats.rejected);
+        // [VT] 只影响之后加载的纹理；反馈与页面上传每帧进行
+        PartC::VirtualTextureStats vtStats = PartC::VirtualTexture::TotalStats();
+        ImGui::Checkbox("Virtual Textures", &PartC::VirtualTexture::enabled);
+        ImGui::SameLine();
+        ImGui::Text("%d open", texStats.virtualTextures);
+        ImGui::SliderInt("VT uploads / frame", &PartC::VirtualTexture::uploadsPerFrame, 1, 64);
+        ImGui::SliderFloat("VT LOD bias", &PartC::VirtualTextureFeedback::lodBias, -2.0f, 2.0f);
+        ImGui::Text("  pages: %d wanted, %d missing, %d loading, %d / %d resident", vtStats.requested, vtStats.missing,
+                    vtStats.loading, vtStats.resident, vtStats.slots);
+        ImGui::Text("  %d evicted, %d loads dropped (cache full)", vtStats.evictions, vtStats.dropped);
+    }
     ImGui::Dummy(ImVec2(0, 10));
 
     ImGui::Text("SCENE HIERARCHY");
@@ -1374,6 +1584,8 @@ void Application::RenderUI()
             SceneObject *newObj = new SceneObject("Imported Model", imported);
             newObj->meshPath = objPathBuffer;
             scene->AddObject(newObj);
+            // [LOD] 简化链在后台构建，完成前绘制原网格
+            PartC::MeshLOD::BuildChain(newObj);
         }
         else
         {
@@ -1381,6 +1593,20 @@ void Application::RenderUI()
         }
     }
 
+    // [MeshOpt] 导入后的顶点缓存 / 过度绘制优化（结果缓存在 <file>.meshcache）
+    ImGui::Checkbox("Optimize Index Order", &PartC::MeshOptimizer::optimizeOnLoad);
+    ImGui::SameLine();
+    ImGui::Checkbox("Overdraw##meshopt", &PartC::MeshOptimizer::reorderForOverdraw);
+    const PartC::MeshOptimizeReport &meshOpt = PartC::MeshOptimizer::lastReport;
+    if (meshOpt.triangles > 0)
+    {
+        if (meshOpt.fromCache)
+            ImGui::TextDisabled("ACMR %.3f -> %.3f (cached)", meshOpt.before.acmr, meshOpt.after.acmr);
+        else
+            ImGui::TextDisabled("ACMR %.3f -> %.3f, %zu -> %zu verts, %.1f ms", meshOpt.before.acmr, meshOpt.after.acmr,
+                                meshOpt.verticesIn, meshOpt.verticesOut, meshOpt.ms);
+    }
+
     // [新增] 加载动画序列 UI
     ImGui::Dummy(ImVec2(0, 10));
     ImGui::Text("Import Animation Sequence");
@@ -1408,11 +1634,12 @@ void Application::RenderUI()
             // 调用新的 LoadSequence 接口
             std::vector<Mesh*> sequence = OBJLoader::LoadSequence(animPathBuffer); 
             if (!sequence.empty()) {
-                // 创建单个动画对象
-                SceneObject* animatedObj = new SceneObject("Animated Model", sequence[0]);
+                // 创建单个动画对象 (帧网格由对象持有，当前帧与 animationFrames 共用同一份)
+                std::vector<std::shared_ptr<Mesh>> frames(sequence.begin(), sequence.end());
+                SceneObject* animatedObj = new SceneObject("Animated Model", frames[0]);
                 animatedObj->position = glm::vec3(0, 0.5f, 0);
                 animatedObj->isAnimated = true;
-                animatedObj->animationFrames = sequence;
+                animatedObj->animationFrames = frames;
                 animatedObj->isPlaying = true;
                 animatedObj->animationSpeed = 1.0f;
                 animatedObj->loopAnimation = loopAnimation;
@@ -1436,6 +1663,44 @@ void Application::RenderUI()
     ImGui::Checkbox("Loop Animation", &loopAnimation);
     ImGui::SliderFloat("Start Delay", &animationStartDelay, 0.0f, 5.0f, "%.1fs");
     
+    // [QEM] 网格简化：用简化结果替换选中导入模型的网格
+    SceneObject *simplifyTarget = scene->selectedObject;
+    if (simplifyTarget && simplifyTarget->mesh && simplifyTarget->geometryType == GeometryType::None &&
+        !simplifyTarget->isAnimated)
+    {
+        ImGui::Dummy(ImVec2(0, 10));
+        ImGui::Text("SIMPLIFY");
+        ImGui::Separator();
+
+        static float simplifyRatio = 0.5f;
+        static bool simplifyKeepSeams = true;
+        static char simplifyReport[192] = "";
+        ImGui::SliderFloat("Keep Triangles", &simplifyRatio, 0.01f, 1.0f, "%.2f");
+        ImGui::Checkbox("Keep UV / Normal Seams", &simplifyKeepSeams);
+        if (ImGui::Button("Simplify Mesh", ImVec2(120, 0)))
+        {
+            PartC::SimplifyOptions options;
+            options.targetTriangles = (size_t)(simplifyTarget->mesh->indices.size() / 3 * simplifyRatio);
+            options.preserveSeams = simplifyKeepSeams;
+            PartC::SimplifyResult result = PartC::MeshSimplifier::Simplify(*simplifyTarget->mesh, options);
+            snprintf(simplifyReport, sizeof(simplifyReport), "%zu -> %zu tris, error %.4g (%.3f%%), %.0f ms",
+                     result.trianglesIn, result.trianglesOut, result.error, result.relativeError * 100.0f, result.ms);
+            std::cout << "[Simplify] " << simplifyTarget->name << ": " << simplifyReport << std::endl;
+            // The old mesh is released once no clone and no collider holds it any more
+            if (result.mesh)
+            {
+                std::shared_ptr<Mesh> simplified(result.mesh);
+                MeshColliderComponent *collider = simplifyTarget->GetComponent<MeshColliderComponent>();
+                if (collider && collider->sharedMesh == simplifyTarget->mesh)
+                    collider->SetMesh(simplified);
+                simplifyTarget->mesh = simplified;
+            }
+        }
+        if (simplifyReport[0])
+            ImGui::TextWrapped("%s", simplifyReport);
+        ImGui::TextDisabled("Scenes reload the original file; export to keep it");
+    }
+
     // [新增] 导出功能 UI
     ImGui::Dummy(ImVec2(0, 10));
     ImGui::Text("EXPORT");
@@ -1455,7 +1720,7 @@ void Application::RenderUI()
         ImGui::SameLine();
         if (ImGui::Button("Export Mesh##mesh", ImVec2(100, 0)))
         {
-            bool success = OBJLoader::ExportMesh(scene->selectedObject->mesh, exportMeshPath);
+            bool success = OBJLoader::ExportMesh(scene->selectedObject->mesh.get(), exportMeshPath);
             if (success)
             {
                 std::cout << "Successfully exported mesh to: " << exportMeshPath << std::endl;
@@ -1508,10 +1773,35 @@ void Application::RenderUI()
     // 截图格式选择
     const char* formatNames[] = { "BMP", "PNG" };
     ImGui::Combo("Format", &screenshotFormat, formatNames, IM_ARRAYSIZE(formatNames));
+    // [PNG] Fast: Up 过滤 + 短哈希链，适合连续截图；Default: 自适应过滤，文件更小
+    int pngLevel = (int)PartC::PngWriter::compression;
+    const char* pngLevelNames[] = { "Fast", "Default" };
+    if (ImGui::Combo("PNG Compression", &pngLevel, pngLevelNames, IM_ARRAYSIZE(pngLevelNames)))
+        PartC::PngWriter::compression = (PartC::PngCompression)pngLevel;
     
     // 快捷键提示
     ImGui::TextDisabled("Press F12 to take a quick screenshot");
 
+    // [Record] 固定步长录制：每帧都截图，编码跟不上时阻塞（不丢帧）或丢帧
+    if (!screenCapture.IsRecording()) {
+        ImGui::SliderInt("Record FPS", &screenCapture.frameRate, 10, 120);
+        ImGui::Checkbox("Wait For Encoder (no drops)", &screenCapture.blockWhenBehind);
+        ImGui::SliderInt("Max Queued Frames", &PartC::ScreenCapture::maxPendingEncodes, 1, 32);
+        if (ImGui::Button("Start Recording", ImVec2(120, 0)))
+            ToggleRecording();
+    } else if (ImGui::Button("Stop Recording", ImVec2(120, 0))) {
+        ToggleRecording();
+    }
+    PartC::CaptureStats captureStats = screenCapture.Stats();
+    if (captureStats.recording)
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "REC frame %d (%.2f s at %d fps), stalled %.0f ms",
+                           captureStats.recordedFrames, captureStats.recordedFrames * screenCapture.FixedDeltaTime(),
+                           screenCapture.frameRate, captureStats.stalledMs);
+    ImGui::Text("Capture: %d waiting, %d reading back, %d encoding", captureStats.requested, captureStats.readbacks,
+                captureStats.encoding);
+    ImGui::Text("  %d written, %d failed, %d dropped (map %.2f ms, encode %.1f ms)", captureStats.written,
+                captureStats.failed, captureStats.dropped, captureStats.lastMapMs, captureStats.lastEncodeMs);
+
     // ---------------- 属性面板 ----------------
     if (scene->selectedObject)
     {
@@ -1540,6 +1830,7 @@ void Application::RenderUI()
         // PBR Controls
         ImGui::SliderFloat("Roughness", &scene->selectedObject->roughness, 0.0f, 1.0f);
         ImGui::SliderFloat("Metallic", &scene->selectedObject->metallic, 0.0f, 1.0f);
+        ImGui::Checkbox("Static (cached shadows)", &scene->selectedObject->isStatic);
 
         // [新增] 纹理 UI
         ImGui::Text("Texture Path (Absolute)");
@@ -1561,10 +1852,11 @@ void Application::RenderUI()
                 // 2. 加载新纹理 (Part C 功能)
                 std::string path = texBuf;
                 Texture diffuseMap(path.c_str(), "diffuse");
-                Texture specularMap(path.c_str(), "specular"); // 暂时复用同一张图
+                Texture specularMap = diffuseMap; // 暂时复用同一张图 (TextureManager 中的同一项)
+                specularMap.type = "specular";
 
                 // 3. 应用到 Mesh
-                if (diffuseMap.id != 0)
+                if (diffuseMap.IsLoaded())
                 {
                     scene->selectedObject->mesh->textures.push_back(diffuseMap);
                     scene->selectedObject->mesh->textures.push_back(specularMap);
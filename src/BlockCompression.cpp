@@ -0,0 +1,658 @@
+#include "BlockCompression.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+namespace PartC
+{
+    namespace
+    {
+        // BC7 4-bit index weights, out of 64
+        const int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        // 4x4 texels as RGBA; texels past the edge repeat the last row / column
+        void LoadBlock(const unsigned char *pixels, int width, int height, int channels, int bx, int by, uint8_t block[64])
+        {
+            for (int y = 0; y < 4; y++)
+            {
+                int sy = std::min(by * 4 + y, height - 1);
+                for (int x = 0; x < 4; x++)
+                {
+                    int sx = std::min(bx * 4 + x, width - 1);
+                    const unsigned char *src = pixels + ((size_t)sy * width + sx) * channels;
+                    uint8_t *dst = block + (y * 4 + x) * 4;
+                    if (channels >= 3)
+                    {
+                        dst[0] = src[0];
+                        dst[1] = src[1];
+                        dst[2] = src[2];
+                        dst[3] = channels == 4 ? src[3] : 255;
+                    }
+                    else
+                    {
+                        dst[0] = dst[1] = dst[2] = src[0];
+                        dst[3] = channels == 2 ? src[1] : 255;
+                    }
+                }
+            }
+        }
+
+        float Clamp255(float v) { return std::min(255.0f, std::max(0.0f, v)); }
+
+        // Endpoints of the block's principal axis (first `dims` channels) spanning its texels
+        void FitLine(const uint8_t block[64], int dims, float lo[4], float hi[4])
+        {
+            float mean[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int i = 0; i < 16; i++)
+                for (int c = 0; c < dims; c++)
+                    mean[c] += block[i * 4 + c];
+            for (int c = 0; c < dims; c++)
+                mean[c] /= 16.0f;
+
+            float cov[4][4] = {};
+            for (int i = 0; i < 16; i++)
+            {
+                float d[4];
+                for (int c = 0; c < dims; c++)
+                    d[c] = block[i * 4 + c] - mean[c];
+                for (int a = 0; a < dims; a++)
+                    for (int b = 0; b < dims; b++)
+                        cov[a][b] += d[a] * d[b];
+            }
+
+            // Power iteration, starting from the column of the largest variance
+            int start = 0;
+            for (int c = 1; c < dims; c++)
+                if (cov[c][c] > cov[start][start])
+                    start = c;
+            float axis[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int c = 0; c < dims; c++)
+                axis[c] = cov[c][start];
+            for (int iteration = 0; iteration < 8; iteration++)
+            {
+                float next[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                float length = 0.0f;
+                for (int a = 0; a < dims; a++)
+                {
+                    for (int b = 0; b < dims; b++)
+                        next[a] += cov[a][b] * axis[b];
+                    length += next[a] * next[a];
+                }
+                if (length < 1e-12f)
+                    break;
+                length = std::sqrt(length);
+                for (int c = 0; c < dims; c++)
+                    axis[c] = next[c] / length;
+            }
+
+            float tMin = 0.0f, tMax = 0.0f;
+            for (int i = 0; i < 16; i++)
+            {
+                float t = 0.0f;
+                for (int c = 0; c < dims; c++)
+                    t += (block[i * 4 + c] - mean[c]) * axis[c];
+                tMin = std::min(tMin, t);
+                tMax = std::max(tMax, t);
+            }
+            for (int c = 0; c < dims; c++)
+            {
+                lo[c] = Clamp255(mean[c] + axis[c] * tMin);
+                hi[c] = Clamp255(mean[c] + axis[c] * tMax);
+            }
+        }
+
+        // Least squares endpoints for fixed interpolation weights (weight of `b` per texel)
+        bool SolveEndpoints(const uint8_t block[64], int dims, const float weights[16], float a[4], float b[4])
+        {
+            float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+            float ax[4] = {0.0f, 0.0f, 0.0f, 0.0f}, bx[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int i = 0; i < 16; i++)
+            {
+                float wb = weights[i], wa = 1.0f - wb;
+                aa += wa * wa;
+                bb += wb * wb;
+                ab += wa * wb;
+                for (int c = 0; c < dims; c++)
+                {
+                    ax[c] += wa * block[i * 4 + c];
+                    bx[c] += wb * block[i * 4 + c];
+                }
+            }
+            float det = aa * bb - ab * ab;
+            if (std::fabs(det) < 1e-6f)
+                return false;
+            for (int c = 0; c < dims; c++)
+            {
+                a[c] = Clamp255((ax[c] * bb - bx[c] * ab) / det);
+                b[c] = Clamp255((bx[c] * aa - ax[c] * ab) / det);
+            }
+            return true;
+        }
+
+        uint16_t To565(const float c[4])
+        {
+            int r = (int)std::lround(c[0] * 31.0f / 255.0f);
+            int g = (int)std::lround(c[1] * 63.0f / 255.0f);
+            int b = (int)std::lround(c[2] * 31.0f / 255.0f);
+            return (uint16_t)((r << 11) | (g << 5) | b);
+        }
+
+        void From565(uint16_t v, int out[3])
+        {
+            int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+            out[0] = (r << 3) | (r >> 2);
+            out[1] = (g << 2) | (g >> 4);
+            out[2] = (b << 3) | (b >> 2);
+        }
+
+        void ColorPalette(uint16_t c0, uint16_t c1, bool fourColor, int palette[4][3])
+        {
+            From565(c0, palette[0]);
+            From565(c1, palette[1]);
+            for (int c = 0; c < 3; c++)
+            {
+                if (fourColor)
+                {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+                else
+                {
+                    palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                    palette[3][c] = 0;
+                }
+            }
+        }
+
+        // Nearest of the four colours per texel, 2 bits each
+        uint32_t ColorIndices(const uint8_t block[64], const int palette[4][3], int &error)
+        {
+            uint32_t indices = 0;
+            error = 0;
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestError = 1 << 30;
+                for (int k = 0; k < 4; k++)
+                {
+                    int dr = block[i * 4] - palette[k][0], dg = block[i * 4 + 1] - palette[k][1],
+                        db = block[i * 4 + 2] - palette[k][2];
+                    int e = dr * dr + dg * dg + db * db;
+                    if (e < bestError)
+                    {
+                        bestError = e;
+                        best = k;
+                    }
+                }
+                indices |= (uint32_t)best << (2 * i);
+                error += bestError;
+            }
+            return indices;
+        }
+
+        // BC1 colour block, always in four-colour mode (BC3 ignores the endpoint order)
+        void EncodeColor(const uint8_t block[64], uint8_t out[8])
+        {
+            static const float INDEX_WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+            float hi[4], lo[4];
+            FitLine(block, 3, lo, hi);
+
+            uint16_t bestC0 = 0, bestC1 = 0;
+            uint32_t bestIndices = 0;
+            int bestError = 1 << 30;
+            for (int pass = 0; pass < 2; pass++)
+            {
+                uint16_t c0 = To565(hi), c1 = To565(lo);
+                if (c0 < c1)
+                    std::swap(c0, c1);
+                int palette[4][3];
+                ColorPalette(c0, c1, true, palette);
+                int error;
+                // Equal endpoints select index 0 everywhere, which is c0 in three-colour mode too
+                uint32_t indices = ColorIndices(block, palette, error);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestC0 = c0;
+                    bestC1 = c1;
+                    bestIndices = indices;
+                }
+                if (c0 == c1 || bestError == 0)
+                    break;
+
+                float weights[16];
+                for (int i = 0; i < 16; i++)
+                    weights[i] = INDEX_WEIGHTS[(indices >> (2 * i)) & 3];
+                if (!SolveEndpoints(block, 3, weights, hi, lo))
+                    break;
+            }
+
+            out[0] = (uint8_t)(bestC0 & 0xFF);
+            out[1] = (uint8_t)(bestC0 >> 8);
+            out[2] = (uint8_t)(bestC1 & 0xFF);
+            out[3] = (uint8_t)(bestC1 >> 8);
+            for (int k = 0; k < 4; k++)
+                out[4 + k] = (uint8_t)(bestIndices >> (8 * k));
+        }
+
+        void AlphaPalette(int a0, int a1, int palette[8])
+        {
+            palette[0] = a0;
+            palette[1] = a1;
+            for (int i = 2; i < 8; i++)
+                palette[i] = a0 > a1 ? ((8 - i) * a0 + (i - 1) * a1) / 7 : (i < 6 ? ((6 - i) * a0 + (i - 1) * a1) / 5 : (i == 6 ? 0 : 255));
+        }
+
+        // BC3 alpha block: min / max endpoints, eight interpolated values
+        void EncodeAlpha(const uint8_t block[64], uint8_t out[8])
+        {
+            int a0 = 0, a1 = 255;
+            for (int i = 0; i < 16; i++)
+            {
+                a0 = std::max(a0, (int)block[i * 4 + 3]);
+                a1 = std::min(a1, (int)block[i * 4 + 3]);
+            }
+            out[0] = (uint8_t)a0;
+            out[1] = (uint8_t)a1;
+
+            uint64_t indices = 0;
+            if (a0 > a1)
+            {
+                int palette[8];
+                AlphaPalette(a0, a1, palette);
+                for (int i = 0; i < 16; i++)
+                {
+                    int best = 0, bestError = 1 << 30;
+                    for (int k = 0; k < 8; k++)
+                    {
+                        int e = std::abs(block[i * 4 + 3] - palette[k]);
+                        if (e < bestError)
+                        {
+                            bestError = e;
+                            best = k;
+                        }
+                    }
+                    indices |= (uint64_t)best << (3 * i);
+                }
+            }
+            for (int k = 0; k < 6; k++)
+                out[2 + k] = (uint8_t)(indices >> (8 * k));
+        }
+
+        struct BitWriter
+        {
+            uint8_t *out;
+            int position = 0;
+
+            void Put(uint32_t value, int bits)
+            {
+                for (int b = 0; b < bits; b++, position++)
+                {
+                    if ((value >> b) & 1)
+                        out[position >> 3] |= (uint8_t)(1 << (position & 7));
+                }
+            }
+        };
+
+        struct BitReader
+        {
+            const uint8_t *in;
+            int position = 0;
+
+            uint32_t Get(int bits)
+            {
+                uint32_t value = 0;
+                for (int b = 0; b < bits; b++, position++)
+                    value |= (uint32_t)((in[position >> 3] >> (position & 7)) & 1) << b;
+                return value;
+            }
+        };
+
+        // Mode 6 indices for 8-bit endpoints; returns the squared error
+        int BC7Indices(const uint8_t block[64], const int e0[4], const int e1[4], uint8_t indices[16])
+        {
+            int palette[16][4];
+            for (int k = 0; k < 16; k++)
+                for (int c = 0; c < 4; c++)
+                    palette[k][c] = ((64 - BC7_WEIGHTS[k]) * e0[c] + BC7_WEIGHTS[k] * e1[c] + 32) >> 6;
+
+            int dir[4], length2 = 0;
+            for (int c = 0; c < 4; c++)
+            {
+                dir[c] = e1[c] - e0[c];
+                length2 += dir[c] * dir[c];
+            }
+
+            int error = 0;
+            for (int i = 0; i < 16; i++)
+            {
+                const uint8_t *texel = block + i * 4;
+                // Projection onto the endpoint line, then the neighbours around it
+                int guess = 0;
+                if (length2 > 0)
+                {
+                    int dot = 0;
+                    for (int c = 0; c < 4; c++)
+                        dot += (texel[c] - e0[c]) * dir[c];
+                    guess = std::clamp((int)std::lround(dot * 15.0f / length2), 0, 15);
+                }
+                int best = guess, bestError = 1 << 30;
+                for (int k = std::max(0, guess - 1); k <= std::min(15, guess + 1); k++)
+                {
+                    int e = 0;
+                    for (int c = 0; c < 4; c++)
+                    {
+                        int d = texel[c] - palette[k][c];
+                        e += d * d;
+                    }
+                    if (e < bestError)
+                    {
+                        bestError = e;
+                        best = k;
+                    }
+                }
+                indices[i] = (uint8_t)best;
+                error += bestError;
+            }
+            return error;
+        }
+
+        void EncodeBC7(const uint8_t block[64], uint8_t out[16])
+        {
+            float lo[4], hi[4];
+            FitLine(block, 4, lo, hi);
+
+            int bestError = 1 << 30;
+            int best7[2][4] = {}, bestP[2] = {0, 0};
+            uint8_t bestIndices[16] = {};
+            for (int pass = 0; pass < 2; pass++)
+            {
+                for (int p = 0; p < 4; p++)
+                {
+                    const int p0 = p & 1, p1 = p >> 1;
+                    int q0[4], q1[4], e0[4], e1[4];
+                    for (int c = 0; c < 4; c++)
+                    {
+                        // endpoint = (7-bit value << 1) | p-bit
+                        q0[c] = std::clamp((int)std::lround((lo[c] - p0) * 0.5f), 0, 127);
+                        q1[c] = std::clamp((int)std::lround((hi[c] - p1) * 0.5f), 0, 127);
+                        e0[c] = (q0[c] << 1) | p0;
+                        e1[c] = (q1[c] << 1) | p1;
+                    }
+                    uint8_t indices[16];
+                    int error = BC7Indices(block, e0, e1, indices);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        std::memcpy(best7[0], q0, sizeof(q0));
+                        std::memcpy(best7[1], q1, sizeof(q1));
+                        bestP[0] = p0;
+                        bestP[1] = p1;
+                        std::memcpy(bestIndices, indices, sizeof(indices));
+                    }
+                }
+                if (bestError == 0)
+                    break;
+
+                float weights[16];
+                for (int i = 0; i < 16; i++)
+                    weights[i] = BC7_WEIGHTS[bestIndices[i]] / 64.0f;
+                if (!SolveEndpoints(block, 4, weights, lo, hi))
+                    break;
+            }
+
+            // The first texel's index has an implicit 0 top bit
+            if (bestIndices[0] >= 8)
+            {
+                std::swap(best7[0], best7[1]);
+                std::swap(bestP[0], bestP[1]);
+                for (int i = 0; i < 16; i++)
+                    bestIndices[i] = (uint8_t)(15 - bestIndices[i]);
+            }
+
+            std::memset(out, 0, 16);
+            BitWriter writer{out};
+            writer.Put(1u << 6, 7); // mode 6
+            for (int c = 0; c < 4; c++)
+            {
+                writer.Put((uint32_t)best7[0][c], 7);
+                writer.Put((uint32_t)best7[1][c], 7);
+            }
+            writer.Put((uint32_t)bestP[0], 1);
+            writer.Put((uint32_t)bestP[1], 1);
+            writer.Put(bestIndices[0], 3);
+            for (int i = 1; i < 16; i++)
+                writer.Put(bestIndices[i], 4);
+        }
+
+        void DecodeColor(const uint8_t in[8], bool forceFourColor, uint8_t block[64])
+        {
+            uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8)), c1 = (uint16_t)(in[2] | (in[3] << 8));
+            bool fourColor = forceFourColor || c0 > c1;
+            int palette[4][3];
+            ColorPalette(c0, c1, fourColor, palette);
+            uint32_t indices = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+            for (int i = 0; i < 16; i++)
+            {
+                int k = (indices >> (2 * i)) & 3;
+                for (int c = 0; c < 3; c++)
+                    block[i * 4 + c] = (uint8_t)palette[k][c];
+                block[i * 4 + 3] = (!fourColor && k == 3) ? 0 : 255;
+            }
+        }
+
+        void DecodeAlpha(const uint8_t in[8], uint8_t block[64])
+        {
+            int palette[8];
+            AlphaPalette(in[0], in[1], palette);
+            uint64_t indices = 0;
+            for (int k = 0; k < 6; k++)
+                indices |= (uint64_t)in[2 + k] << (8 * k);
+            for (int i = 0; i < 16; i++)
+                block[i * 4 + 3] = (uint8_t)palette[(indices >> (3 * i)) & 7];
+        }
+
+        // Mode 6 only, which is all Encode writes; other modes decode to black
+        void DecodeBC7(const uint8_t in[16], uint8_t block[64])
+        {
+            std::memset(block, 0, 64);
+            BitReader reader{in};
+            if (reader.Get(7) != (1u << 6))
+                return;
+            int e[2][4];
+            for (int c = 0; c < 4; c++)
+            {
+                e[0][c] = (int)reader.Get(7) << 1;
+                e[1][c] = (int)reader.Get(7) << 1;
+            }
+            int p0 = (int)reader.Get(1), p1 = (int)reader.Get(1);
+            for (int c = 0; c < 4; c++)
+            {
+                e[0][c] |= p0;
+                e[1][c] |= p1;
+            }
+            for (int i = 0; i < 16; i++)
+            {
+                int w = BC7_WEIGHTS[reader.Get(i == 0 ? 3 : 4)];
+                for (int c = 0; c < 4; c++)
+                    block[i * 4 + c] = (uint8_t)(((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6);
+            }
+        }
+
+        bool HasExtension(const char *name)
+        {
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (GLint i = 0; i < count; i++)
+            {
+                const char *extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, (GLuint)i));
+                if (extension && std::strcmp(extension, name) == 0)
+                    return true;
+            }
+            return false;
+        }
+    }
+
+    const char *BlockCompression::Name(BlockFormat format)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1:
+            return "BC1";
+        case BlockFormat::BC3:
+            return "BC3";
+        case BlockFormat::BC7:
+            return "BC7";
+        default:
+            return "None";
+        }
+    }
+
+    size_t BlockCompression::BlockBytes(BlockFormat format)
+    {
+        return format == BlockFormat::BC1 ? 8 : 16;
+    }
+
+    size_t BlockCompression::EncodedSize(int width, int height, BlockFormat format)
+    {
+        return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+    }
+
+    BlockFormat BlockCompression::Choose(BlockFormat requested, int channels)
+    {
+        if (requested == BlockFormat::None || channels < 3)
+            return BlockFormat::None;
+        if (requested == BlockFormat::BC7)
+            return BlockFormat::BC7;
+        return channels == 4 ? BlockFormat::BC3 : BlockFormat::BC1;
+    }
+
+    std::vector<uint8_t> BlockCompression::Encode(const unsigned char *pixels, int width, int height, int channels,
+                                                  BlockFormat format)
+    {
+        const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        const size_t blockBytes = BlockBytes(format);
+        std::vector<uint8_t> blocks(EncodedSize(width, height, format));
+
+        ThreadPool::Instance().ParallelFor(blocksY, 4, [&](size_t begin, size_t end)
+                                           {
+            uint8_t block[64];
+            for (size_t by = begin; by < end; by++)
+            {
+                for (int bx = 0; bx < blocksX; bx++)
+                {
+                    LoadBlock(pixels, width, height, channels, bx, (int)by, block);
+                    uint8_t *out = &blocks[(by * blocksX + bx) * blockBytes];
+                    if (format == BlockFormat::BC1)
+                        EncodeColor(block, out);
+                    else if (format == BlockFormat::BC3)
+                    {
+                        EncodeAlpha(block, out);
+                        EncodeColor(block, out + 8);
+                    }
+                    else
+                        EncodeBC7(block, out);
+                }
+            } });
+        return blocks;
+    }
+
+    std::vector<uint8_t> BlockCompression::Decode(const uint8_t *blocks, int width, int height, BlockFormat format)
+    {
+        const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        const size_t blockBytes = BlockBytes(format);
+        std::vector<uint8_t> rgba((size_t)width * height * 4);
+
+        ThreadPool::Instance().ParallelFor(blocksY, 16, [&](size_t begin, size_t end)
+                                           {
+            uint8_t block[64];
+            for (size_t by = begin; by < end; by++)
+            {
+                for (int bx = 0; bx < blocksX; bx++)
+                {
+                    const uint8_t *in = blocks + (by * blocksX + bx) * blockBytes;
+                    if (format == BlockFormat::BC1)
+                        DecodeColor(in, false, block);
+                    else if (format == BlockFormat::BC3)
+                    {
+                        DecodeColor(in + 8, true, block);
+                        DecodeAlpha(in, block);
+                    }
+                    else
+                        DecodeBC7(in, block);
+
+                    for (int y = 0; y < 4 && (int)by * 4 + y < height; y++)
+                    {
+                        int columns = std::min(4, width - bx * 4);
+                        std::memcpy(&rgba[(((by * 4 + y) * (size_t)width) + bx * 4) * 4], block + y * 16, columns * 4);
+                    }
+                }
+            } });
+        return rgba;
+    }
+
+    double BlockCompression::PSNR(const unsigned char *pixels, int channels, const uint8_t *rgba, int width, int height)
+    {
+        double sum = 0.0;
+        const size_t count = (size_t)width * height;
+        for (size_t i = 0; i < count; i++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                // 1 and 2 channel sources decode as grey (+ alpha)
+                int channel = channels >= 3 ? c : (c == 0 ? 0 : 3);
+                double d = (double)pixels[i * channels + c] - rgba[i * 4 + channel];
+                sum += d * d;
+            }
+        }
+        double mse = sum / ((double)count * channels);
+        return mse <= 0.0 ? 99.0 : std::min(99.0, 10.0 * std::log10(255.0 * 255.0 / mse));
+    }
+
+    bool BlockCompression::IsSupported(BlockFormat format)
+    {
+        static int s3tc = -1, bptc = -1;
+        if (format == BlockFormat::None)
+            return true;
+        if (format == BlockFormat::BC7)
+        {
+            if (bptc < 0)
+            {
+                // Core since 4.2
+                GLint major = 0, minor = 0;
+                glGetIntegerv(GL_MAJOR_VERSION, &major);
+                glGetIntegerv(GL_MINOR_VERSION, &minor);
+                bptc = (major > 4 || (major == 4 && minor >= 2) || HasExtension("GL_ARB_texture_compression_bptc")) ? 1 : 0;
+            }
+            return bptc == 1;
+        }
+        if (s3tc < 0)
+            s3tc = HasExtension("GL_EXT_texture_compression_s3tc") ? 1 : 0;
+        return s3tc == 1;
+    }
+
+    GLenum BlockCompression::GLFormat(BlockFormat format)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1:
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BlockFormat::BC3:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case BlockFormat::BC7:
+            return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        default:
+            return GL_RGBA;
+        }
+    }
+}
@@ -0,0 +1,18 @@
+#include "CacheUtil.h"
+#include <filesystem>
+
+namespace PartC
+{
+    bool SourceStamp(const std::string &path, uint64_t &size, int64_t &time)
+    {
+        std::error_code error;
+        size = (uint64_t)std::filesystem::file_size(path, error);
+        if (error)
+            return false;
+        auto written = std::filesystem::last_write_time(path, error);
+        if (error)
+            return false;
+        time = (int64_t)written.time_since_epoch().count();
+        return true;
+    }
+}
@@ -0,0 +1,27 @@
+#include "ColorSpace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace PartC
+{
+    SrgbTables::SrgbTables()
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            float c = i / 255.0f;
+            decode[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < ENCODE_SIZE; i++)
+        {
+            float l = i / (float)(ENCODE_SIZE - 1);
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            encode[i] = (unsigned char)std::lround(std::clamp(c, 0.0f, 1.0f) * 255.0f);
+        }
+    }
+
+    const SrgbTables &Srgb()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+}
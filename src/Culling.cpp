@@ -0,0 +1,117 @@
+#include "Culling.h"
+#include "SceneContext.h"
+#include <cmath>
+
+namespace PartC
+{
+    Frustum Frustum::FromMatrix(const glm::mat4 &m)
+    {
+        // glm is column-major: row i = (m[0][i], m[1][i], m[2][i], m[3][i])
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        Frustum f;
+        f.planes[0] = row3 + row0; // left
+        f.planes[1] = row3 - row0; // right
+        f.planes[2] = row3 + row1; // bottom
+        f.planes[3] = row3 - row1; // top
+        f.planes[4] = row3 + row2; // near
+        f.planes[5] = row3 - row2; // far
+
+        for (int i = 0; i < 6; i++)
+        {
+            float len = glm::length(glm::vec3(f.planes[i]));
+            if (len > 0.0f)
+                f.planes[i] /= len;
+        }
+        return f;
+    }
+
+    void CullingBounds::Build(const std::vector<SceneObject *> &sceneObjects)
+    {
+        objects.clear();
+        minX.clear();
+        minY.clear();
+        minZ.clear();
+        maxX.clear();
+        maxY.clear();
+        maxZ.clear();
+
+        for (auto obj : sceneObjects)
+        {
+            if (!obj || !obj->mesh)
+                continue;
+
+            glm::vec3 bmin, bmax;
+            obj->GetWorldBounds(bmin, bmax);
+            objects.push_back(obj);
+            minX.push_back(bmin.x);
+            minY.push_back(bmin.y);
+            minZ.push_back(bmin.z);
+            maxX.push_back(bmax.x);
+            maxY.push_back(bmax.y);
+            maxZ.push_back(bmax.z);
+        }
+    }
+
+    void Culling::FrustumCull(const Frustum &frustum, const CullingBounds &bounds,
+                              std::vector<uint32_t> &outVisible, CullStats &stats)
+    {
+        const size_t count = bounds.Size();
+        outVisible.clear();
+
+        // One pass per plane over contiguous arrays: the inner loop is branch-free
+        // (select + multiply-add + compare), which compilers turn into SIMD code.
+        std::vector<uint8_t> inside(count, 1);
+        const float *minX = bounds.minX.data();
+        const float *minY = bounds.minY.data();
+        const float *minZ = bounds.minZ.data();
+        const float *maxX = bounds.maxX.data();
+        const float *maxY = bounds.maxY.data();
+        const float *maxZ = bounds.maxZ.data();
+        uint8_t *mask = inside.data();
+
+        for (int p = 0; p < 6; p++)
+        {
+            const float nx = frustum.planes[p].x;
+            const float ny = frustum.planes[p].y;
+            const float nz = frustum.planes[p].z;
+            const float d = frustum.planes[p].w;
+            // Positive vertex: the box corner furthest along the plane normal
+            const bool useMaxX = nx > 0.0f;
+            const bool useMaxY = ny > 0.0f;
+            const bool useMaxZ = nz > 0.0f;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                float px = useMaxX ? maxX[i] : minX[i];
+                float py = useMaxY ? maxY[i] : minY[i];
+                float pz = useMaxZ ? maxZ[i] : minZ[i];
+                float dist = nx * px + ny * py + nz * pz + d;
+                mask[i] &= static_cast<uint8_t>(dist >= 0.0f);
+            }
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (mask[i])
+                outVisible.push_back(static_cast<uint32_t>(i));
+        }
+
+        stats.tested += static_cast<int>(count);
+        stats.visible += static_cast<int>(outVisible.size());
+        stats.culled += static_cast<int>(count - outVisible.size());
+    }
+
+    void Culling::SelectAll(const CullingBounds &bounds, std::vector<uint32_t> &outVisible, CullStats &stats)
+    {
+        outVisible.resize(bounds.Size());
+        for (size_t i = 0; i < bounds.Size(); i++)
+            outVisible[i] = static_cast<uint32_t>(i);
+
+        stats.tested += static_cast<int>(bounds.Size());
+        stats.visible += static_cast<int>(bounds.Size());
+    }
+}
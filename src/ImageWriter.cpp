@@ -0,0 +1,86 @@
+#include "ImageWriter.h"
+#include "PngWriter.h"
+#include <fstream>
+#include <vector>
+
+namespace PartC
+{
+    namespace
+    {
+#pragma pack(push, 1)
+        struct BMPHeader
+        {
+            unsigned char header[2] = {'B', 'M'};
+            unsigned int fileSize;
+            unsigned short reserved1 = 0;
+            unsigned short reserved2 = 0;
+            unsigned int dataOffset;
+            unsigned int headerSize = 40;
+            int width;
+            int height;
+            unsigned short planes = 1;
+            unsigned short bitsPerPixel = 24;
+            unsigned int compression = 0;
+            unsigned int imageSize;
+            int xPixelsPerMeter = 0;
+            int yPixelsPerMeter = 0;
+            unsigned int colorsUsed = 0;
+            unsigned int colorsImportant = 0;
+        };
+#pragma pack(pop)
+    }
+
+    const char *ImageWriter::Extension(ImageFormat format)
+    {
+        return format == ImageFormat::PNG ? ".png" : ".bmp";
+    }
+
+    bool ImageWriter::WriteBMP(const std::string &path, const uint8_t *pixels, int width, int height, int channels)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        const int rowSize = ((width * 24 + 31) / 32) * 4;
+        BMPHeader header;
+        header.imageSize = rowSize * height;
+        header.fileSize = sizeof(BMPHeader) + header.imageSize;
+        header.dataOffset = sizeof(BMPHeader);
+        header.width = width;
+        header.height = height;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(BMPHeader));
+
+        std::vector<unsigned char> row(rowSize, 0);
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t *src = pixels + (size_t)y * width * channels;
+            for (int x = 0; x < width; x++)
+            {
+                row[x * 3 + 0] = src[x * channels + 2]; // B
+                row[x * 3 + 1] = src[x * channels + 1]; // G
+                row[x * 3 + 2] = src[x * channels + 0]; // R
+            }
+            file.write(reinterpret_cast<const char *>(row.data()), rowSize);
+        }
+        return file.good();
+    }
+
+    bool ImageWriter::Write(const std::string &path, const uint8_t *pixels, int width, int height, int channels,
+                            ImageFormat format, PngCompression pngLevel)
+    {
+        if (format == ImageFormat::PNG)
+            return WritePNG(path, pixels, width, height, channels, pngLevel);
+        return WriteBMP(path, pixels, width, height, channels);
+    }
+
+    bool ImageWriter::WritePNG(const std::string &path, const uint8_t *pixels, int width, int height, int channels,
+                               PngCompression level)
+    {
+        // PNG is stored top-down: start at the last row and walk the buffer backwards
+        PngWriter writer;
+        const ptrdiff_t stride = (ptrdiff_t)width * channels;
+        return writer.Open(path, width, height, level) &&
+               writer.AppendRows(pixels + stride * (height - 1), height, channels, -stride) &&
+               writer.Finish();
+    }
+}
@@ -1,15 +1,75 @@
 #include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "Renderer.h"
+#include "VertexCodec.h"
+#include "VirtualTexture.h"
+#include <atomic>
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
+namespace
+{
+    // Meshes are also built on ThreadPool workers ([LOD] background simplification)
+    std::atomic<uint64_t> nextMeshId(1);
+}
+
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+           std::vector<PartC::Meshlet> meshlets)
+    : id(nextMeshId++)
 {
     this->vertices = vertices;
     this->indices = indices;
     this->textures = textures;
+    this->meshlets = meshlets;
+
+    RecalculateBounds();
+
+    // [Meshlet] 先重排索引再上传；簇内重新做顶点缓存排序 (Build 按生长顺序输出三角形)
+    if (this->meshlets.empty() && this->indices.size() / 3 >= PartC::Meshlets::minTriangles)
+    {
+        this->meshlets = PartC::Meshlets::Build(this->vertices, this->indices);
+        PartC::MeshOptimizer::OptimizeMeshlets(this->indices, this->vertices.size(), this->meshlets);
+    }
 
-    setupMesh();
+    // [Packed] 只压缩上传到 GPU 的副本 (八面体法线 + 半精度 UV)；CPU 端保留原始 float 顶点，
+    // 导出 / 简化 / 碰撞不会累积量化误差
+    halfTexCoords = PartC::VertexCodec::CanUseHalfTexCoords(this->vertices);
+
+    // [Headless] 没有 GL 上下文时只保留 CPU 端顶点数据
+    if (!PartC::Renderer::headless)
+        setupMesh(PartC::VertexCodec::Encode(this->vertices, halfTexCoords));
+}
+
+Mesh::~Mesh()
+{
+    if (PartC::Renderer::headless)
+        return;
+    if (VAO != 0)
+        glDeleteVertexArrays(1, &VAO);
+    if (VBO != 0)
+        glDeleteBuffers(1, &VBO);
+    if (EBO != 0)
+        glDeleteBuffers(1, &EBO);
 }
 
-void Mesh::setupMesh()
+void Mesh::RecalculateBounds()
+{
+    if (vertices.empty())
+    {
+        boundsMin = glm::vec3(0.0f);
+        boundsMax = glm::vec3(0.0f);
+        return;
+    }
+
+    boundsMin = vertices[0].Position;
+    boundsMax = vertices[0].Position;
+    for (const auto &v : vertices)
+    {
+        boundsMin = glm::min(boundsMin, v.Position);
+        boundsMax = glm::max(boundsMax, v.Position);
+    }
+    bvh.reset();
+}
+
+void Mesh::setupMesh(const std::vector<uint8_t> &packedVertices)
 {
     // [Part C] TODO: 这里是标准的 OpenGL 缓冲设置。后续如果需要实例化渲染或特殊优化，请修改此处。
     glGenVertexArrays(1, &VAO);
@@ -19,69 +79,122 @@ void Mesh::setupMesh()
     glBindVertexArray(VAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, packedVertices.size(), packedVertices.data(), GL_STATIC_DRAW);
 
+    // [Packed] 顶点数不超过 65536 时使用 16 位索引
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    if (PartC::VertexCodec::CanUseShortIndices(vertices.size()))
+    {
+        std::vector<uint16_t> shortIndices = PartC::VertexCodec::EncodeShortIndices(indices);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_SHORT;
+    }
+    else
+    {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_INT;
+    }
+
+    const GLsizei stride = (GLsizei)PartC::VertexCodec::Stride(halfTexCoords);
 
     // 顶点位置
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
 
-    // 顶点法线
+    // 顶点法线：八面体编码，2 x snorm16，在 vertex.glsl 中解码
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, Normal));
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void *)PartC::VertexCodec::NORMAL_OFFSET);
 
-    // 顶点纹理坐标
+    // 顶点纹理坐标：半精度（超出范围时为 float）
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, TexCoords));
+    glVertexAttribPointer(2, 2, halfTexCoords ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, stride,
+                          (void *)PartC::VertexCodec::TEXCOORD_OFFSET);
 
     glBindVertexArray(0);
 }
 
 void Mesh::Draw(Shader &shader)
 {
-    unsigned int diffuseNr = 1;
-    unsigned int specularNr = 1;
+    BindTextures(shader);
+    ApplyDiffuseSource(shader);
 
-    if (textures.empty())
-    {
-        shader.setInt("useTexture", 0);
-    }
-    else
-    {
-        shader.setInt("useTexture", 1);
-    }
+    glBindVertexArray(VAO);
+    DrawElements();
+    glBindVertexArray(0);
+
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void Mesh::BindTextures(Shader &shader)
+{
+    bool diffuseBound = false;
+    bool specularBound = false;
+
+    shader.setInt(shader.standard.useTexture, textures.empty() ? 0 : 1);
 
     for (unsigned int i = 0; i < textures.size(); i++)
     {
         glActiveTexture(GL_TEXTURE0 + i);
-        std::string number;
-        std::string name = textures[i].type;
-        if (name == "diffuse")
-            number = std::to_string(diffuseNr++);
-        else if (name == "specular")
-            number = std::to_string(specularNr++);
-
-        // [Fix] Match shader uniform names: material.diffuse, material.specular (no number for single texture)
-        if (name == "diffuse" && diffuseNr == 2)
+        const std::string &type = textures[i].type;
+
+        // [Fix] Match shader uniform names: material.diffuse, material.specular (only the first texture of each type is used)
+        if (!diffuseBound && type == "diffuse")
         {
-            shader.setInt("material.diffuse", i);
+            shader.setInt(shader.standard.materialDiffuse, (int)i);
+            diffuseBound = true;
         }
-        else if (name == "specular" && specularNr == 2)
+        else if (!specularBound && type == "specular")
         {
-            shader.setInt("material.specular", i);
+            shader.setInt(shader.standard.materialSpecular, (int)i);
+            specularBound = true;
         }
 
-        // Also keep the numbered version if you plan to support array in shader later
-        // shader.setInt(("material." + name + number).c_str(), i);
+        // [Atlas] the array is bound once per frame by Renderer::SetupLights
+        if (textures[i].AtlasLayer() < 0)
+            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+    }
+}
 
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
+void Mesh::ApplyDiffuseSource(Shader &shader) const
+{
+    if (!shader.standard.atlasLayer.IsValid())
+        return;
+
+    for (const Texture &texture : textures)
+    {
+        if (texture.type != "diffuse")
+            continue;
+        int layer = texture.AtlasLayer();
+        shader.setInt(shader.standard.atlasLayer, layer);
+        if (layer >= 0)
+            shader.setVec4(shader.standard.atlasRect, texture.AtlasRect());
+        PartC::VirtualTexture *virtualTexture = texture.Virtual();
+        shader.setInt(shader.standard.virtualTexture, virtualTexture ? 1 : 0);
+        if (virtualTexture)
+            virtualTexture->Bind(shader);
+        return;
     }
+    shader.setInt(shader.standard.atlasLayer, -1);
+    shader.setInt(shader.standard.virtualTexture, 0);
+}
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+void Mesh::DrawElements() const
+{
+    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), indexType, 0);
+}
 
-    glActiveTexture(GL_TEXTURE0);
+void Mesh::DrawRanges(const std::vector<PartC::MeshletRange> &ranges) const
+{
+    if (ranges.empty())
+        return;
+
+    const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+    std::vector<GLsizei> counts(ranges.size());
+    std::vector<const void *> offsets(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        counts[i] = (GLsizei)ranges[i].indexCount;
+        offsets[i] = (const void *)(ranges[i].indexOffset * indexSize);
+    }
+    glMultiDrawElements(GL_TRIANGLES, counts.data(), indexType, offsets.data(), (GLsizei)ranges.size());
 }
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "MeshLOD.h"
+#include "SceneContext.h"
+#include "GeometryUtils.h"
+#include "MeshSimplifier.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace PartC
+{
+    float MeshLOD::screenSizes[MeshLOD::MAX_LEVELS - 1] = {0.25f, 0.12f, 0.06f, 0.03f};
+    float MeshLOD::hysteresis = 0.15f;
+
+    namespace
+    {
+        // Procedural shapes stop losing segments here
+        const int MIN_SEGMENTS = 6;
+        // Imported meshes: each level keeps this fraction of the previous level's triangles
+        const float SIMPLIFY_RATIO = 0.5f;
+        const size_t MIN_LOD_TRIANGLES = 32;
+
+        // Worker-safe: each level is simplified from the previous level's arrays
+        void SimplifyLevels(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                            LodBuildState &state)
+        {
+            const std::vector<Vertex> *previousVertices = &vertices;
+            const std::vector<unsigned int> *previousIndices = &indices;
+            while ((int)state.indices.size() < MeshLOD::MAX_LEVELS - 1)
+            {
+                size_t triangles = previousIndices->size() / 3;
+                size_t target = (size_t)(triangles * SIMPLIFY_RATIO);
+                if (target < MIN_LOD_TRIANGLES)
+                    break;
+                SimplifyOptions options;
+                options.targetTriangles = target;
+                SimplifyResult level = MeshSimplifier::SimplifyGeometry(*previousVertices, *previousIndices, options);
+                // Flat-shaded meshes are all seams; weld by position like a plain QEM instead
+                if (level.indices.empty() || level.indices.size() / 3 > triangles * 0.9f)
+                {
+                    options.preserveSeams = false;
+                    level = MeshSimplifier::SimplifyGeometry(*previousVertices, *previousIndices, options);
+                }
+                // Stop once the simplifier is stuck (e.g. everything left is a protected border)
+                if (level.indices.empty() || level.indices.size() / 3 > triangles * 0.9f)
+                    break;
+                state.vertices.push_back(std::move(level.vertices));
+                state.indices.push_back(std::move(level.indices));
+                previousVertices = &state.vertices.back();
+                previousIndices = &state.indices.back();
+            }
+        }
+
+        Mesh *CreateProcedural(const SceneObject *obj, int segments)
+        {
+            switch (obj->geometryType)
+            {
+            case GeometryType::Sphere:
+                return GeometryUtils::CreateSphere(segments, segments);
+            case GeometryType::Cylinder:
+                return GeometryUtils::CreateCylinder(obj->param1, obj->param2, segments);
+            case GeometryType::Cone:
+                return GeometryUtils::CreateCone(obj->param1, obj->param2, segments);
+            default:
+                return nullptr;
+            }
+        }
+    }
+
+    bool MeshLOD::BuildChain(SceneObject *obj, bool wait)
+    {
+        Mesh *mesh = obj->mesh.get();
+        if (!mesh)
+            return false;
+        if (mesh->lodChainBuilt)
+            return !mesh->lods.empty();
+
+        if (mesh->lodBuild)
+        {
+            while (wait && !mesh->lodBuild->done.load(std::memory_order_acquire))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (!mesh->lodBuild->done.load(std::memory_order_acquire))
+                return false;
+            // Finished: create (and upload) the levels on this thread
+            LodBuildState &state = *mesh->lodBuild;
+            for (size_t i = 0; i < state.indices.size(); i++)
+                mesh->lods.push_back(std::make_shared<Mesh>(state.vertices[i], state.indices[i], mesh->textures));
+            mesh->lodBuild.reset();
+            mesh->lodChainBuilt = true;
+            return !mesh->lods.empty();
+        }
+
+        // Animated objects swap meshes every frame; their frames are not worth simplifying
+        if (obj->isAnimated)
+        {
+            mesh->lodChainBuilt = true;
+            return false;
+        }
+
+        switch (obj->geometryType)
+        {
+        case GeometryType::Sphere:
+        case GeometryType::Cylinder:
+        case GeometryType::Cone:
+        {
+            int segments = obj->segments;
+            while ((int)mesh->lods.size() < MAX_LEVELS - 1 && segments / 2 >= MIN_SEGMENTS)
+            {
+                segments /= 2;
+                Mesh *level = CreateProcedural(obj, segments);
+                if (!level)
+                    break;
+                level->textures = mesh->textures;
+                mesh->lods.push_back(std::shared_ptr<Mesh>(level));
+            }
+            break;
+        }
+        case GeometryType::None:
+        {
+            // Seconds for multi-million triangle imports: off the render thread. The job owns
+            // copies of the arrays and its own reference to the state, so the mesh may be
+            // edited or deleted meanwhile
+            auto state = std::make_shared<LodBuildState>();
+            mesh->lodBuild = state;
+            if (wait)
+            {
+                SimplifyLevels(mesh->vertices, mesh->indices, *state);
+                state->done.store(true, std::memory_order_release);
+                return BuildChain(obj);
+            }
+            auto vertices = std::make_shared<std::vector<Vertex>>(mesh->vertices);
+            auto indices = std::make_shared<std::vector<unsigned int>>(mesh->indices);
+            ThreadPool::Instance().EnqueueBackground([state, vertices, indices]()
+            {
+                SimplifyLevels(*vertices, *indices, *state);
+                state->done.store(true, std::memory_order_release);
+            });
+            return false;
+        }
+        default:
+            break;
+        }
+        mesh->lodChainBuilt = true;
+        return !mesh->lods.empty();
+    }
+
+    float MeshLOD::ScreenSize(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                              const glm::vec3 &camPos, const glm::mat4 &projection)
+    {
+        glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+        float radius = 0.5f * glm::length(boundsMax - boundsMin);
+        float distance = glm::length(center - camPos);
+        if (distance <= radius)
+            return 1.0f;
+        // projection[1][1] = 1 / tan(fovY / 2): diameter / (2 * d * tan) of the viewport height
+        return radius * projection[1][1] / distance;
+    }
+
+    int MeshLOD::SelectLevel(float screenSize, int currentLevel, int levelCount)
+    {
+        auto levelFor = [&](float scale)
+        {
+            int level = 0;
+            while (level < levelCount - 1 && screenSize < screenSizes[level] * scale)
+                level++;
+            return level;
+        };
+
+        currentLevel = std::min(currentLevel, levelCount - 1);
+        int coarser = levelFor(1.0f - hysteresis);
+        int finer = levelFor(1.0f + hysteresis);
+        if (coarser > currentLevel)
+            return coarser;
+        if (finer < currentLevel)
+            return finer;
+        return currentLevel;
+    }
+
+    Mesh *MeshLOD::Select(SceneObject *obj, float screenSize, LodStats &stats)
+    {
+        Mesh *mesh = obj->mesh.get();
+        size_t fullTriangles = mesh->indices.size() / 3;
+
+        int levelCount = BuildChain(obj) ? (int)mesh->lods.size() + 1 : 1;
+        obj->lodLevel = SelectLevel(screenSize, obj->lodLevel, levelCount);
+
+        Mesh *selected = mesh;
+        if (obj->lodLevel > 0)
+        {
+            selected = mesh->lods[obj->lodLevel - 1].get();
+            // Textures may be assigned after the chain was built (scene loading, editor)
+            if (selected->textures.size() != mesh->textures.size() ||
+                (!mesh->textures.empty() && (selected->textures[0].id != mesh->textures[0].id ||
+                                             selected->textures[0].entry != mesh->textures[0].entry)))
+                selected->textures = mesh->textures;
+        }
+
+        stats.objects++;
+        stats.levelCounts[obj->lodLevel]++;
+        stats.trianglesFull += (long long)fullTriangles;
+        stats.trianglesDrawn += (long long)(selected->indices.size() / 3);
+        return selected;
+    }
+}
@@ -0,0 +1,534 @@
+#include "MeshOptimizer.h"
+#include "CacheUtil.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace PartC
+{
+    bool MeshOptimizer::optimizeOnLoad = true;
+    bool MeshOptimizer::reorderForOverdraw = true;
+    bool MeshOptimizer::useMeshCache = true;
+    float MeshOptimizer::overdrawThreshold = 1.05f;
+    MeshOptimizeReport MeshOptimizer::lastReport;
+
+    namespace
+    {
+        const uint32_t NONE = ~0u;
+        const uint32_t CACHE_VERSION = 2;
+        const char CACHE_MAGIC[8] = {'M', 'E', 'S', 'H', 'O', 'P', 'T', '\0'};
+        const uint32_t FLAG_OVERDRAW = 1;
+
+        struct CacheHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t flags;
+            float overdrawThreshold;
+            uint32_t vertexCount, indexCount, verticesIn;
+            int32_t clusters;
+            uint32_t meshletCount, meshletMinTriangles;
+            float acmrBefore, atvrBefore, acmrAfter, atvrAfter;
+            uint64_t sourceSize;
+            int64_t sourceTime;
+        };
+
+        // Post-transform cache as a FIFO: a vertex hits while fewer than cacheSize misses
+        // happened since it was loaded
+        struct FifoCache
+        {
+            std::vector<uint32_t> stamp;
+            uint32_t time;
+            int size;
+
+            FifoCache(size_t vertexCount, int cacheSize) : stamp(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+            // Returns 1 on a miss
+            int Touch(uint32_t v)
+            {
+                if (time - stamp[v] <= (uint32_t)size)
+                    return 0;
+                stamp[v] = time++;
+                return 1;
+            }
+
+            void Reset() { time += size + 1; }
+        };
+
+        // Merges vertices with identical bytes; indices are rewritten in place
+        size_t WeldVertices(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+        {
+            size_t capacity = 1;
+            while (capacity < vertices.size() * 2)
+                capacity <<= 1;
+            std::vector<uint32_t> table(capacity, NONE);
+            std::vector<uint32_t> remap(vertices.size());
+            std::vector<Vertex> unique;
+            unique.reserve(vertices.size() / 2);
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                uint32_t words[sizeof(Vertex) / 4];
+                std::memcpy(words, &vertices[i], sizeof(Vertex));
+                uint32_t h = 2166136261u;
+                for (uint32_t w : words)
+                    h = (h ^ w) * 16777619u;
+                size_t slot = (h ^ (h >> 15)) & (capacity - 1);
+                while (table[slot] != NONE && std::memcmp(&unique[table[slot]], &vertices[i], sizeof(Vertex)) != 0)
+                    slot = (slot + 1) & (capacity - 1);
+                if (table[slot] == NONE)
+                {
+                    table[slot] = (uint32_t)unique.size();
+                    unique.push_back(vertices[i]);
+                }
+                remap[i] = table[slot];
+            }
+            for (unsigned int &index : indices)
+                index = remap[index];
+            vertices.swap(unique);
+            return vertices.size();
+        }
+
+        // Tipsify: fan around the current vertex, then continue from the neighbour that is
+        // still in the cache and will not be evicted before its remaining triangles are drawn
+        std::vector<unsigned int> Tipsify(const std::vector<unsigned int> &indices, size_t vertexCount, int cacheSize)
+        {
+            const size_t triangleCount = indices.size() / 3;
+            std::vector<uint32_t> offsets(vertexCount + 1, 0), adjacency(indices.size());
+            for (unsigned int v : indices)
+                offsets[v + 1]++;
+            for (size_t v = 0; v < vertexCount; v++)
+                offsets[v + 1] += offsets[v];
+            std::vector<uint32_t> live(vertexCount);
+            for (size_t v = 0; v < vertexCount; v++)
+                live[v] = offsets[v + 1] - offsets[v];
+            {
+                std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indices.size(); i++)
+                    adjacency[cursor[indices[i]]++] = (uint32_t)(i / 3);
+            }
+
+            std::vector<uint32_t> cacheTime(vertexCount, 0);
+            std::vector<uint8_t> emitted(triangleCount, 0);
+            std::vector<uint32_t> deadEnds, candidates;
+            std::vector<unsigned int> output;
+            output.reserve(indices.size());
+            uint32_t time = cacheSize + 1;
+            size_t cursor = 0;
+
+            auto skipDeadEnd = [&]() -> uint32_t
+            {
+                while (!deadEnds.empty())
+                {
+                    uint32_t v = deadEnds.back();
+                    deadEnds.pop_back();
+                    if (live[v] > 0)
+                        return v;
+                }
+                for (; cursor < vertexCount; cursor++)
+                {
+                    if (live[cursor] > 0)
+                        return (uint32_t)cursor;
+                }
+                return NONE;
+            };
+
+            uint32_t fan = skipDeadEnd();
+            while (fan != NONE)
+            {
+                candidates.clear();
+                for (uint32_t i = offsets[fan]; i < offsets[fan + 1]; i++)
+                {
+                    uint32_t t = adjacency[i];
+                    if (emitted[t])
+                        continue;
+                    emitted[t] = 1;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        uint32_t v = indices[t * 3 + k];
+                        output.push_back(v);
+                        deadEnds.push_back(v);
+                        candidates.push_back(v);
+                        live[v]--;
+                        if (time - cacheTime[v] > (uint32_t)cacheSize)
+                            cacheTime[v] = time++;
+                    }
+                }
+
+                uint32_t next = NONE;
+                int bestPriority = -1;
+                for (uint32_t v : candidates)
+                {
+                    if (live[v] == 0)
+                        continue;
+                    // Each remaining triangle can push up to two new vertices into the cache
+                    int priority = 0;
+                    int age = (int)(time - cacheTime[v]);
+                    if (age + 2 * (int)live[v] <= cacheSize)
+                        priority = age;
+                    if (priority > bestPriority)
+                    {
+                        bestPriority = priority;
+                        next = v;
+                    }
+                }
+                fan = next != NONE ? next : skipDeadEnd();
+            }
+            return output;
+        }
+
+        // Sander et al.: cut the cache-ordered triangles into clusters (at cache restarts, and
+        // wherever a cluster's own ACMR is already close to the run's); returns the first
+        // triangle of each cluster followed by the triangle count
+        std::vector<uint32_t> SplitClusters(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                            int cacheSize, float threshold)
+        {
+            const size_t triangleCount = indices.size() / 3;
+            std::vector<uint32_t> hard, clusters;
+            {
+                FifoCache cache(vertices.size(), cacheSize);
+                for (size_t t = 0; t < triangleCount; t++)
+                {
+                    int misses = cache.Touch(indices[t * 3]) + cache.Touch(indices[t * 3 + 1]) + cache.Touch(indices[t * 3 + 2]);
+                    if (t == 0 || misses == 3)
+                        hard.push_back((uint32_t)t);
+                }
+            }
+            hard.push_back((uint32_t)triangleCount);
+
+            FifoCache cache(vertices.size(), cacheSize);
+            for (size_t h = 0; h + 1 < hard.size(); h++)
+            {
+                uint32_t begin = hard[h], end = hard[h + 1];
+                cache.Reset();
+                int runMisses = 0;
+                for (uint32_t t = begin; t < end; t++)
+                    runMisses += cache.Touch(indices[t * 3]) + cache.Touch(indices[t * 3 + 1]) + cache.Touch(indices[t * 3 + 2]);
+                float runAcmr = (float)runMisses / (float)(end - begin);
+
+                cache.Reset();
+                clusters.push_back(begin);
+                int misses = 0, count = 0;
+                for (uint32_t t = begin; t < end; t++)
+                {
+                    misses += cache.Touch(indices[t * 3]) + cache.Touch(indices[t * 3 + 1]) + cache.Touch(indices[t * 3 + 2]);
+                    count++;
+                    // Clusters are drawn in a new order, so each one starts with a cold cache
+                    if (t + 1 < end && (float)misses / (float)count <= threshold * runAcmr)
+                    {
+                        clusters.push_back(t + 1);
+                        cache.Reset();
+                        misses = count = 0;
+                    }
+                }
+            }
+            clusters.push_back((uint32_t)triangleCount);
+            return clusters;
+        }
+
+        // Cluster order that draws the clusters facing away from the mesh centre first
+        std::vector<uint32_t> OutwardFirstOrder(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                                const std::vector<uint32_t> &clusters)
+        {
+            const size_t clusterCount = clusters.size() - 1;
+            glm::vec3 meshCentroid(0.0f);
+            float meshArea = 0.0f;
+            std::vector<glm::vec3> centroids(clusterCount), normals(clusterCount);
+            for (size_t c = 0; c < clusterCount; c++)
+            {
+                glm::vec3 centroid(0.0f), normal(0.0f);
+                float area = 0.0f;
+                for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+                {
+                    const glm::vec3 &p0 = vertices[indices[t * 3]].Position;
+                    const glm::vec3 &p1 = vertices[indices[t * 3 + 1]].Position;
+                    const glm::vec3 &p2 = vertices[indices[t * 3 + 2]].Position;
+                    glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                    float a = glm::length(n);
+                    centroid += (p0 + p1 + p2) * (a / 3.0f);
+                    normal += n;
+                    area += a;
+                }
+                meshCentroid += centroid;
+                meshArea += area;
+                centroids[c] = area > 0.0f ? centroid / area : vertices[indices[clusters[c] * 3]].Position;
+                normals[c] = normal;
+            }
+            if (meshArea > 0.0f)
+                meshCentroid /= meshArea;
+
+            std::vector<float> sortKey(clusterCount);
+            for (size_t c = 0; c < clusterCount; c++)
+            {
+                float length = glm::length(normals[c]);
+                sortKey[c] = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+            }
+            std::vector<uint32_t> order(clusterCount);
+            for (size_t c = 0; c < clusterCount; c++)
+                order[c] = (uint32_t)c;
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+                             { return sortKey[a] > sortKey[b]; });
+            return order;
+        }
+
+        void ApplyClusterOrder(std::vector<unsigned int> &indices, const std::vector<uint32_t> &clusters,
+                               const std::vector<uint32_t> &order)
+        {
+            std::vector<unsigned int> sorted;
+            sorted.reserve(indices.size());
+            for (uint32_t c : order)
+                sorted.insert(sorted.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+            indices.swap(sorted);
+        }
+
+        // Vertex fetch order: vertices appear in the buffer in the order they are first used
+        void ReorderVertices(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+        {
+            std::vector<uint32_t> remap(vertices.size(), NONE);
+            std::vector<Vertex> ordered;
+            ordered.reserve(vertices.size());
+            for (unsigned int &index : indices)
+            {
+                if (remap[index] == NONE)
+                {
+                    remap[index] = (uint32_t)ordered.size();
+                    ordered.push_back(vertices[index]);
+                }
+                index = remap[index];
+            }
+            vertices.swap(ordered);
+        }
+    }
+
+    VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, int cacheSize)
+    {
+        VertexCacheStats stats;
+        if (indices.empty() || vertexCount == 0)
+            return stats;
+        FifoCache cache(vertexCount, cacheSize);
+        size_t misses = 0;
+        for (unsigned int index : indices)
+            misses += cache.Touch(index);
+        stats.acmr = (float)misses / (float)(indices.size() / 3);
+        stats.atvr = (float)misses / (float)vertexCount;
+        return stats;
+    }
+
+    void MeshOptimizer::OptimizeMeshlets(std::vector<unsigned int> &indices, size_t vertexCount,
+                                         const std::vector<Meshlet> &meshlets)
+    {
+        // Each meshlet is a small mesh of its own: renumber its vertices densely, run
+        // Tipsify on that, map back. The triangles and the index range stay the same,
+        // so the meshlet bounds and cones are still valid.
+        std::vector<uint32_t> localId(vertexCount, NONE);
+        std::vector<unsigned int> globalId, local;
+        for (const Meshlet &meshlet : meshlets)
+        {
+            unsigned int *range = &indices[meshlet.indexOffset];
+            const size_t indexCount = (size_t)meshlet.triangleCount * 3;
+            globalId.clear();
+            local.resize(indexCount);
+            for (size_t i = 0; i < indexCount; i++)
+            {
+                if (localId[range[i]] == NONE)
+                {
+                    localId[range[i]] = (uint32_t)globalId.size();
+                    globalId.push_back(range[i]);
+                }
+                local[i] = localId[range[i]];
+            }
+            std::vector<unsigned int> ordered = Tipsify(local, globalId.size(), CACHE_SIZE);
+            for (size_t i = 0; i < indexCount; i++)
+                range[i] = globalId[ordered[i]];
+            for (unsigned int v : globalId)
+                localId[v] = NONE;
+        }
+    }
+
+    MeshOptimizeReport MeshOptimizer::Optimize(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                                               std::vector<Meshlet> &meshlets)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        MeshOptimizeReport report;
+        report.verticesIn = vertices.size();
+        report.triangles = indices.size() / 3;
+        report.before = AnalyzeVertexCache(indices, vertices.size());
+        if (indices.size() < 3)
+        {
+            report.verticesOut = vertices.size();
+            report.after = report.before;
+            return report;
+        }
+
+        WeldVertices(vertices, indices);
+        meshlets.clear();
+        if (indices.size() / 3 >= Meshlets::minTriangles)
+        {
+            // [Meshlet] Meshlets first: Build rewrites the triangle order, so the cache and
+            // overdraw passes work inside / between meshlets instead of being undone by it
+            meshlets = Meshlets::Build(vertices, indices);
+            OptimizeMeshlets(indices, vertices.size(), meshlets);
+            if (reorderForOverdraw)
+            {
+                std::vector<uint32_t> clusters;
+                for (const Meshlet &meshlet : meshlets)
+                    clusters.push_back(meshlet.indexOffset / 3);
+                clusters.push_back((uint32_t)(indices.size() / 3));
+                std::vector<uint32_t> order = OutwardFirstOrder(vertices, indices, clusters);
+                ApplyClusterOrder(indices, clusters, order);
+
+                std::vector<Meshlet> sorted;
+                sorted.reserve(meshlets.size());
+                uint32_t offset = 0;
+                for (uint32_t c : order)
+                {
+                    sorted.push_back(meshlets[c]);
+                    sorted.back().indexOffset = offset;
+                    offset += meshlets[c].triangleCount * 3;
+                }
+                meshlets.swap(sorted);
+                report.clusters = (int)meshlets.size();
+            }
+        }
+        else
+        {
+            indices = Tipsify(indices, vertices.size(), CACHE_SIZE);
+            if (reorderForOverdraw)
+            {
+                std::vector<uint32_t> clusters = SplitClusters(vertices, indices, CACHE_SIZE, overdrawThreshold);
+                ApplyClusterOrder(indices, clusters, OutwardFirstOrder(vertices, indices, clusters));
+                report.clusters = (int)clusters.size() - 1;
+            }
+        }
+        // Renames vertices only: meshlet ranges and bounds are unaffected
+        ReorderVertices(vertices, indices);
+
+        report.verticesOut = vertices.size();
+        report.after = AnalyzeVertexCache(indices, vertices.size());
+        auto finish = std::chrono::high_resolution_clock::now();
+        report.ms = std::chrono::duration<float, std::milli>(finish - start).count();
+        return report;
+    }
+
+    std::string MeshOptimizer::CachePath(const std::string &sourcePath)
+    {
+        return sourcePath + ".meshcache";
+    }
+
+    bool MeshOptimizer::LoadCache(const std::string &sourcePath, std::vector<Vertex> &vertices,
+                                  std::vector<unsigned int> &indices, std::vector<Meshlet> &meshlets,
+                                  MeshOptimizeReport &report)
+    {
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        if (!useMeshCache || !SourceStamp(sourcePath, sourceSize, sourceTime))
+            return false;
+
+        std::ifstream file(CachePath(sourcePath), std::ios::binary);
+        if (!file.is_open())
+            return false;
+        CacheHeader header;
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+            return false;
+        uint32_t flags = reorderForOverdraw ? FLAG_OVERDRAW : 0;
+        if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION ||
+            header.flags != flags || header.overdrawThreshold != overdrawThreshold ||
+            header.meshletMinTriangles != (uint32_t)Meshlets::minTriangles ||
+            header.sourceSize != sourceSize || header.sourceTime != sourceTime)
+            return false;
+
+        // The counts must describe exactly the rest of the file, so a corrupt header cannot
+        // make us allocate or read past it
+        const std::string path = CachePath(sourcePath);
+        file.seekg(0, std::ios::end);
+        const uint64_t fileSize = (uint64_t)file.tellg();
+        file.seekg(sizeof(header), std::ios::beg);
+        const uint64_t expected = sizeof(header) + (uint64_t)header.vertexCount * sizeof(Vertex) +
+                                  (uint64_t)header.indexCount * sizeof(unsigned int) +
+                                  (uint64_t)header.meshletCount * sizeof(Meshlet);
+        if (!file || fileSize != expected || header.indexCount % 3 != 0)
+        {
+            std::cerr << "Warning: Corrupt mesh cache: " << path << std::endl;
+            return false;
+        }
+
+        vertices.resize(header.vertexCount);
+        indices.resize(header.indexCount);
+        meshlets.resize(header.meshletCount);
+        file.read(reinterpret_cast<char *>(vertices.data()), vertices.size() * sizeof(Vertex));
+        file.read(reinterpret_cast<char *>(indices.data()), indices.size() * sizeof(unsigned int));
+        file.read(reinterpret_cast<char *>(meshlets.data()), meshlets.size() * sizeof(Meshlet));
+
+        // Everything the renderer indexes with: vertex indices, and meshlets tiling the
+        // index buffer in order
+        bool valid = (bool)file;
+        for (size_t i = 0; valid && i < indices.size(); i++)
+            valid = indices[i] < header.vertexCount;
+        uint64_t nextOffset = 0;
+        for (size_t m = 0; valid && m < meshlets.size(); m++)
+        {
+            const Meshlet &meshlet = meshlets[m];
+            valid = meshlet.indexOffset == nextOffset && meshlet.triangleCount > 0 &&
+                    meshlet.triangleCount <= (uint32_t)Meshlets::MAX_TRIANGLES;
+            nextOffset += (uint64_t)meshlet.triangleCount * 3;
+        }
+        if (valid && !meshlets.empty())
+            valid = nextOffset == indices.size();
+        if (!valid)
+        {
+            std::cerr << "Warning: Corrupt mesh cache: " << path << std::endl;
+            vertices.clear();
+            indices.clear();
+            meshlets.clear();
+            return false;
+        }
+
+        report = MeshOptimizeReport();
+        report.verticesIn = header.verticesIn;
+        report.verticesOut = header.vertexCount;
+        report.triangles = header.indexCount / 3;
+        report.clusters = header.clusters;
+        report.before.acmr = header.acmrBefore;
+        report.before.atvr = header.atvrBefore;
+        report.after.acmr = header.acmrAfter;
+        report.after.atvr = header.atvrAfter;
+        report.fromCache = true;
+        return true;
+    }
+
+    bool MeshOptimizer::SaveCache(const std::string &sourcePath, const std::vector<Vertex> &vertices,
+                                  const std::vector<unsigned int> &indices, const std::vector<Meshlet> &meshlets,
+                                  const MeshOptimizeReport &report)
+    {
+        CacheHeader header = {};
+        if (!useMeshCache || !SourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+            return false;
+        std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.version = CACHE_VERSION;
+        header.flags = reorderForOverdraw ? FLAG_OVERDRAW : 0;
+        header.overdrawThreshold = overdrawThreshold;
+        header.vertexCount = (uint32_t)vertices.size();
+        header.indexCount = (uint32_t)indices.size();
+        header.verticesIn = (uint32_t)report.verticesIn;
+        header.clusters = report.clusters;
+        header.meshletCount = (uint32_t)meshlets.size();
+        header.meshletMinTriangles = (uint32_t)Meshlets::minTriangles;
+        header.acmrBefore = report.before.acmr;
+        header.atvrBefore = report.before.atvr;
+        header.acmrAfter = report.after.acmr;
+        header.atvrAfter = report.after.atvr;
+
+        // Read-only asset folders simply go without a cache
+        std::ofstream file(CachePath(sourcePath), std::ios::binary);
+        if (!file.is_open())
+            return false;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(vertices.data()), vertices.size() * sizeof(Vertex));
+        file.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(unsigned int));
+        file.write(reinterpret_cast<const char *>(meshlets.data()), meshlets.size() * sizeof(Meshlet));
+        return (bool)file;
+    }
+}
@@ -0,0 +1,716 @@
+#include "MeshSimplifier.h"
+#include "Mesh.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+namespace PartC
+{
+    namespace
+    {
+        const uint32_t NONE = ~0u;
+        const int ATTRIBUTE_COUNT = 5; // normal xyz, uv
+        // Planes through open edges, relative to the area of the faces around them
+        const float BORDER_WEIGHT = 10.0f;
+        const size_t GRAIN = 4096;
+        // Collapses are ordered by the top 16 bits of their cost (exponent + 7 mantissa bits)
+        const int COST_BUCKET_SHIFT = 16;
+        const size_t COST_BUCKETS = size_t(1) << (32 - COST_BUCKET_SHIFT);
+
+        enum VertexKind : uint8_t
+        {
+            KIND_MANIFOLD, // interior vertex with one set of attributes
+            KIND_BORDER,   // on exactly one open border
+            KIND_SEAM,     // two attribute sets meeting along exactly one seam
+            KIND_LOCKED    // corners, non-manifold, several seams: never moves
+        };
+
+        // [from][to]; border and seam vertices must also move along their own open edge
+        const bool CAN_COLLAPSE[4][4] = {
+            {true, true, true, true},
+            {false, true, false, true},
+            {false, false, true, true},
+            {false, false, false, false}};
+
+        // Symmetric 4x4 form, upper triangle: a2 ab ac ad b2 bc bd c2 cd d2, plus the total weight
+        struct Quadric
+        {
+            double m[10] = {0.0};
+            double w = 0.0;
+
+            void AddPlane(const glm::vec3 &n, double d, double weight)
+            {
+                m[0] += weight * n.x * n.x;
+                m[1] += weight * n.x * n.y;
+                m[2] += weight * n.x * n.z;
+                m[3] += weight * n.x * d;
+                m[4] += weight * n.y * n.y;
+                m[5] += weight * n.y * n.z;
+                m[6] += weight * n.y * d;
+                m[7] += weight * n.z * n.z;
+                m[8] += weight * n.z * d;
+                m[9] += weight * d * d;
+            }
+
+            void Add(const Quadric &q)
+            {
+                for (int i = 0; i < 10; i++)
+                    m[i] += q.m[i];
+                w += q.w;
+            }
+
+            // Weighted sum of squared plane distances (not divided by w). Double precision:
+            // on dense meshes the result is many orders of magnitude below the terms.
+            double Evaluate(const glm::vec3 &p) const
+            {
+                double x = p.x, y = p.y, z = p.z;
+                return m[0] * x * x + 2.0 * m[1] * x * y + 2.0 * m[2] * x * z + 2.0 * m[3] * x +
+                       m[4] * y * y + 2.0 * m[5] * y * z + 2.0 * m[6] * y +
+                       m[7] * z * z + 2.0 * m[8] * z + m[9];
+            }
+        };
+
+        // Hoppe's attribute quadric: over each face, attribute j is g_j.p + d_j. With the
+        // (g.p + d)^2 terms folded into q, the error at position p with attributes s is
+        //   q(p) + sum_j (w s_j^2 - 2 s_j (G_j.p + D_j)),  G_j / D_j the summed g_j / d_j
+        struct AttributeQuadric
+        {
+            Quadric q;
+            double gradient[ATTRIBUTE_COUNT][3];
+            double offset[ATTRIBUTE_COUNT];
+
+            AttributeQuadric()
+            {
+                for (int j = 0; j < ATTRIBUTE_COUNT; j++)
+                {
+                    gradient[j][0] = gradient[j][1] = gradient[j][2] = 0.0;
+                    offset[j] = 0.0;
+                }
+            }
+
+            void Add(const AttributeQuadric &o)
+            {
+                q.Add(o.q);
+                for (int j = 0; j < ATTRIBUTE_COUNT; j++)
+                {
+                    for (int i = 0; i < 3; i++)
+                        gradient[j][i] += o.gradient[j][i];
+                    offset[j] += o.offset[j];
+                }
+            }
+
+            double Evaluate(const glm::vec3 &p, const float *s) const
+            {
+                double e = q.Evaluate(p);
+                for (int j = 0; j < ATTRIBUTE_COUNT; j++)
+                {
+                    double predicted = gradient[j][0] * p.x + gradient[j][1] * p.y + gradient[j][2] * p.z + offset[j];
+                    e += q.w * s[j] * s[j] - 2.0 * s[j] * predicted;
+                }
+                return e;
+            }
+        };
+
+        struct Collapse
+        {
+            uint32_t from = NONE, to = NONE;
+            float cost = 0.0f;
+            float geometric = 0.0f; // position part only, reported as the error
+        };
+
+        uint32_t HashFloats(const float *values, size_t count)
+        {
+            uint32_t h = 2166136261u;
+            for (size_t i = 0; i < count; i++)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &values[i], sizeof(bits));
+                h = (h ^ bits) * 16777619u;
+            }
+            return h ^ (h >> 15);
+        }
+
+        // remap[i] = first element equal to i (by the first floatCount floats of each record)
+        std::vector<uint32_t> WeldFloats(const float *data, size_t stride, size_t floatCount, size_t count)
+        {
+            size_t capacity = 1;
+            while (capacity < count * 2)
+                capacity <<= 1;
+            std::vector<uint32_t> table(capacity, NONE);
+            std::vector<uint32_t> remap(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                const float *key = data + i * stride;
+                size_t slot = HashFloats(key, floatCount) & (capacity - 1);
+                while (table[slot] != NONE && std::memcmp(data + table[slot] * stride, key, floatCount * sizeof(float)) != 0)
+                    slot = (slot + 1) & (capacity - 1);
+                if (table[slot] == NONE)
+                    table[slot] = (uint32_t)i;
+                remap[i] = table[slot];
+            }
+            return remap;
+        }
+
+        uint32_t CostKey(float cost)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &cost, sizeof(bits));
+            return bits >> COST_BUCKET_SHIFT;
+        }
+
+        // Working set: "wedges" are unique (position, normal, uv) vertices
+        struct Simplifier
+        {
+            size_t wedgeCount = 0;
+            std::vector<glm::vec3> positions; // normalised to the unit box
+            std::vector<float> attributes;    // ATTRIBUTE_COUNT per wedge, pre-weighted; empty if unused
+            std::vector<uint32_t> positionRep; // first wedge at the same position
+            std::vector<uint32_t> sibling;     // ring of wedges at the same position
+            std::vector<uint8_t> kind;
+            std::vector<uint32_t> loop, loopBack; // open edge leaving / entering a border or seam wedge
+            std::vector<Quadric> quadrics;
+            std::vector<AttributeQuadric> attributeQuadrics;
+            std::vector<uint32_t> indices;
+            std::vector<uint32_t> adjacencyOffsets, adjacency; // wedge -> triangles
+
+            void BuildAdjacency()
+            {
+                adjacencyOffsets.assign(wedgeCount + 1, 0);
+                for (uint32_t v : indices)
+                    adjacencyOffsets[v + 1]++;
+                for (size_t i = 0; i < wedgeCount; i++)
+                    adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+                adjacency.resize(indices.size());
+                for (size_t i = 0; i < indices.size(); i++)
+                    adjacency[adjacencyOffsets[indices[i]]++] = (uint32_t)(i / 3);
+                for (size_t i = wedgeCount; i > 0; i--)
+                    adjacencyOffsets[i] = adjacencyOffsets[i - 1];
+                adjacencyOffsets[0] = 0;
+            }
+
+            bool HasHalfEdge(uint32_t a, uint32_t b) const
+            {
+                for (uint32_t i = adjacencyOffsets[a]; i < adjacencyOffsets[a + 1]; i++)
+                {
+                    const uint32_t *tri = &indices[adjacency[i] * 3];
+                    for (int k = 0; k < 3; k++)
+                    {
+                        if (tri[k] == a && tri[(k + 1) % 3] == b)
+                            return true;
+                    }
+                }
+                return false;
+            }
+
+            // Same as HasHalfEdge between any wedges of the two positions
+            bool HasPositionHalfEdge(uint32_t a, uint32_t b) const
+            {
+                uint32_t w = a;
+                do
+                {
+                    for (uint32_t i = adjacencyOffsets[w]; i < adjacencyOffsets[w + 1]; i++)
+                    {
+                        const uint32_t *tri = &indices[adjacency[i] * 3];
+                        for (int k = 0; k < 3; k++)
+                        {
+                            if (tri[k] == w && positionRep[tri[(k + 1) % 3]] == positionRep[b])
+                                return true;
+                        }
+                    }
+                    w = sibling[w];
+                } while (w != a);
+                return false;
+            }
+
+            void Classify(uint32_t v)
+            {
+                int openOut = 0, openIn = 0, ringSize = 0;
+                uint32_t out = NONE, in = NONE;
+                bool positionOpen = false;
+                for (uint32_t i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1]; i++)
+                {
+                    const uint32_t *tri = &indices[adjacency[i] * 3];
+                    int k = tri[0] == v ? 0 : (tri[1] == v ? 1 : 2);
+                    uint32_t next = tri[(k + 1) % 3], prev = tri[(k + 2) % 3];
+                    if (!HasHalfEdge(next, v))
+                    {
+                        openOut++;
+                        out = next;
+                        positionOpen |= !HasPositionHalfEdge(next, v);
+                    }
+                    if (!HasHalfEdge(v, prev))
+                    {
+                        openIn++;
+                        in = prev;
+                        positionOpen |= !HasPositionHalfEdge(v, prev);
+                    }
+                }
+                uint32_t w = v;
+                do
+                {
+                    ringSize++;
+                    w = sibling[w];
+                } while (w != v);
+
+                loop[v] = openOut == 1 ? out : NONE;
+                loopBack[v] = openIn == 1 ? in : NONE;
+                if (openOut == 0 && openIn == 0)
+                    kind[v] = ringSize == 1 ? KIND_MANIFOLD : KIND_LOCKED;
+                else if (openOut == 1 && openIn == 1 && ringSize == 1)
+                    kind[v] = KIND_BORDER;
+                else if (openOut == 1 && openIn == 1 && ringSize == 2 && !positionOpen)
+                    kind[v] = KIND_SEAM;
+                else
+                    kind[v] = KIND_LOCKED;
+            }
+
+            void BuildQuadrics(uint32_t v)
+            {
+                Quadric &quadric = quadrics[v];
+                for (uint32_t i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1]; i++)
+                {
+                    const uint32_t *tri = &indices[adjacency[i] * 3];
+                    const glm::vec3 &p0 = positions[tri[0]];
+                    glm::vec3 e1 = positions[tri[1]] - p0, e2 = positions[tri[2]] - p0;
+                    glm::vec3 n = glm::cross(e1, e2);
+                    float length = glm::length(n);
+                    if (length <= 0.0f)
+                        continue;
+                    float area = 0.5f * length;
+                    glm::vec3 normal = n / length;
+                    quadric.AddPlane(normal, -glm::dot(normal, p0), area);
+                    quadric.w += area;
+
+                    if (!attributeQuadrics.empty())
+                    {
+                        AttributeQuadric &aq = attributeQuadrics[v];
+                        glm::vec3 c1 = glm::cross(e2, n) / (length * length);
+                        glm::vec3 c2 = glm::cross(n, e1) / (length * length);
+                        for (int j = 0; j < ATTRIBUTE_COUNT; j++)
+                        {
+                            float a0 = attributes[tri[0] * ATTRIBUTE_COUNT + j];
+                            float a1 = attributes[tri[1] * ATTRIBUTE_COUNT + j];
+                            float a2 = attributes[tri[2] * ATTRIBUTE_COUNT + j];
+                            glm::vec3 g = (a1 - a0) * c1 + (a2 - a0) * c2;
+                            double d = a0 - glm::dot(g, p0);
+                            aq.q.AddPlane(g, d, area);
+                            for (int i = 0; i < 3; i++)
+                                aq.gradient[j][i] += area * g[i];
+                            aq.offset[j] += area * d;
+                        }
+                        aq.q.w += area;
+                    }
+
+                    // Open edges at v: a plane through the edge, perpendicular to the face
+                    int k = tri[0] == v ? 0 : (tri[1] == v ? 1 : 2);
+                    uint32_t next = tri[(k + 1) % 3], prev = tri[(k + 2) % 3];
+                    uint32_t edges[2][2] = {{v, next}, {prev, v}};
+                    for (int e = 0; e < 2; e++)
+                    {
+                        uint32_t a = edges[e][0], b = edges[e][1];
+                        if (HasHalfEdge(b, a))
+                            continue;
+                        glm::vec3 edge = positions[b] - positions[a];
+                        glm::vec3 planeNormal = glm::cross(edge, normal);
+                        float planeLength = glm::length(planeNormal);
+                        if (planeLength <= 0.0f)
+                            continue;
+                        planeNormal /= planeLength;
+                        float weight = BORDER_WEIGHT * glm::dot(edge, edge);
+                        quadric.AddPlane(planeNormal, -glm::dot(planeNormal, positions[a]), weight);
+                        quadric.w += weight;
+                    }
+                }
+            }
+
+            // Wedge at the far end of the seam edge, on the other side of the seam
+            bool SeamPartner(uint32_t from, uint32_t to, uint32_t &partnerFrom, uint32_t &partnerTo) const
+            {
+                partnerFrom = sibling[from];
+                if (kind[partnerFrom] != KIND_SEAM)
+                    return false;
+                partnerTo = loop[from] == to ? loopBack[partnerFrom] : loop[partnerFrom];
+                return partnerTo != NONE && positionRep[partnerTo] == positionRep[to];
+            }
+
+            // Cost of moving `from` onto `to` (plus the partner wedges across a seam)
+            bool Evaluate(uint32_t from, uint32_t to, Collapse &collapse) const
+            {
+                uint8_t fromKind = kind[from];
+                if (!CAN_COLLAPSE[fromKind][kind[to]])
+                    return false;
+                if (fromKind != KIND_MANIFOLD && loop[from] != to && loopBack[from] != to)
+                    return false;
+
+                uint32_t pairs[2][2] = {{from, to}, {NONE, NONE}};
+                if (fromKind == KIND_SEAM && !SeamPartner(from, to, pairs[1][0], pairs[1][1]))
+                    return false;
+
+                collapse.from = from;
+                collapse.to = to;
+                collapse.cost = 0.0f;
+                collapse.geometric = 0.0f;
+                for (int i = 0; i < 2 && pairs[i][0] != NONE; i++)
+                {
+                    uint32_t a = pairs[i][0], b = pairs[i][1];
+                    const glm::vec3 &target = positions[b];
+                    double weight = quadrics[a].w + quadrics[b].w;
+                    double geometric = weight > 0.0 ? (quadrics[a].Evaluate(target) + quadrics[b].Evaluate(target)) / weight : 0.0;
+                    geometric = std::max(geometric, 0.0);
+                    double cost = geometric;
+                    if (!attributeQuadrics.empty())
+                    {
+                        const AttributeQuadric &qa = attributeQuadrics[a], &qb = attributeQuadrics[b];
+                        double attributeWeight = qa.q.w + qb.q.w;
+                        const float *s = &attributes[b * ATTRIBUTE_COUNT];
+                        if (attributeWeight > 0.0)
+                            cost += std::max((qa.Evaluate(target, s) + qb.Evaluate(target, s)) / attributeWeight, 0.0);
+                    }
+                    collapse.cost += (float)cost;
+                    collapse.geometric = std::max(collapse.geometric, (float)geometric);
+                }
+                return true;
+            }
+
+            // Would moving `from` onto `to` flip (or nearly fold) a surviving triangle?
+            bool Flips(uint32_t from, uint32_t to, const std::vector<uint32_t> &remap) const
+            {
+                for (uint32_t i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++)
+                {
+                    const uint32_t *tri = &indices[adjacency[i] * 3];
+                    if (tri[0] == to || tri[1] == to || tri[2] == to)
+                        continue; // collapses away
+                    glm::vec3 before[3], after[3];
+                    for (int k = 0; k < 3; k++)
+                    {
+                        before[k] = tri[k] == from ? positions[from] : positions[remap[tri[k]]];
+                        after[k] = tri[k] == from ? positions[to] : before[k];
+                    }
+                    glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    // Zero-area input triangles (e.g. a pole fan) have no orientation to lose
+                    if (n0 == glm::vec3(0.0f))
+                        continue;
+                    if (glm::dot(n0, n1) <= 0.25f * glm::length(n0) * glm::length(n1))
+                        return true;
+                }
+                return false;
+            }
+
+            size_t Removes(uint32_t from, uint32_t to) const
+            {
+                size_t count = 0;
+                for (uint32_t i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++)
+                {
+                    const uint32_t *tri = &indices[adjacency[i] * 3];
+                    count += (tri[0] == to || tri[1] == to || tri[2] == to) ? 1 : 0;
+                }
+                return count;
+            }
+
+            void LockRing(uint32_t v, std::vector<uint8_t> &locked) const
+            {
+                uint32_t w = v;
+                do
+                {
+                    locked[w] = 1;
+                    w = sibling[w];
+                } while (w != v);
+            }
+        };
+    }
+
+    SimplifyResult MeshSimplifier::Simplify(const Mesh &mesh, const SimplifyOptions &options)
+    {
+        SimplifyResult result = SimplifyGeometry(mesh.vertices, mesh.indices, options);
+        if (!result.indices.empty())
+        {
+            result.mesh = new Mesh(result.vertices, result.indices, mesh.textures);
+            result.vertices.clear();
+            result.indices.clear();
+        }
+        return result;
+    }
+
+    SimplifyResult MeshSimplifier::SimplifyGeometry(const std::vector<Vertex> &sourceVertices,
+                                                    const std::vector<unsigned int> &sourceIndices,
+                                                    const SimplifyOptions &options)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        ThreadPool &pool = ThreadPool::Instance();
+
+        SimplifyResult result;
+        result.verticesIn = sourceVertices.size();
+        result.trianglesIn = sourceIndices.size() / 3;
+        result.trianglesOut = result.trianglesIn;
+        result.verticesOut = result.verticesIn;
+        if (sourceVertices.empty() || result.trianglesIn <= options.targetTriangles)
+            return result;
+
+        // 1. Weld into wedges: imported meshes duplicate vertices per face
+        static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex is welded as 8 packed floats");
+        const float *vertexData = &sourceVertices[0].Position.x;
+        std::vector<uint32_t> vertexRemap = WeldFloats(vertexData, 8, options.preserveSeams ? 8 : 3, sourceVertices.size());
+
+        Simplifier s;
+        std::vector<uint32_t> wedgeOf(sourceVertices.size(), NONE);
+        std::vector<uint32_t> wedgeSource; // original vertex supplying each wedge
+        for (size_t i = 0; i < sourceVertices.size(); i++)
+        {
+            uint32_t rep = vertexRemap[i];
+            if (wedgeOf[rep] == NONE)
+            {
+                wedgeOf[rep] = (uint32_t)wedgeSource.size();
+                wedgeSource.push_back(rep);
+            }
+            wedgeOf[i] = wedgeOf[rep];
+        }
+        s.wedgeCount = wedgeSource.size();
+
+        s.indices.reserve(result.trianglesIn * 3);
+        for (size_t i = 0; i + 2 < sourceIndices.size(); i += 3)
+        {
+            uint32_t a = wedgeOf[sourceIndices[i]], b = wedgeOf[sourceIndices[i + 1]], c = wedgeOf[sourceIndices[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            s.indices.push_back(a);
+            s.indices.push_back(b);
+            s.indices.push_back(c);
+        }
+
+        // 2. Positions in the unit box so errors are relative to the mesh size
+        glm::vec3 boundsMin = sourceVertices[0].Position, boundsMax = boundsMin;
+        for (const Vertex &vertex : sourceVertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.Position);
+            boundsMax = glm::max(boundsMax, vertex.Position);
+        }
+        glm::vec3 extent3 = boundsMax - boundsMin;
+        float extent = std::max(extent3.x, std::max(extent3.y, extent3.z));
+        if (extent <= 0.0f)
+            extent = 1.0f;
+        s.positions.resize(s.wedgeCount);
+        for (size_t w = 0; w < s.wedgeCount; w++)
+            s.positions[w] = (sourceVertices[wedgeSource[w]].Position - boundsMin) / extent;
+
+        if (options.normalWeight > 0.0f || options.uvWeight > 0.0f)
+        {
+            s.attributes.resize(s.wedgeCount * ATTRIBUTE_COUNT);
+            for (size_t w = 0; w < s.wedgeCount; w++)
+            {
+                const Vertex &vertex = sourceVertices[wedgeSource[w]];
+                float *a = &s.attributes[w * ATTRIBUTE_COUNT];
+                a[0] = vertex.Normal.x * options.normalWeight;
+                a[1] = vertex.Normal.y * options.normalWeight;
+                a[2] = vertex.Normal.z * options.normalWeight;
+                a[3] = vertex.TexCoords.x * options.uvWeight;
+                a[4] = vertex.TexCoords.y * options.uvWeight;
+            }
+        }
+
+        // Rings of wedges that share a position
+        s.positionRep = WeldFloats(&s.positions[0].x, 3, 3, s.wedgeCount);
+        s.sibling.resize(s.wedgeCount);
+        for (uint32_t w = 0; w < s.wedgeCount; w++)
+        {
+            uint32_t rep = s.positionRep[w];
+            s.sibling[w] = w;
+            if (rep != w)
+            {
+                s.sibling[w] = s.sibling[rep];
+                s.sibling[rep] = w;
+            }
+        }
+
+        // 3. Vertex kinds and quadrics, one wedge per task
+        s.BuildAdjacency();
+        s.kind.resize(s.wedgeCount);
+        s.loop.resize(s.wedgeCount);
+        s.loopBack.resize(s.wedgeCount);
+        s.quadrics.resize(s.wedgeCount);
+        if (!s.attributes.empty())
+            s.attributeQuadrics.resize(s.wedgeCount);
+        pool.ParallelFor(s.wedgeCount, GRAIN, [&](size_t begin, size_t end)
+                         {
+            for (size_t v = begin; v < end; v++)
+            {
+                s.Classify((uint32_t)v);
+                s.BuildQuadrics((uint32_t)v);
+            } });
+
+        // 4. Collapse passes
+        const float errorLimit = options.maxError < std::sqrt(FLT_MAX) ? options.maxError * options.maxError : FLT_MAX;
+        float maxGeometric = 0.0f, maxCost = 0.0f;
+        std::vector<Collapse> slots, collapses;
+        std::vector<uint32_t> order, bucketStart(COST_BUCKETS + 1);
+        std::vector<uint32_t> remap(s.wedgeCount);
+        std::vector<uint8_t> locked(s.wedgeCount);
+
+        while (s.indices.size() / 3 > options.targetTriangles)
+        {
+            const size_t triangleCount = s.indices.size() / 3;
+            if (result.passes > 0)
+                s.BuildAdjacency();
+
+            // Cost every edge in parallel; each edge is seen from both of its triangles,
+            // so interior edges are only taken from the one where from < to
+            slots.assign(triangleCount * 3, Collapse());
+            pool.ParallelFor(triangleCount, GRAIN, [&](size_t begin, size_t end)
+                             {
+                for (size_t t = begin; t < end; t++)
+                {
+                    for (int k = 0; k < 3; k++)
+                    {
+                        uint32_t a = s.indices[t * 3 + k], b = s.indices[t * 3 + (k + 1) % 3];
+                        if (s.positionRep[a] == s.positionRep[b])
+                            continue;
+                        bool open = s.loop[a] == b || s.loopBack[a] == b || s.loop[b] == a || s.loopBack[b] == a;
+                        if (!open && a > b)
+                            continue;
+                        Collapse ab, ba;
+                        bool canAB = s.Evaluate(a, b, ab);
+                        bool canBA = s.Evaluate(b, a, ba);
+                        if (canAB || canBA)
+                            slots[t * 3 + k] = (canAB && (!canBA || ab.cost <= ba.cost)) ? ab : ba;
+                    }
+                } });
+
+            collapses.clear();
+            for (const Collapse &c : slots)
+            {
+                if (c.from != NONE)
+                    collapses.push_back(c);
+            }
+            if (collapses.empty())
+                break;
+
+            // Counting sort on the cost bits: approximate order, linear time
+            std::fill(bucketStart.begin(), bucketStart.end(), 0);
+            for (const Collapse &c : collapses)
+                bucketStart[CostKey(c.cost) + 1]++;
+            for (size_t i = 0; i < COST_BUCKETS; i++)
+                bucketStart[i + 1] += bucketStart[i];
+            order.resize(collapses.size());
+            for (size_t i = 0; i < collapses.size(); i++)
+                order[bucketStart[CostKey(collapses[i].cost)]++] = (uint32_t)i;
+
+            // Each collapse removes about two triangles but also locks the collapses around it,
+            // so a pass may go somewhat past the cost of the goal-th one. It only stops there
+            // once it has made real progress, or cheap collapses that keep failing the flip
+            // test would stall the whole simplification.
+            size_t removeGoal = triangleCount - options.targetTriangles;
+            size_t collapseGoal = std::max<size_t>(removeGoal / 2, 1);
+            float errorGoal = collapseGoal < order.size() ? 1.5f * collapses[order[collapseGoal]].cost : FLT_MAX;
+
+            std::iota(remap.begin(), remap.end(), 0u);
+            std::fill(locked.begin(), locked.end(), 0);
+            size_t removed = 0, applied = 0;
+            for (uint32_t index : order)
+            {
+                const Collapse &c = collapses[index];
+                if (removed >= removeGoal)
+                    break;
+                if (c.cost > errorGoal && c.cost > maxCost && removed > removeGoal / 6)
+                    break;
+                // maxError bounds the geometric part alone (what result.error reports); the
+                // order includes the attribute penalty, so a cheaper edge may still come later
+                if (c.geometric > errorLimit || locked[c.from] || locked[c.to])
+                    continue;
+
+                uint32_t partnerFrom = NONE, partnerTo = NONE;
+                if (s.kind[c.from] == KIND_SEAM)
+                    s.SeamPartner(c.from, c.to, partnerFrom, partnerTo);
+                if (s.Flips(c.from, c.to, remap) || (partnerFrom != NONE && s.Flips(partnerFrom, partnerTo, remap)))
+                    continue;
+
+                removed += s.Removes(c.from, c.to);
+                remap[c.from] = c.to;
+                s.quadrics[c.to].Add(s.quadrics[c.from]);
+                if (!s.attributeQuadrics.empty())
+                    s.attributeQuadrics[c.to].Add(s.attributeQuadrics[c.from]);
+                if (partnerFrom != NONE)
+                {
+                    removed += s.Removes(partnerFrom, partnerTo);
+                    remap[partnerFrom] = partnerTo;
+                    s.quadrics[partnerTo].Add(s.quadrics[partnerFrom]);
+                    if (!s.attributeQuadrics.empty())
+                        s.attributeQuadrics[partnerTo].Add(s.attributeQuadrics[partnerFrom]);
+                }
+                s.LockRing(c.from, locked);
+                s.LockRing(c.to, locked);
+                maxGeometric = std::max(maxGeometric, c.geometric);
+                maxCost = std::max(maxCost, c.cost);
+                applied++;
+            }
+            result.passes++;
+            if (applied == 0)
+                break;
+
+            // Border / seam loops skip the wedges that were collapsed away
+            std::vector<uint32_t> loop = s.loop, loopBack = s.loopBack;
+            for (size_t v = 0; v < s.wedgeCount; v++)
+            {
+                if (loop[v] != NONE)
+                {
+                    uint32_t target = loop[v];
+                    s.loop[v] = remap[target] != v ? remap[target] : (loop[target] != NONE ? remap[loop[target]] : NONE);
+                }
+                if (loopBack[v] != NONE)
+                {
+                    uint32_t target = loopBack[v];
+                    s.loopBack[v] = remap[target] != v ? remap[target] : (loopBack[target] != NONE ? remap[loopBack[target]] : NONE);
+                }
+            }
+
+            pool.ParallelFor(s.indices.size(), GRAIN * 3, [&](size_t begin, size_t end)
+                             {
+                for (size_t i = begin; i < end; i++)
+                    s.indices[i] = remap[s.indices[i]]; });
+
+            size_t write = 0;
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                uint32_t a = s.indices[t * 3], b = s.indices[t * 3 + 1], c = s.indices[t * 3 + 2];
+                if (a == b || b == c || a == c)
+                    continue;
+                s.indices[write++] = a;
+                s.indices[write++] = b;
+                s.indices[write++] = c;
+            }
+            s.indices.resize(write);
+        }
+
+        result.relativeError = std::sqrt(maxGeometric);
+        result.error = result.relativeError * extent;
+        result.trianglesOut = s.indices.size() / 3;
+
+        // 5. Compact the surviving wedges; their attributes are the original ones
+        if (result.trianglesOut > 0 && result.trianglesOut < result.trianglesIn)
+        {
+            std::vector<Vertex> vertices;
+            std::vector<unsigned int> indices(s.indices.size());
+            std::vector<uint32_t> newIndex(s.wedgeCount, NONE);
+            for (size_t i = 0; i < s.indices.size(); i++)
+            {
+                uint32_t w = s.indices[i];
+                if (newIndex[w] == NONE)
+                {
+                    newIndex[w] = (uint32_t)vertices.size();
+                    vertices.push_back(sourceVertices[wedgeSource[w]]);
+                }
+                indices[i] = newIndex[w];
+            }
+            result.verticesOut = vertices.size();
+            result.vertices = std::move(vertices);
+            result.indices = std::move(indices);
+        }
+
+        auto finish = std::chrono::high_resolution_clock::now();
+        result.ms = std::chrono::duration<float, std::milli>(finish - start).count();
+        return result;
+    }
+}
@@ -0,0 +1,304 @@
+#include "Meshlets.h"
+#include "Culling.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace PartC
+{
+    size_t Meshlets::minTriangles = 16384;
+
+    namespace
+    {
+        const uint32_t NONE = ~0u;
+
+        bool PositionLess(const glm::vec3 &a, const glm::vec3 &b)
+        {
+            if (a.x != b.x)
+                return a.x < b.x;
+            if (a.y != b.y)
+                return a.y < b.y;
+            return a.z < b.z;
+        }
+
+        void ComputeBounds(Meshlet &meshlet, const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices)
+        {
+            const unsigned int *tri = &indices[meshlet.indexOffset];
+            const size_t indexCount = (size_t)meshlet.triangleCount * 3;
+
+            glm::vec3 bmin = vertices[tri[0]].Position, bmax = bmin;
+            for (size_t i = 1; i < indexCount; i++)
+            {
+                bmin = glm::min(bmin, vertices[tri[i]].Position);
+                bmax = glm::max(bmax, vertices[tri[i]].Position);
+            }
+            meshlet.center = 0.5f * (bmin + bmax);
+            float radius2 = 0.0f;
+            for (size_t i = 0; i < indexCount; i++)
+            {
+                glm::vec3 d = vertices[tri[i]].Position - meshlet.center;
+                radius2 = std::max(radius2, glm::dot(d, d));
+            }
+            meshlet.radius = std::sqrt(radius2);
+
+            // Face normals from the winding (not vertex normals): facing is decided by geometry
+            glm::vec3 normals[Meshlets::MAX_TRIANGLES];
+            int normalCount = 0;
+            glm::vec3 sum(0.0f);
+            for (size_t i = 0; i < indexCount; i += 3)
+            {
+                const glm::vec3 &a = vertices[tri[i]].Position;
+                glm::vec3 n = glm::cross(vertices[tri[i + 1]].Position - a, vertices[tri[i + 2]].Position - a);
+                float len = glm::length(n);
+                if (len <= 0.0f)
+                    continue; // zero area triangles are never visible
+                normals[normalCount++] = n / len;
+                sum += n / len;
+            }
+
+            meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+            meshlet.coneCutoff = 1.0f;
+            float sumLength = glm::length(sum);
+            if (normalCount == 0 || sumLength < 1e-6f)
+                return;
+            meshlet.coneAxis = sum / sumLength;
+
+            float minDot = 1.0f;
+            for (int i = 0; i < normalCount; i++)
+                minDot = std::min(minDot, glm::dot(meshlet.coneAxis, normals[i]));
+            // Normals spread over a half space or more: the meshlet always has a front face
+            if (minDot <= 0.0f)
+                return;
+            meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+    }
+
+    std::vector<Meshlet> Meshlets::Build(const std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+        std::vector<Meshlet> meshlets;
+        const size_t triCount = indices.size() / 3;
+        if (triCount == 0 || vertices.empty())
+            return meshlets;
+
+        // 1. Weld by position so UV / normal seams do not split meshlets
+        std::vector<uint32_t> sorted(vertices.size());
+        std::iota(sorted.begin(), sorted.end(), 0u);
+        std::sort(sorted.begin(), sorted.end(), [&vertices](uint32_t a, uint32_t b)
+                  { return PositionLess(vertices[a].Position, vertices[b].Position); });
+        std::vector<uint32_t> weld(vertices.size());
+        uint32_t weldedCount = 0;
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            if (i > 0 && vertices[sorted[i]].Position != vertices[sorted[i - 1]].Position)
+                weldedCount++;
+            weld[sorted[i]] = weldedCount;
+        }
+        weldedCount++;
+
+        std::vector<uint32_t> corners(triCount * 3);
+        for (size_t i = 0; i < corners.size(); i++)
+            corners[i] = weld[indices[i]];
+
+        // 2. Vertex -> triangle adjacency (CSR)
+        std::vector<uint32_t> adjacencyOffsets(weldedCount + 1, 0);
+        for (uint32_t v : corners)
+            adjacencyOffsets[v + 1]++;
+        for (uint32_t v = 0; v < weldedCount; v++)
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        std::vector<uint32_t> adjacency(corners.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < corners.size(); i++)
+                adjacency[fill[corners[i]]++] = (uint32_t)(i / 3);
+        }
+
+        std::vector<glm::vec3> centroids(triCount);
+        for (size_t t = 0; t < triCount; t++)
+        {
+            centroids[t] = (vertices[indices[t * 3]].Position + vertices[indices[t * 3 + 1]].Position +
+                            vertices[indices[t * 3 + 2]].Position) / 3.0f;
+        }
+
+        // 3. Greedy growth
+        std::vector<uint8_t> emitted(triCount, 0);
+        // Triangles not yet emitted around each vertex
+        std::vector<uint32_t> liveTriangles(weldedCount);
+        for (uint32_t v = 0; v < weldedCount; v++)
+            liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+        std::vector<uint32_t> vertexStamp(weldedCount, NONE);  // meshlet that holds the vertex
+        std::vector<uint32_t> triangleStamp(triCount, NONE); // meshlet whose candidate list holds the triangle
+        std::vector<uint32_t> candidates;
+        std::vector<unsigned int> reordered;
+        reordered.reserve(indices.size());
+        size_t emittedCount = 0;
+        size_t cursor = 0;
+        glm::vec3 previousCenter(0.0f);
+
+        while (emittedCount < triCount)
+        {
+            // Seed next to the previous meshlet, so leftover holes are filled rather than
+            // turning into small meshlets later; fall back to index order
+            uint32_t tri = NONE;
+            float bestDist = FLT_MAX;
+            for (uint32_t t : candidates)
+            {
+                if (emitted[t])
+                    continue;
+                glm::vec3 d = centroids[t] - previousCenter;
+                float dist = glm::dot(d, d);
+                if (dist < bestDist)
+                {
+                    bestDist = dist;
+                    tri = t;
+                }
+            }
+            if (tri == NONE)
+            {
+                while (emitted[cursor])
+                    cursor++;
+                tri = (uint32_t)cursor;
+            }
+
+            const uint32_t id = (uint32_t)meshlets.size();
+            Meshlet meshlet;
+            meshlet.indexOffset = (uint32_t)reordered.size();
+            int vertexCount = 0;
+            glm::vec3 centroidSum(0.0f);
+            candidates.clear();
+
+            while (true)
+            {
+                emitted[tri] = 1;
+                emittedCount++;
+                for (int k = 0; k < 3; k++)
+                {
+                    reordered.push_back(indices[tri * 3 + k]);
+                    uint32_t v = corners[tri * 3 + k];
+                    liveTriangles[v]--;
+                    if (vertexStamp[v] == id)
+                        continue;
+                    vertexStamp[v] = id;
+                    vertexCount++;
+                    for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++)
+                    {
+                        uint32_t n = adjacency[a];
+                        if (!emitted[n] && triangleStamp[n] != id)
+                        {
+                            triangleStamp[n] = id;
+                            candidates.push_back(n);
+                        }
+                    }
+                }
+                meshlet.triangleCount++;
+                centroidSum += centroids[tri];
+                if (meshlet.triangleCount == (uint32_t)MAX_TRIANGLES)
+                    break;
+
+                // Fewest new vertices first, then the fewest triangles left around its
+                // vertices (fills corners that would otherwise become tiny meshlets),
+                // then nearest to the meshlet's center
+                glm::vec3 center = centroidSum / (float)meshlet.triangleCount;
+                uint32_t best = NONE;
+                int bestFresh = 4;
+                uint32_t bestLive = ~0u;
+                float bestDistance = FLT_MAX;
+                size_t live = 0;
+                for (size_t i = 0; i < candidates.size(); i++)
+                {
+                    uint32_t t = candidates[i];
+                    if (emitted[t])
+                        continue;
+                    candidates[live++] = t;
+
+                    int fresh = (vertexStamp[corners[t * 3]] != id) + (vertexStamp[corners[t * 3 + 1]] != id) +
+                                (vertexStamp[corners[t * 3 + 2]] != id);
+                    if (vertexCount + fresh > MAX_VERTICES || fresh > bestFresh)
+                        continue;
+                    uint32_t liveSum = liveTriangles[corners[t * 3]] + liveTriangles[corners[t * 3 + 1]] +
+                                       liveTriangles[corners[t * 3 + 2]];
+                    if (fresh == bestFresh && liveSum > bestLive)
+                        continue;
+                    glm::vec3 d = centroids[t] - center;
+                    float dist = glm::dot(d, d);
+                    if (fresh < bestFresh || liveSum < bestLive || dist < bestDistance)
+                    {
+                        best = t;
+                        bestFresh = fresh;
+                        bestLive = liveSum;
+                        bestDistance = dist;
+                    }
+                }
+                candidates.resize(live);
+                if (best == NONE)
+                    break;
+                tri = best;
+            }
+
+            previousCenter = centroidSum / (float)meshlet.triangleCount;
+            meshlets.push_back(meshlet);
+        }
+        indices.swap(reordered);
+
+        ThreadPool::Instance().ParallelFor(meshlets.size(), 256, [&](size_t begin, size_t end)
+                                           {
+            for (size_t m = begin; m < end; m++)
+                ComputeBounds(meshlets[m], vertices, indices); });
+        return meshlets;
+    }
+
+    void Meshlets::Cull(const std::vector<Meshlet> &meshlets, const glm::mat4 &model, const glm::mat4 &viewProjection,
+                        const glm::vec3 &cameraPos, bool coneCulling, std::vector<MeshletRange> &ranges,
+                        MeshletStats &stats)
+    {
+        ranges.clear();
+
+        // Object space: the planes of viewProjection * model come out normalized in
+        // object units, and which side of a face the camera is on survives any affine map
+        const Frustum frustum = Frustum::FromMatrix(viewProjection * model);
+        const glm::vec3 eye = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+
+        for (const Meshlet &m : meshlets)
+        {
+            stats.tested++;
+            stats.trianglesTested += m.triangleCount;
+
+            bool visible = true;
+            for (int p = 0; p < 6; p++)
+            {
+                const glm::vec4 &plane = frustum.planes[p];
+                if (glm::dot(glm::vec3(plane), m.center) + plane.w < -m.radius)
+                {
+                    visible = false;
+                    stats.frustumCulled++;
+                    break;
+                }
+            }
+
+            // Backfacing when every view ray into the sphere is within 90 degrees minus the
+            // cone's half angle of the axis (conservative form, see meshoptimizer)
+            if (visible && coneCulling)
+            {
+                glm::vec3 toCenter = m.center - eye;
+                if (glm::dot(toCenter, m.coneAxis) >= m.coneCutoff * glm::length(toCenter) + m.radius)
+                {
+                    visible = false;
+                    stats.coneCulled++;
+                }
+            }
+            if (!visible)
+                continue;
+
+            stats.trianglesDrawn += m.triangleCount;
+            const uint32_t count = m.triangleCount * 3;
+            if (!ranges.empty() && ranges.back().indexOffset + ranges.back().indexCount == m.indexOffset)
+                ranges.back().indexCount += count;
+            else
+                ranges.push_back({m.indexOffset, count});
+        }
+
+        stats.draws++;
+        stats.ranges += (int)ranges.size();
+    }
+}
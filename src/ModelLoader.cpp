@@ -1,5 +1,6 @@
 #include "ModelLoader.h"
 #include "SceneContext.h"
+#include "MeshOptimizer.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -21,6 +22,16 @@ Mesh* ModelLoader::LoadMesh(const std::string& path) {
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
+    std::vector<PartC::Meshlet> meshlets;
+
+    // [MeshOpt] 已优化过的网格直接从缓存读取，跳过 OBJ 解析与重排
+    PartC::MeshOptimizeReport report;
+    if (PartC::MeshOptimizer::optimizeOnLoad && PartC::MeshOptimizer::LoadCache(path, vertices, indices, meshlets, report)) {
+        PartC::MeshOptimizer::lastReport = report;
+        std::cout << "[MeshOpt] " << report.verticesOut << " vertices, ACMR " << report.after.acmr
+                  << " (from " << PartC::MeshOptimizer::CachePath(path) << ")" << std::endl;
+        return new Mesh(vertices, indices, textures, meshlets);
+    }
 
     std::ifstream file(path);
     if (!file.is_open()) {
@@ -112,7 +123,18 @@ Mesh* ModelLoader::LoadMesh(const std::string& path) {
         indices.push_back(i);
     }
 
-    return new Mesh(vertices, indices, textures);
+    // [MeshOpt] 焊接重复顶点 + 顶点缓存 / 过度绘制 / 读取顺序重排，结果写入缓存
+    if (PartC::MeshOptimizer::optimizeOnLoad) {
+        report = PartC::MeshOptimizer::Optimize(vertices, indices, meshlets);
+        PartC::MeshOptimizer::SaveCache(path, vertices, indices, meshlets, report);
+        PartC::MeshOptimizer::lastReport = report;
+        std::cout << "[MeshOpt] " << report.verticesIn << " -> " << report.verticesOut << " vertices, ACMR "
+                  << report.before.acmr << " -> " << report.after.acmr << ", ATVR " << report.before.atvr
+                  << " -> " << report.after.atvr << ", " << report.clusters << " overdraw clusters, "
+                  << report.ms << " ms" << std::endl;
+    }
+
+    return new Mesh(vertices, indices, textures, meshlets);
 }
 
 bool ModelLoader::ExportMesh(const Mesh* mesh, const std::string& path) {
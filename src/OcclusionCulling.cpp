@@ -0,0 +1,334 @@
+#include "OcclusionCulling.h"
+#include "SceneContext.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+
+namespace PartC
+{
+    namespace
+    {
+        // Rows per rasterization job; bands never share rows, so jobs need no locking
+        const int BAND_HEIGHT = 8;
+        const float MIN_CLIP_W = 1e-5f;
+
+        // Projects the 8 corners of a box. Returns false if any corner is behind
+        // the near plane, in which case the caller must treat the box as visible.
+        bool ProjectBox(const glm::mat4 &viewProj, const glm::vec3 &bmin, const glm::vec3 &bmax,
+                        glm::vec2 &ndcMin, glm::vec2 &ndcMax, float &nearestDepth)
+        {
+            ndcMin = glm::vec2(FLT_MAX);
+            ndcMax = glm::vec2(-FLT_MAX);
+            nearestDepth = FLT_MAX;
+            for (int c = 0; c < 8; c++)
+            {
+                glm::vec4 corner((c & 1) ? bmax.x : bmin.x, (c & 2) ? bmax.y : bmin.y, (c & 4) ? bmax.z : bmin.z, 1.0f);
+                glm::vec4 clip = viewProj * corner;
+                if (clip.w <= MIN_CLIP_W)
+                    return false;
+                glm::vec3 ndc = glm::vec3(clip) / clip.w;
+                ndcMin = glm::min(ndcMin, glm::vec2(ndc));
+                ndcMax = glm::max(ndcMax, glm::vec2(ndc));
+                nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+            }
+            return true;
+        }
+
+        inline float EdgeFunction(const glm::vec3 &a, const glm::vec3 &b, float px, float py)
+        {
+            return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+        }
+    }
+
+    OcclusionBuffer::OcclusionBuffer(int width, int height)
+        : width(0), height(0), viewProj(1.0f)
+    {
+        Resize(width, height);
+    }
+
+    void OcclusionBuffer::Resize(int w, int h)
+    {
+        width = std::max(1, w);
+        height = std::max(1, h);
+
+        levels.clear();
+        levelWidth.clear();
+        levelHeight.clear();
+
+        int lw = width, lh = height;
+        while (true)
+        {
+            levels.push_back(std::vector<float>(lw * lh, 1.0f));
+            levelWidth.push_back(lw);
+            levelHeight.push_back(lh);
+            if (lw == 1 && lh == 1)
+                break;
+            lw = std::max(1, (lw + 1) / 2);
+            lh = std::max(1, (lh + 1) / 2);
+        }
+    }
+
+    float OcclusionBuffer::ProjectedCoverage(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const
+    {
+        glm::vec2 ndcMin, ndcMax;
+        float nearest;
+        if (!ProjectBox(viewProj, boxMin, boxMax, ndcMin, ndcMax, nearest))
+            return 1.0f; // camera is inside or very close to the box
+
+        ndcMin = glm::clamp(ndcMin, -1.0f, 1.0f);
+        ndcMax = glm::clamp(ndcMax, -1.0f, 1.0f);
+        glm::vec2 size = (ndcMax - ndcMin) * 0.5f;
+        return std::max(0.0f, size.x) * std::max(0.0f, size.y);
+    }
+
+    void OcclusionBuffer::SetupTriangles(const std::vector<SceneObject *> &occluders)
+    {
+        std::vector<std::vector<ScreenTriangle>> perOccluder(occluders.size());
+
+        ThreadPool::Instance().ParallelFor(occluders.size(), 1, [&](size_t begin, size_t end)
+                                           {
+            for (size_t i = begin; i < end; i++)
+            {
+                SceneObject *obj = occluders[i];
+                const Mesh *mesh = obj->mesh.get();
+                glm::mat4 mvp = viewProj * obj->GetModelMatrix();
+
+                // Transform every vertex once; w <= 0 marks vertices behind the camera
+                std::vector<glm::vec4> screen(mesh->vertices.size());
+                for (size_t v = 0; v < mesh->vertices.size(); v++)
+                {
+                    glm::vec4 clip = mvp * glm::vec4(mesh->vertices[v].Position, 1.0f);
+                    if (clip.w <= MIN_CLIP_W)
+                    {
+                        screen[v] = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+                        continue;
+                    }
+                    glm::vec3 ndc = glm::vec3(clip) / clip.w;
+                    screen[v] = glm::vec4((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f, 1.0f);
+                }
+
+                std::vector<ScreenTriangle> &out = perOccluder[i];
+                out.reserve(mesh->indices.size() / 3);
+                for (size_t t = 0; t + 2 < mesh->indices.size(); t += 3)
+                {
+                    const glm::vec4 &a = screen[mesh->indices[t]];
+                    const glm::vec4 &b = screen[mesh->indices[t + 1]];
+                    const glm::vec4 &c = screen[mesh->indices[t + 2]];
+                    // Dropping near-clipped occluder triangles only makes culling less aggressive
+                    if (a.w < 0.0f || b.w < 0.0f || c.w < 0.0f)
+                        continue;
+                    ScreenTriangle tri;
+                    tri.v[0] = glm::vec3(a);
+                    tri.v[1] = glm::vec3(b);
+                    tri.v[2] = glm::vec3(c);
+                    out.push_back(tri);
+                }
+            } });
+
+        triangles.clear();
+        for (auto &list : perOccluder)
+            triangles.insert(triangles.end(), list.begin(), list.end());
+    }
+
+    void OcclusionBuffer::RasterizeBand(int yBegin, int yEnd)
+    {
+        std::vector<float> &depth = levels[0];
+
+        for (const ScreenTriangle &tri : triangles)
+        {
+            glm::vec3 a = tri.v[0], b = tri.v[1], c = tri.v[2];
+
+            float minX = std::min(a.x, std::min(b.x, c.x));
+            float maxX = std::max(a.x, std::max(b.x, c.x));
+            float minY = std::min(a.y, std::min(b.y, c.y));
+            float maxY = std::max(a.y, std::max(b.y, c.y));
+
+            int x0 = std::max(0, (int)std::floor(minX));
+            int x1 = std::min(width - 1, (int)std::ceil(maxX));
+            int y0 = std::max(yBegin, (int)std::floor(minY));
+            int y1 = std::min(yEnd - 1, (int)std::ceil(maxY));
+            if (x0 > x1 || y0 > y1)
+                continue;
+
+            float area = EdgeFunction(a, b, c.x, c.y);
+            if (std::fabs(area) < 1e-8f)
+                continue;
+            // Both windings are rasterized; normalize to counter-clockwise
+            if (area < 0.0f)
+            {
+                std::swap(b, c);
+                area = -area;
+            }
+            float invArea = 1.0f / area;
+
+            // Edge function steps per pixel in x and y
+            float stepX0 = -(c.y - b.y), stepX1 = -(a.y - c.y), stepX2 = -(b.y - a.y);
+            float stepY0 = (c.x - b.x), stepY1 = (a.x - c.x), stepY2 = (b.x - a.x);
+
+            float px = x0 + 0.5f;
+            float py = y0 + 0.5f;
+            float row0 = EdgeFunction(b, c, px, py);
+            float row1 = EdgeFunction(c, a, px, py);
+            float row2 = EdgeFunction(a, b, px, py);
+
+            for (int y = y0; y <= y1; y++)
+            {
+                float w0 = row0, w1 = row1, w2 = row2;
+                float *line = &depth[y * width];
+                for (int x = x0; x <= x1; x++)
+                {
+                    if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f)
+                    {
+                        float z = (w0 * a.z + w1 * b.z + w2 * c.z) * invArea;
+                        if (z < line[x])
+                            line[x] = z;
+                    }
+                    w0 += stepX0;
+                    w1 += stepX1;
+                    w2 += stepX2;
+                }
+                row0 += stepY0;
+                row1 += stepY1;
+                row2 += stepY2;
+            }
+        }
+    }
+
+    void OcclusionBuffer::BuildHiZ()
+    {
+        for (size_t l = 1; l < levels.size(); l++)
+        {
+            const std::vector<float> &src = levels[l - 1];
+            std::vector<float> &dst = levels[l];
+            int sw = levelWidth[l - 1], sh = levelHeight[l - 1];
+            int dw = levelWidth[l], dh = levelHeight[l];
+
+            for (int y = 0; y < dh; y++)
+            {
+                int sy0 = std::min(y * 2, sh - 1), sy1 = std::min(y * 2 + 1, sh - 1);
+                for (int x = 0; x < dw; x++)
+                {
+                    int sx0 = std::min(x * 2, sw - 1), sx1 = std::min(x * 2 + 1, sw - 1);
+                    // Keep the farthest depth so a texel never claims more occlusion than its children
+                    dst[y * dw + x] = std::max(std::max(src[sy0 * sw + sx0], src[sy0 * sw + sx1]),
+                                               std::max(src[sy1 * sw + sx0], src[sy1 * sw + sx1]));
+                }
+            }
+        }
+    }
+
+    void OcclusionBuffer::Render(const std::vector<SceneObject *> &occluders, const glm::mat4 &viewProjection, OcclusionStats &stats)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        viewProj = viewProjection;
+        std::fill(levels[0].begin(), levels[0].end(), 1.0f);
+
+        SetupTriangles(occluders);
+
+        int bandCount = (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+        ThreadPool::Instance().ParallelFor(bandCount, 1, [&](size_t begin, size_t end)
+                                           {
+            for (size_t band = begin; band < end; band++)
+            {
+                int y0 = (int)band * BAND_HEIGHT;
+                RasterizeBand(y0, std::min(height, y0 + BAND_HEIGHT));
+            } });
+
+        BuildHiZ();
+
+        auto finish = std::chrono::high_resolution_clock::now();
+        stats.occluders += (int)occluders.size();
+        stats.occluderTriangles += (int)triangles.size();
+        stats.rasterMs += std::chrono::duration<float, std::milli>(finish - start).count();
+    }
+
+    bool OcclusionBuffer::IsVisible(const glm::vec3 &boxMin, const glm::vec3 &boxMax) const
+    {
+        glm::vec2 ndcMin, ndcMax;
+        float nearest;
+        if (!ProjectBox(viewProj, boxMin, boxMax, ndcMin, ndcMax, nearest))
+            return true;
+        if (nearest <= 0.0f)
+            return true;
+
+        int x0 = (int)std::floor((ndcMin.x * 0.5f + 0.5f) * width);
+        int x1 = (int)std::floor((ndcMax.x * 0.5f + 0.5f) * width);
+        int y0 = (int)std::floor((ndcMin.y * 0.5f + 0.5f) * height);
+        int y1 = (int)std::floor((ndcMax.y * 0.5f + 0.5f) * height);
+        if (x1 < 0 || y1 < 0 || x0 >= width || y0 >= height)
+            return true; // outside the buffer: leave the decision to frustum culling
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, width - 1);
+        y1 = std::min(y1, height - 1);
+
+        // Coarsest level at which the rectangle spans at most 2x2 texels
+        size_t level = 0;
+        while (level + 1 < levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+            level++;
+
+        const std::vector<float> &hiz = levels[level];
+        int lw = levelWidth[level];
+        for (int ty = y0 >> level; ty <= (y1 >> level); ty++)
+        {
+            for (int tx = x0 >> level; tx <= (x1 >> level); tx++)
+            {
+                if (nearest <= hiz[ty * lw + tx])
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    void OcclusionBuffer::Cull(const CullingBounds &bounds, std::vector<uint32_t> &visible,
+                               const glm::mat4 &viewProjection, OcclusionStats &stats)
+    {
+        viewProj = viewProjection;
+
+        // 选择屏幕覆盖率最大的物体作为遮挡体
+        std::vector<std::pair<float, uint32_t>> candidates;
+        for (uint32_t idx : visible)
+        {
+            glm::vec3 bmin(bounds.minX[idx], bounds.minY[idx], bounds.minZ[idx]);
+            glm::vec3 bmax(bounds.maxX[idx], bounds.maxY[idx], bounds.maxZ[idx]);
+            float coverage = ProjectedCoverage(bmin, bmax);
+            if (coverage >= minOccluderCoverage)
+                candidates.push_back(std::make_pair(coverage, idx));
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const std::pair<float, uint32_t> &a, const std::pair<float, uint32_t> &b)
+                  { return a.first > b.first; });
+
+        std::vector<SceneObject *> occluders;
+        int triangleBudget = maxOccluderTriangles;
+        for (const auto &candidate : candidates)
+        {
+            if ((int)occluders.size() >= maxOccluders)
+                break;
+            SceneObject *obj = bounds.objects[candidate.second];
+            int triCount = (int)obj->mesh->indices.size() / 3;
+            if (triCount > triangleBudget)
+                continue;
+            triangleBudget -= triCount;
+            occluders.push_back(obj);
+        }
+
+        Render(occluders, viewProjection, stats);
+
+        size_t kept = 0;
+        for (uint32_t idx : visible)
+        {
+            glm::vec3 bmin(bounds.minX[idx], bounds.minY[idx], bounds.minZ[idx]);
+            glm::vec3 bmax(bounds.maxX[idx], bounds.maxY[idx], bounds.maxZ[idx]);
+            if (IsVisible(bmin, bmax))
+                visible[kept++] = idx;
+        }
+
+        stats.tested += (int)visible.size();
+        stats.culled += (int)(visible.size() - kept);
+        visible.resize(kept);
+    }
+}
@@ -0,0 +1,777 @@
+#include "PngWriter.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace PartC
+{
+    PngCompression PngWriter::compression = PngCompression::Default;
+
+    namespace
+    {
+        const size_t WINDOW_SIZE = 32768;
+        const int MIN_MATCH = 3;
+        const int MAX_MATCH = 258;
+        const int HASH_BITS = 15;
+        const size_t BLOCK_TOKENS = 16384;
+
+        const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+                                          31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                          2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        const uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                        6145, 8193, 12289, 16385, 24577};
+        const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                        6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        // Order the code length code lengths are sent in (RFC 1951 3.2.7)
+        const uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        // Match length / distance -> deflate code, built once
+        struct CodeTables
+        {
+            uint8_t lengthCode[MAX_MATCH + 1];
+            uint8_t distCode[WINDOW_SIZE + 1];
+            uint32_t crc[256];
+
+            CodeTables()
+            {
+                for (int code = 0; code < 29; code++)
+                {
+                    for (int i = 0; i < (1 << LENGTH_EXTRA[code]) && LENGTH_BASE[code] + i <= MAX_MATCH; i++)
+                        lengthCode[LENGTH_BASE[code] + i] = (uint8_t)code;
+                }
+                lengthCode[MAX_MATCH] = 28; // 258 has a code of its own, not 227 + 31
+                for (int code = 0; code < 30; code++)
+                {
+                    for (int i = 0; i < (1 << DIST_EXTRA[code]); i++)
+                        distCode[DIST_BASE[code] + i] = (uint8_t)code;
+                }
+                for (uint32_t n = 0; n < 256; n++)
+                {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; k++)
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    crc[n] = c;
+                }
+            }
+        };
+
+        const CodeTables &Tables()
+        {
+            static const CodeTables tables;
+            return tables;
+        }
+
+        uint32_t UpdateCrc(uint32_t crc, const uint8_t *data, size_t size)
+        {
+            const uint32_t *table = Tables().crc;
+            for (size_t i = 0; i < size; i++)
+                crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+            return crc;
+        }
+
+        const uint32_t ADLER_MOD = 65521;
+
+        uint32_t Adler32(const uint8_t *data, size_t size)
+        {
+            uint32_t a = 1, b = 0;
+            while (size > 0)
+            {
+                // 5552: the most bytes before b can overflow 32 bits
+                size_t n = std::min<size_t>(size, 5552);
+                size -= n;
+                while (n-- > 0)
+                {
+                    a += *data++;
+                    b += a;
+                }
+                a %= ADLER_MOD;
+                b %= ADLER_MOD;
+            }
+            return (b << 16) | a;
+        }
+
+        // Adler-32 of A followed by B, from adler(A), adler(B) and |B| (as zlib's adler32_combine)
+        uint32_t CombineAdler32(uint32_t first, uint32_t second, size_t secondSize)
+        {
+            uint32_t rem = (uint32_t)(secondSize % ADLER_MOD);
+            uint32_t sum1 = first & 0xFFFF;
+            uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % ADLER_MOD);
+            sum1 += (second & 0xFFFF) + ADLER_MOD - 1;
+            sum2 += ((first >> 16) & 0xFFFF) + ((second >> 16) & 0xFFFF) + ADLER_MOD - rem;
+            sum1 %= ADLER_MOD;
+            sum2 %= ADLER_MOD;
+            return (sum2 << 16) | sum1;
+        }
+
+        void PutBigEndian(uint8_t *out, uint32_t value)
+        {
+            out[0] = (uint8_t)(value >> 24);
+            out[1] = (uint8_t)(value >> 16);
+            out[2] = (uint8_t)(value >> 8);
+            out[3] = (uint8_t)value;
+        }
+
+        // ---- Scanline filters (RFC 2083 6), 3 bytes per pixel ----
+
+        uint8_t Paeth(int a, int b, int c)
+        {
+            int p = a + b - c;
+            int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+            if (pa <= pb && pa <= pc)
+                return (uint8_t)a;
+            return (uint8_t)(pb <= pc ? b : c);
+        }
+
+        void ApplyFilter(int type, const uint8_t *row, const uint8_t *above, size_t size, uint8_t *out)
+        {
+            const size_t bpp = 3;
+            const size_t head = std::min(bpp, size); // no pixel to the left
+            switch (type)
+            {
+            case 1:
+                std::memcpy(out, row, head);
+                for (size_t i = bpp; i < size; i++)
+                    out[i] = (uint8_t)(row[i] - row[i - bpp]);
+                break;
+            case 2:
+                for (size_t i = 0; i < size; i++)
+                    out[i] = (uint8_t)(row[i] - above[i]);
+                break;
+            case 3:
+                for (size_t i = 0; i < head; i++)
+                    out[i] = (uint8_t)(row[i] - (above[i] >> 1));
+                for (size_t i = bpp; i < size; i++)
+                    out[i] = (uint8_t)(row[i] - ((row[i - bpp] + above[i]) >> 1));
+                break;
+            case 4:
+                for (size_t i = 0; i < head; i++)
+                    out[i] = (uint8_t)(row[i] - above[i]); // Paeth(0, b, 0) = b
+                for (size_t i = bpp; i < size; i++)
+                    out[i] = (uint8_t)(row[i] - Paeth(row[i - bpp], above[i], above[i - bpp]));
+                break;
+            default:
+                std::memcpy(out, row, size);
+                break;
+            }
+        }
+
+        // Writes the filter type byte and the filtered row to out; adaptive picks the
+        // filter with the smallest sum of |signed residual| (the libpng heuristic)
+        void FilterRow(const uint8_t *row, const uint8_t *above, size_t size, bool adaptive,
+                       uint8_t *out, std::vector<uint8_t> &scratch)
+        {
+            if (!adaptive)
+            {
+                out[0] = 2; // Up: cheap, and most rendered rows look like the one above
+                ApplyFilter(2, row, above, size, out + 1);
+                return;
+            }
+            scratch.resize(size);
+            uint64_t bestCost = ~0ull;
+            for (int type = 0; type < 5; type++)
+            {
+                uint8_t *target = type == 0 ? out + 1 : scratch.data();
+                ApplyFilter(type, row, above, size, target);
+                uint64_t cost = 0;
+                for (size_t i = 0; i < size; i++)
+                    cost += (uint64_t)std::abs((int)(int8_t)target[i]);
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    out[0] = (uint8_t)type;
+                    if (type != 0)
+                        std::memcpy(out + 1, scratch.data(), size);
+                }
+            }
+        }
+
+        // ---- Deflate (RFC 1951) ----
+
+        class BitWriter
+        {
+        public:
+            explicit BitWriter(std::vector<uint8_t> &out) : out(out) {}
+
+            // LSB first, as deflate packs everything but Huffman codes (which are reversed up front)
+            void Put(uint32_t value, int count)
+            {
+                bits |= (uint64_t)value << used;
+                used += count;
+                while (used >= 8)
+                {
+                    out.push_back((uint8_t)bits);
+                    bits >>= 8;
+                    used -= 8;
+                }
+            }
+
+            void AlignToByte()
+            {
+                if (used > 0)
+                    out.push_back((uint8_t)bits);
+                bits = 0;
+                used = 0;
+            }
+
+        private:
+            std::vector<uint8_t> &out;
+            uint64_t bits = 0;
+            int used = 0;
+        };
+
+        // Literal (dist 0, value = byte) or match (value = length)
+        struct Token
+        {
+            uint16_t value;
+            uint16_t dist;
+        };
+
+        // Huffman code lengths no longer than maxBits. Frequencies are halved until the
+        // tree fits, which costs a fraction of a percent over package-merge.
+        void BuildLengths(const uint32_t *freq, int count, int maxBits, uint8_t *lengths)
+        {
+            std::vector<uint32_t> weights(freq, freq + count);
+            // A tree needs two leaves; the decoder rejects incomplete single-code trees
+            int used = 0;
+            for (int i = 0; i < count; i++)
+                used += weights[i] > 0;
+            for (int i = 0; i < count && used < 2; i++)
+            {
+                if (weights[i] == 0)
+                {
+                    weights[i] = 1;
+                    used++;
+                }
+            }
+
+            std::vector<int> leaves;
+            std::vector<uint64_t> nodeWeight;
+            std::vector<int> parent;
+            while (true)
+            {
+                leaves.clear();
+                for (int i = 0; i < count; i++)
+                {
+                    if (weights[i] > 0)
+                        leaves.push_back(i);
+                }
+                std::sort(leaves.begin(), leaves.end(), [&](int a, int b)
+                          { return weights[a] != weights[b] ? weights[a] < weights[b] : a < b; });
+
+                // Two-queue construction: leaves sorted, internal nodes created in ascending weight
+                const int n = (int)leaves.size();
+                nodeWeight.assign(2 * n - 1, 0);
+                parent.assign(2 * n - 1, -1);
+                for (int i = 0; i < n; i++)
+                    nodeWeight[i] = weights[leaves[i]];
+                int nextLeaf = 0, nextNode = n;
+                for (int node = n; node < 2 * n - 1; node++)
+                {
+                    int pick[2];
+                    for (int &p : pick)
+                    {
+                        if (nextLeaf < n && (nextNode >= node || nodeWeight[nextLeaf] <= nodeWeight[nextNode]))
+                            p = nextLeaf++;
+                        else
+                            p = nextNode++;
+                    }
+                    nodeWeight[node] = nodeWeight[pick[0]] + nodeWeight[pick[1]];
+                    parent[pick[0]] = parent[pick[1]] = node;
+                }
+
+                // Depths from the root down: parents are created after their children
+                std::vector<int> depth(2 * n - 1, 0);
+                for (int node = 2 * n - 3; node >= 0; node--)
+                    depth[node] = depth[parent[node]] + 1;
+                int deepest = 0;
+                for (int i = 0; i < n; i++)
+                    deepest = std::max(deepest, depth[i]);
+                if (deepest <= maxBits)
+                {
+                    std::memset(lengths, 0, count);
+                    for (int i = 0; i < n; i++)
+                        lengths[leaves[i]] = (uint8_t)depth[i];
+                    return;
+                }
+                for (uint32_t &w : weights)
+                {
+                    if (w > 0)
+                        w = (w + 1) / 2;
+                }
+            }
+        }
+
+        // Canonical codes, bit-reversed so BitWriter can put them LSB first
+        void BuildCodes(const uint8_t *lengths, int count, uint16_t *codes)
+        {
+            int lengthCount[16] = {};
+            for (int i = 0; i < count; i++)
+                lengthCount[lengths[i]]++;
+            lengthCount[0] = 0;
+            int next[16] = {};
+            int code = 0;
+            for (int bits = 1; bits < 16; bits++)
+            {
+                code = (code + lengthCount[bits - 1]) << 1;
+                next[bits] = code;
+            }
+            for (int i = 0; i < count; i++)
+            {
+                int len = lengths[i];
+                if (len == 0)
+                    continue;
+                int value = next[len]++;
+                int reversed = 0;
+                for (int b = 0; b < len; b++)
+                    reversed |= ((value >> b) & 1) << (len - 1 - b);
+                codes[i] = (uint16_t)reversed;
+            }
+        }
+
+        // Common prefix of a and b, at most maxLen bytes; 8 bytes per step
+        int MatchLength(const uint8_t *a, const uint8_t *b, int maxLen)
+        {
+            int len = 0;
+            while (len + 8 <= maxLen)
+            {
+                uint64_t x, y;
+                std::memcpy(&x, a + len, 8);
+                std::memcpy(&y, b + len, 8);
+                if (x != y)
+                {
+                    uint64_t diff = x ^ y;
+                    int same = 0;
+                    while ((diff & 0xFF) == 0) // little-endian: the first byte is the lowest
+                    {
+                        diff >>= 8;
+                        same++;
+                    }
+                    return len + same;
+                }
+                len += 8;
+            }
+            while (len < maxLen && a[len] == b[len])
+                len++;
+            return len;
+        }
+
+        // One dynamic Huffman block (BTYPE 2) holding the tokens and end-of-block
+        void WriteBlock(BitWriter &bits, const std::vector<Token> &tokens, bool final)
+        {
+            const CodeTables &tables = Tables();
+            uint32_t litFreq[286] = {}, distFreq[30] = {};
+            for (const Token &t : tokens)
+            {
+                if (t.dist == 0)
+                {
+                    litFreq[t.value]++;
+                }
+                else
+                {
+                    litFreq[257 + tables.lengthCode[t.value]]++;
+                    distFreq[tables.distCode[t.dist]]++;
+                }
+            }
+            litFreq[256] = 1;
+
+            uint8_t litLen[286], distLen[30];
+            BuildLengths(litFreq, 286, 15, litLen);
+            BuildLengths(distFreq, 30, 15, distLen);
+            int hlit = 286, hdist = 30;
+            while (hlit > 257 && litLen[hlit - 1] == 0)
+                hlit--;
+            while (hdist > 1 && distLen[hdist - 1] == 0)
+                hdist--;
+
+            // Both length tables run-length coded as one sequence: 16 repeats the previous
+            // length 3-6 times, 17 / 18 send 3-10 / 11-138 zeros
+            uint8_t all[286 + 30];
+            std::memcpy(all, litLen, hlit);
+            std::memcpy(all + hlit, distLen, hdist);
+            const int total = hlit + hdist;
+            std::vector<std::pair<uint8_t, uint8_t>> runs; // symbol, extra bits value
+            for (int i = 0; i < total;)
+            {
+                const uint8_t value = all[i];
+                int run = 1;
+                while (i + run < total && all[i + run] == value)
+                    run++;
+                i += run;
+                if (value == 0)
+                {
+                    while (run >= 11)
+                    {
+                        int r = std::min(run, 138);
+                        runs.push_back({18, (uint8_t)(r - 11)});
+                        run -= r;
+                    }
+                    if (run >= 3)
+                    {
+                        runs.push_back({17, (uint8_t)(run - 3)});
+                        run = 0;
+                    }
+                }
+                else
+                {
+                    runs.push_back({value, 0});
+                    run--;
+                    while (run >= 3)
+                    {
+                        int r = std::min(run, 6);
+                        runs.push_back({16, (uint8_t)(r - 3)});
+                        run -= r;
+                    }
+                }
+                for (; run > 0; run--)
+                    runs.push_back({value, 0});
+            }
+
+            uint32_t clFreq[19] = {};
+            for (const auto &r : runs)
+                clFreq[r.first]++;
+            uint8_t clLen[19];
+            BuildLengths(clFreq, 19, 7, clLen);
+            int hclen = 19;
+            while (hclen > 4 && clLen[CODE_LENGTH_ORDER[hclen - 1]] == 0)
+                hclen--;
+
+            uint16_t litCodes[286] = {}, distCodes[30] = {}, clCodes[19] = {};
+            BuildCodes(litLen, 286, litCodes);
+            BuildCodes(distLen, 30, distCodes);
+            BuildCodes(clLen, 19, clCodes);
+
+            bits.Put(final ? 1 : 0, 1);
+            bits.Put(2, 2);
+            bits.Put(hlit - 257, 5);
+            bits.Put(hdist - 1, 5);
+            bits.Put(hclen - 4, 4);
+            for (int i = 0; i < hclen; i++)
+                bits.Put(clLen[CODE_LENGTH_ORDER[i]], 3);
+            for (const auto &r : runs)
+            {
+                bits.Put(clCodes[r.first], clLen[r.first]);
+                if (r.first == 16)
+                    bits.Put(r.second, 2);
+                else if (r.first == 17)
+                    bits.Put(r.second, 3);
+                else if (r.first == 18)
+                    bits.Put(r.second, 7);
+            }
+
+            for (const Token &t : tokens)
+            {
+                if (t.dist == 0)
+                {
+                    bits.Put(litCodes[t.value], litLen[t.value]);
+                    continue;
+                }
+                int lc = tables.lengthCode[t.value];
+                bits.Put(litCodes[257 + lc], litLen[257 + lc]);
+                if (LENGTH_EXTRA[lc] > 0)
+                    bits.Put(t.value - LENGTH_BASE[lc], LENGTH_EXTRA[lc]);
+                int dc = tables.distCode[t.dist];
+                bits.Put(distCodes[dc], distLen[dc]);
+                if (DIST_EXTRA[dc] > 0)
+                    bits.Put(t.dist - DIST_BASE[dc], DIST_EXTRA[dc]);
+            }
+            bits.Put(litCodes[256], litLen[256]);
+        }
+
+        // Compresses data[dictSize, dictSize + size) as a run of deflate blocks; matches may
+        // reach back into data[0, dictSize), which the decoder has already produced.
+        // Not final: ends with a sync flush, so the next piece can be appended byte-aligned.
+        void Deflate(const uint8_t *data, size_t dictSize, size_t size, bool final, PngCompression level,
+                     std::vector<uint8_t> &out)
+        {
+            const size_t total = dictSize + size;
+            const int maxChain = level == PngCompression::Fast ? 4 : 64;
+            const int niceLength = level == PngCompression::Fast ? 32 : MAX_MATCH;
+            const int maxInsert = level == PngCompression::Fast ? 4 : MAX_MATCH;
+
+            std::vector<int32_t> head((size_t)1 << HASH_BITS, -1);
+            std::vector<int32_t> prev(total);
+            auto hash = [&](size_t p)
+            {
+                uint32_t v = (uint32_t)data[p] | ((uint32_t)data[p + 1] << 8) | ((uint32_t)data[p + 2] << 16);
+                return (v * 2654435761u) >> (32 - HASH_BITS);
+            };
+            auto insert = [&](size_t p)
+            {
+                if (p + MIN_MATCH > total)
+                    return;
+                uint32_t h = hash(p);
+                prev[p] = head[h];
+                head[h] = (int32_t)p;
+            };
+            for (size_t p = 0; p < dictSize; p++)
+                insert(p);
+
+            BitWriter bits(out);
+            std::vector<Token> tokens;
+            tokens.reserve(BLOCK_TOKENS);
+            size_t p = dictSize;
+            while (p < total)
+            {
+                int bestLen = 0, bestDist = 0;
+                if (p + MIN_MATCH <= total)
+                {
+                    const int maxLen = (int)std::min<size_t>(MAX_MATCH, total - p);
+                    const int nice = std::min(niceLength, maxLen);
+                    int32_t candidate = head[hash(p)];
+                    for (int chain = maxChain; candidate >= 0 && chain > 0; chain--)
+                    {
+                        const size_t dist = p - (size_t)candidate;
+                        if (dist > WINDOW_SIZE)
+                            break;
+                        const uint8_t *a = data + candidate;
+                        const uint8_t *b = data + p;
+                        if (a[bestLen] == b[bestLen] && a[0] == b[0])
+                        {
+                            int len = MatchLength(a, b, maxLen);
+                            if (len > bestLen)
+                            {
+                                bestLen = len;
+                                bestDist = (int)dist;
+                                if (len >= nice)
+                                    break;
+                            }
+                        }
+                        candidate = prev[candidate];
+                    }
+                }
+
+                if (bestLen >= MIN_MATCH)
+                {
+                    tokens.push_back({(uint16_t)bestLen, (uint16_t)bestDist});
+                    // Fast: the inside of long matches is not indexed (as zlib's fast levels)
+                    const int indexed = bestLen <= maxInsert ? bestLen : 1;
+                    for (int i = 0; i < indexed; i++)
+                        insert(p + i);
+                    p += bestLen;
+                }
+                else
+                {
+                    tokens.push_back({data[p], 0});
+                    insert(p);
+                    p++;
+                }
+                if (tokens.size() >= BLOCK_TOKENS)
+                {
+                    WriteBlock(bits, tokens, false);
+                    tokens.clear();
+                }
+            }
+            WriteBlock(bits, tokens, final);
+            if (!final)
+            {
+                // Sync flush: an empty stored block, whose LEN / NLEN start on a byte boundary
+                bits.Put(0, 3);
+                bits.AlignToByte();
+                const uint8_t empty[4] = {0x00, 0x00, 0xFF, 0xFF};
+                out.insert(out.end(), empty, empty + 4);
+            }
+            bits.AlignToByte();
+        }
+
+        // length, type, data, CRC of type + data
+        void AppendChunk(std::vector<uint8_t> &out, const char *type, const uint8_t *data, size_t size)
+        {
+            const size_t start = out.size();
+            out.resize(start + 12 + size);
+            uint8_t *chunk = out.data() + start;
+            PutBigEndian(chunk, (uint32_t)size);
+            std::memcpy(chunk + 4, type, 4);
+            if (size > 0)
+                std::memcpy(chunk + 8, data, size);
+            PutBigEndian(chunk + 8 + size, UpdateCrc(0xFFFFFFFFu, chunk + 4, size + 4) ^ 0xFFFFFFFFu);
+        }
+    }
+
+    void PngWriter::WriteChunk(const char *type, const uint8_t *data, size_t size)
+    {
+        std::vector<uint8_t> chunk;
+        AppendChunk(chunk, type, data, size);
+        file.write(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+        written += chunk.size();
+    }
+
+    bool PngWriter::Open(const std::string &path, int w, int h, PngCompression compressionLevel)
+    {
+        if (w <= 0 || h <= 0)
+            return false;
+        file.open(path, std::ios::binary);
+        if (!file)
+            return false;
+        width = w;
+        height = h;
+        level = compressionLevel;
+        rows = 0;
+        pending.clear();
+        pendingRows = 0;
+        previousRow.assign((size_t)width * 3, 0); // the filters see zeros above the first row
+        window.clear();
+        adler = 1;
+        started = false;
+        written = 0;
+
+        const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        file.write(reinterpret_cast<const char *>(signature), 8);
+        written += 8;
+
+        uint8_t header[13];
+        PutBigEndian(header, (uint32_t)width);
+        PutBigEndian(header + 4, (uint32_t)height);
+        header[8] = 8;  // bit depth
+        header[9] = 2;  // truecolour
+        header[10] = 0; // deflate
+        header[11] = 0; // adaptive filtering
+        header[12] = 0; // not interlaced
+        WriteChunk("IHDR", header, sizeof(header));
+        return file.good();
+    }
+
+    bool PngWriter::AppendRows(const uint8_t *firstRow, int count, int channels, ptrdiff_t stride)
+    {
+        if (!file.is_open() || (channels != 3 && channels != 4) || rows + count > height)
+            return false;
+
+        const size_t rowSize = (size_t)width * 3;
+        const size_t flushBytes = CHUNK_BYTES * (ThreadPool::Instance().GetWorkerCount() + 1);
+        for (int y = 0; y < count; y++)
+        {
+            const uint8_t *src = firstRow + stride * y;
+            const size_t offset = pending.size();
+            pending.resize(offset + rowSize);
+            uint8_t *dst = pending.data() + offset;
+            if (channels == 3)
+            {
+                std::memcpy(dst, src, rowSize);
+            }
+            else
+            {
+                for (int x = 0; x < width; x++)
+                {
+                    dst[x * 3 + 0] = src[x * 4 + 0];
+                    dst[x * 3 + 1] = src[x * 4 + 1];
+                    dst[x * 3 + 2] = src[x * 4 + 2];
+                }
+            }
+            pendingRows++;
+            rows++;
+            if (pending.size() >= flushBytes && !Flush(false))
+                return false;
+        }
+        return file.good();
+    }
+
+    bool PngWriter::Flush(bool final)
+    {
+        const size_t rowSize = (size_t)width * 3;
+        const size_t filteredRow = rowSize + 1;
+        const size_t dictSize = window.size();
+
+        // [32 KB already compressed][filtered pending rows]: each piece's dictionary is
+        // whatever lies before it in this buffer
+        std::vector<uint8_t> stream(dictSize + (size_t)pendingRows * filteredRow);
+        if (dictSize > 0)
+            std::memcpy(stream.data(), window.data(), dictSize);
+        const bool adaptive = level != PngCompression::Fast;
+        ThreadPool::Instance().ParallelFor((size_t)pendingRows, 16, [&](size_t begin, size_t end)
+        {
+            std::vector<uint8_t> scratch;
+            for (size_t r = begin; r < end; r++)
+            {
+                const uint8_t *row = pending.data() + r * rowSize;
+                const uint8_t *above = r == 0 ? previousRow.data() : row - rowSize;
+                FilterRow(row, above, rowSize, adaptive, stream.data() + dictSize + r * filteredRow, scratch);
+            }
+        });
+        if (pendingRows > 0)
+            std::memcpy(previousRow.data(), pending.data() + (size_t)(pendingRows - 1) * rowSize, rowSize);
+
+        struct Piece
+        {
+            std::vector<uint8_t> chunk; // complete IDAT chunk
+            uint32_t adler = 1;
+            size_t size = 0;            // uncompressed bytes
+        };
+        const size_t dataSize = stream.size() - dictSize;
+        const size_t pieceBytes = CHUNK_BYTES;
+        const size_t pieceCount = (dataSize + pieceBytes - 1) / pieceBytes;
+        std::vector<Piece> pieces(pieceCount);
+        const bool header = !started;
+        const PngCompression compressionLevel = level;
+        ThreadPool::Instance().ParallelFor(pieceCount, 1, [&](size_t begin, size_t end)
+        {
+            std::vector<uint8_t> compressed;
+            for (size_t i = begin; i < end; i++)
+            {
+                const size_t start = dictSize + i * pieceBytes;
+                const size_t size = std::min(pieceBytes, stream.size() - start);
+                const size_t dict = std::min(WINDOW_SIZE, start);
+                compressed.clear();
+                if (i == 0 && header)
+                {
+                    // zlib header: deflate, 32 KB window, level hint; checks to a multiple of 31
+                    compressed.push_back(0x78);
+                    compressed.push_back(compressionLevel == PngCompression::Fast ? 0x01 : 0x9C);
+                }
+                Deflate(stream.data() + start - dict, dict, size, final && i + 1 == pieceCount, compressionLevel,
+                        compressed);
+                AppendChunk(pieces[i].chunk, "IDAT", compressed.data(), compressed.size());
+                pieces[i].adler = Adler32(stream.data() + start, size);
+                pieces[i].size = size;
+            }
+        });
+
+        for (const Piece &piece : pieces)
+        {
+            file.write(reinterpret_cast<const char *>(piece.chunk.data()), piece.chunk.size());
+            written += piece.chunk.size();
+            adler = CombineAdler32(adler, piece.adler, piece.size);
+        }
+        if (pieceCount > 0)
+            started = true;
+
+        const size_t keep = std::min(WINDOW_SIZE, stream.size());
+        window.assign(stream.end() - keep, stream.end());
+        pending.clear();
+        pendingRows = 0;
+
+        if (final)
+        {
+            std::vector<uint8_t> tail;
+            if (!started)
+            {
+                tail.push_back(0x78);
+                tail.push_back(level == PngCompression::Fast ? 0x01 : 0x9C);
+            }
+            if (pieceCount == 0)
+            {
+                // Everything went out in earlier flushes: close the stream with an empty final block
+                tail.push_back(0x03);
+                tail.push_back(0x00);
+            }
+            uint8_t trailer[4];
+            PutBigEndian(trailer, adler);
+            tail.insert(tail.end(), trailer, trailer + 4);
+            WriteChunk("IDAT", tail.data(), tail.size());
+        }
+        return file.good();
+    }
+
+    bool PngWriter::Finish()
+    {
+        if (!file.is_open())
+            return false;
+        bool ok = rows == height && Flush(true);
+        if (ok)
+            WriteChunk("IEND", nullptr, 0);
+        ok = ok && file.good();
+        file.close();
+        return ok;
+    }
+}
@@ -0,0 +1,427 @@
+#include "RayQuery.h"
+#include "SceneContext.h"
+#include "Mesh.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RAY_QUERY_USE_SSE 1
+#endif
+
+namespace
+{
+    const int PACKET_SIZE = 4;
+    const uint32_t MAX_LEAF_SIZE = 4;
+    const int MAX_STACK_DEPTH = 64;
+    // Packets per ThreadPool job
+    const size_t PACKETS_PER_JOB = 64;
+
+    // SoA 射线包，4 条射线一组做包围盒测试
+    struct RayPacket
+    {
+        alignas(16) float ox[PACKET_SIZE], oy[PACKET_SIZE], oz[PACKET_SIZE];
+        alignas(16) float dx[PACKET_SIZE], dy[PACKET_SIZE], dz[PACKET_SIZE];
+        alignas(16) float ix[PACKET_SIZE], iy[PACKET_SIZE], iz[PACKET_SIZE];
+        alignas(16) float tMin[PACKET_SIZE];
+        alignas(16) float tMax[PACKET_SIZE];
+    };
+
+    // Avoids inf * 0 = NaN in the slab test for axis-aligned rays
+    float SafeInverse(float d)
+    {
+        const float eps = 1e-12f;
+        if (std::fabs(d) < eps)
+            d = d < 0.0f ? -eps : eps;
+        return 1.0f / d;
+    }
+
+    void SetLane(RayPacket &p, int k, const glm::vec3 &o, const glm::vec3 &d, float tMin, float tMax)
+    {
+        p.ox[k] = o.x;
+        p.oy[k] = o.y;
+        p.oz[k] = o.z;
+        p.dx[k] = d.x;
+        p.dy[k] = d.y;
+        p.dz[k] = d.z;
+        p.ix[k] = SafeInverse(d.x);
+        p.iy[k] = SafeInverse(d.y);
+        p.iz[k] = SafeInverse(d.z);
+        p.tMin[k] = tMin;
+        p.tMax[k] = tMax;
+    }
+
+    // Slab test of all 4 lanes against one box.
+    // Returns a bit mask of the lanes whose [tMin, tMax] segment overlaps the box.
+    int IntersectPacketAABB(const RayPacket &p, const glm::vec3 &bmin, const glm::vec3 &bmax)
+    {
+#ifdef RAY_QUERY_USE_SSE
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bmin.x), _mm_load_ps(p.ox)), _mm_load_ps(p.ix));
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bmax.x), _mm_load_ps(p.ox)), _mm_load_ps(p.ix));
+        __m128 tNear = _mm_min_ps(t0, t1);
+        __m128 tFar = _mm_max_ps(t0, t1);
+
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bmin.y), _mm_load_ps(p.oy)), _mm_load_ps(p.iy));
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bmax.y), _mm_load_ps(p.oy)), _mm_load_ps(p.iy));
+        tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+        tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bmin.z), _mm_load_ps(p.oz)), _mm_load_ps(p.iz));
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bmax.z), _mm_load_ps(p.oz)), _mm_load_ps(p.iz));
+        tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+        tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+
+        tNear = _mm_max_ps(tNear, _mm_load_ps(p.tMin));
+        tFar = _mm_min_ps(tFar, _mm_load_ps(p.tMax));
+        return _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+#else
+        int mask = 0;
+        for (int k = 0; k < PACKET_SIZE; k++)
+        {
+            float t0x = (bmin.x - p.ox[k]) * p.ix[k], t1x = (bmax.x - p.ox[k]) * p.ix[k];
+            float t0y = (bmin.y - p.oy[k]) * p.iy[k], t1y = (bmax.y - p.oy[k]) * p.iy[k];
+            float t0z = (bmin.z - p.oz[k]) * p.iz[k], t1z = (bmax.z - p.oz[k]) * p.iz[k];
+            float tNear = std::max(std::max(std::min(t0x, t1x), std::min(t0y, t1y)), std::max(std::min(t0z, t1z), p.tMin[k]));
+            float tFar = std::min(std::min(std::max(t0x, t1x), std::max(t0y, t1y)), std::min(std::max(t0z, t1z), p.tMax[k]));
+            if (tNear <= tFar)
+                mask |= 1 << k;
+        }
+        return mask;
+#endif
+    }
+
+    // Möller–Trumbore
+    bool IntersectTriangle(const glm::vec3 &o, const glm::vec3 &d,
+                           const glm::vec3 &v0, const glm::vec3 &v1, const glm::vec3 &v2, float &t)
+    {
+        glm::vec3 e1 = v1 - v0;
+        glm::vec3 e2 = v2 - v0;
+        glm::vec3 p = glm::cross(d, e2);
+        float det = glm::dot(e1, p);
+        if (std::fabs(det) < 1e-12f)
+            return false;
+        float invDet = 1.0f / det;
+        glm::vec3 s = o - v0;
+        float u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f)
+            return false;
+        glm::vec3 q = glm::cross(s, e1);
+        float v = glm::dot(d, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+            return false;
+        t = glm::dot(e2, q) * invDet;
+        return true;
+    }
+
+    // Median split on the largest centroid axis. Shared by the scene and mesh levels.
+    void BuildBVH(const std::vector<glm::vec3> &primMin, const std::vector<glm::vec3> &primMax,
+                  std::vector<BVHNode> &nodes, std::vector<uint32_t> &order)
+    {
+        uint32_t primCount = static_cast<uint32_t>(primMin.size());
+        nodes.clear();
+        order.resize(primCount);
+        if (primCount == 0)
+            return;
+
+        std::vector<glm::vec3> centroids(primCount);
+        for (uint32_t i = 0; i < primCount; i++)
+        {
+            order[i] = i;
+            centroids[i] = (primMin[i] + primMax[i]) * 0.5f;
+        }
+
+        struct BuildTask
+        {
+            uint32_t node, first, count;
+        };
+        std::vector<BuildTask> tasks;
+        nodes.reserve(primCount * 2);
+        nodes.push_back(BVHNode());
+        tasks.push_back({0, 0, primCount});
+
+        while (!tasks.empty())
+        {
+            BuildTask task = tasks.back();
+            tasks.pop_back();
+
+            glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+            glm::vec3 cmin(FLT_MAX), cmax(-FLT_MAX);
+            for (uint32_t i = task.first; i < task.first + task.count; i++)
+            {
+                uint32_t prim = order[i];
+                bmin = glm::min(bmin, primMin[prim]);
+                bmax = glm::max(bmax, primMax[prim]);
+                cmin = glm::min(cmin, centroids[prim]);
+                cmax = glm::max(cmax, centroids[prim]);
+            }
+            nodes[task.node].boundsMin = bmin;
+            nodes[task.node].boundsMax = bmax;
+
+            glm::vec3 extent = cmax - cmin;
+            int axis = 0;
+            if (extent.y > extent.x)
+                axis = 1;
+            if (extent.z > extent[axis])
+                axis = 2;
+
+            if (task.count <= MAX_LEAF_SIZE || extent[axis] <= 0.0f)
+            {
+                nodes[task.node].leftFirst = task.first;
+                nodes[task.node].count = task.count;
+                continue;
+            }
+
+            uint32_t mid = task.first + task.count / 2;
+            std::nth_element(order.begin() + task.first, order.begin() + mid, order.begin() + task.first + task.count,
+                             [&](uint32_t a, uint32_t b)
+                             { return centroids[a][axis] < centroids[b][axis]; });
+
+            uint32_t left = static_cast<uint32_t>(nodes.size());
+            nodes[task.node].leftFirst = left;
+            nodes[task.node].count = 0;
+            nodes.push_back(BVHNode());
+            nodes.push_back(BVHNode());
+            tasks.push_back({left, task.first, mid - task.first});
+            tasks.push_back({left + 1, mid, task.first + task.count - mid});
+        }
+    }
+
+    // Pushes the two children of an inner node, far child first, using the
+    // direction of the packet's first ray along the axis separating them.
+    void PushChildren(const std::vector<BVHNode> &nodes, const BVHNode &node, const RayPacket &p,
+                      uint32_t *stack, int &sp)
+    {
+        uint32_t left = node.leftFirst;
+        uint32_t right = left + 1;
+        glm::vec3 delta = (nodes[right].boundsMin + nodes[right].boundsMax) - (nodes[left].boundsMin + nodes[left].boundsMax);
+        glm::vec3 absDelta = glm::abs(delta);
+        float dirAlongAxis;
+        float sepAlongAxis;
+        if (absDelta.x >= absDelta.y && absDelta.x >= absDelta.z)
+        {
+            dirAlongAxis = p.dx[0];
+            sepAlongAxis = delta.x;
+        }
+        else if (absDelta.y >= absDelta.z)
+        {
+            dirAlongAxis = p.dy[0];
+            sepAlongAxis = delta.y;
+        }
+        else
+        {
+            dirAlongAxis = p.dz[0];
+            sepAlongAxis = delta.z;
+        }
+
+        bool leftIsNear = (dirAlongAxis * sepAlongAxis) >= 0.0f;
+        if (sp + 2 > MAX_STACK_DEPTH)
+            return;
+        stack[sp++] = leftIsNear ? right : left;
+        stack[sp++] = leftIsNear ? left : right;
+    }
+}
+
+const MeshBVH &SceneBVH::GetMeshBVH(Mesh *mesh)
+{
+    if (!mesh->bvh)
+    {
+        auto bvh = std::make_shared<MeshBVH>();
+        size_t triCount = mesh->indices.size() / 3;
+        std::vector<glm::vec3> triMin(triCount), triMax(triCount);
+        for (size_t i = 0; i < triCount; i++)
+        {
+            const glm::vec3 &v0 = mesh->vertices[mesh->indices[i * 3]].Position;
+            const glm::vec3 &v1 = mesh->vertices[mesh->indices[i * 3 + 1]].Position;
+            const glm::vec3 &v2 = mesh->vertices[mesh->indices[i * 3 + 2]].Position;
+            triMin[i] = glm::min(v0, glm::min(v1, v2));
+            triMax[i] = glm::max(v0, glm::max(v1, v2));
+        }
+        BuildBVH(triMin, triMax, bvh->nodes, bvh->triangles);
+        mesh->bvh = bvh;
+    }
+    return *mesh->bvh;
+}
+
+void SceneBVH::Build(const SceneContext &scene)
+{
+    instances.clear();
+    std::vector<glm::vec3> instMin, instMax;
+
+    for (size_t i = 0; i < scene.objects.size(); i++)
+    {
+        SceneObject *obj = scene.objects[i];
+        if (!obj || !obj->mesh || obj->mesh->indices.size() < 3)
+            continue;
+
+        glm::mat4 model = obj->GetModelMatrix();
+        glm::mat3 linear = glm::mat3(model);
+        // 缩放为 0 的物体无法求逆，跳过
+        if (std::fabs(glm::determinant(linear)) < 1e-12f)
+            continue;
+
+        Instance inst;
+        inst.mesh = obj->mesh.get();
+        inst.bvh = &GetMeshBVH(obj->mesh.get());
+        inst.objectIndex = static_cast<int>(i);
+        inst.invModel = glm::inverse(model);
+        inst.normalMatrix = glm::transpose(glm::inverse(linear));
+        instances.push_back(inst);
+
+        // Transform the 8 corners of the local bounds into a world AABB
+        const glm::vec3 &lmin = obj->mesh->boundsMin;
+        const glm::vec3 &lmax = obj->mesh->boundsMax;
+        glm::vec3 wmin(FLT_MAX), wmax(-FLT_MAX);
+        for (int c = 0; c < 8; c++)
+        {
+            glm::vec3 corner((c & 1) ? lmax.x : lmin.x, (c & 2) ? lmax.y : lmin.y, (c & 4) ? lmax.z : lmin.z);
+            glm::vec3 w = glm::vec3(model * glm::vec4(corner, 1.0f));
+            wmin = glm::min(wmin, w);
+            wmax = glm::max(wmax, w);
+        }
+        instMin.push_back(wmin);
+        instMax.push_back(wmax);
+    }
+
+    BuildBVH(instMin, instMax, nodes, order);
+}
+
+size_t SceneBVH::Trace(const Ray *rays, RayHit *hits, size_t count) const
+{
+    size_t packetCount = (count + PACKET_SIZE - 1) / PACKET_SIZE;
+    ThreadPool::Instance().ParallelFor(packetCount, PACKETS_PER_JOB, [&](size_t begin, size_t end)
+                                       {
+        for (size_t p = begin; p < end; p++)
+        {
+            size_t first = p * PACKET_SIZE;
+            int lanes = static_cast<int>(std::min<size_t>(PACKET_SIZE, count - first));
+            TracePacket(rays + first, hits + first, lanes);
+        } });
+
+    size_t hitCount = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (hits[i].IsHit())
+            hitCount++;
+    }
+    return hitCount;
+}
+
+void SceneBVH::TracePacket(const Ray *rays, RayHit *hits, int laneCount) const
+{
+    RayPacket world;
+    int bestInstance[PACKET_SIZE];
+    int bestTriangle[PACKET_SIZE];
+    for (int k = 0; k < PACKET_SIZE; k++)
+    {
+        bestInstance[k] = -1;
+        bestTriangle[k] = -1;
+        if (k < laneCount)
+            SetLane(world, k, rays[k].origin, rays[k].direction, rays[k].tMin, rays[k].tMax);
+        else
+            SetLane(world, k, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 1.0f, 0.0f); // empty lane, never hits
+    }
+
+    uint32_t stack[MAX_STACK_DEPTH];
+    uint32_t meshStack[MAX_STACK_DEPTH];
+    int sp = 0;
+    if (!nodes.empty())
+        stack[sp++] = 0;
+
+    while (sp > 0)
+    {
+        const BVHNode &node = nodes[stack[--sp]];
+        if (!IntersectPacketAABB(world, node.boundsMin, node.boundsMax))
+            continue;
+
+        if (node.count == 0)
+        {
+            PushChildren(nodes, node, world, stack, sp);
+            continue;
+        }
+
+        for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+        {
+            uint32_t instIndex = order[i];
+            const Instance &inst = instances[instIndex];
+
+            // 将射线变换到物体局部空间；仿射变换下 t 参数保持不变
+            RayPacket local;
+            for (int k = 0; k < PACKET_SIZE; k++)
+            {
+                glm::vec3 o = glm::vec3(inst.invModel * glm::vec4(world.ox[k], world.oy[k], world.oz[k], 1.0f));
+                glm::vec3 d = glm::vec3(inst.invModel * glm::vec4(world.dx[k], world.dy[k], world.dz[k], 0.0f));
+                SetLane(local, k, o, d, world.tMin[k], world.tMax[k]);
+            }
+
+            const std::vector<BVHNode> &meshNodes = inst.bvh->nodes;
+            const std::vector<Vertex> &verts = inst.mesh->vertices;
+            const std::vector<unsigned int> &indices = inst.mesh->indices;
+
+            int msp = 0;
+            if (!meshNodes.empty())
+                meshStack[msp++] = 0;
+            while (msp > 0)
+            {
+                const BVHNode &meshNode = meshNodes[meshStack[--msp]];
+                int mask = IntersectPacketAABB(local, meshNode.boundsMin, meshNode.boundsMax);
+                if (!mask)
+                    continue;
+
+                if (meshNode.count == 0)
+                {
+                    PushChildren(meshNodes, meshNode, local, meshStack, msp);
+                    continue;
+                }
+
+                for (uint32_t j = meshNode.leftFirst; j < meshNode.leftFirst + meshNode.count; j++)
+                {
+                    uint32_t tri = inst.bvh->triangles[j];
+                    const glm::vec3 &v0 = verts[indices[tri * 3]].Position;
+                    const glm::vec3 &v1 = verts[indices[tri * 3 + 1]].Position;
+                    const glm::vec3 &v2 = verts[indices[tri * 3 + 2]].Position;
+                    for (int k = 0; k < PACKET_SIZE; k++)
+                    {
+                        if (!(mask & (1 << k)))
+                            continue;
+                        float t;
+                        glm::vec3 o(local.ox[k], local.oy[k], local.oz[k]);
+                        glm::vec3 d(local.dx[k], local.dy[k], local.dz[k]);
+                        if (IntersectTriangle(o, d, v0, v1, v2, t) && t >= local.tMin[k] && t < local.tMax[k])
+                        {
+                            local.tMax[k] = t;
+                            world.tMax[k] = t;
+                            bestInstance[k] = static_cast<int>(instIndex);
+                            bestTriangle[k] = static_cast<int>(tri);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < laneCount; k++)
+    {
+        RayHit hit;
+        if (bestInstance[k] >= 0)
+        {
+            const Instance &inst = instances[bestInstance[k]];
+            const std::vector<Vertex> &verts = inst.mesh->vertices;
+            const std::vector<unsigned int> &indices = inst.mesh->indices;
+            int tri = bestTriangle[k];
+            glm::vec3 v0 = verts[indices[tri * 3]].Position;
+            glm::vec3 v1 = verts[indices[tri * 3 + 1]].Position;
+            glm::vec3 v2 = verts[indices[tri * 3 + 2]].Position;
+
+            hit.t = world.tMax[k];
+            hit.objectIndex = inst.objectIndex;
+            hit.triangleIndex = tri;
+            hit.position = rays[k].origin + rays[k].direction * hit.t;
+            hit.normal = glm::normalize(inst.normalMatrix * glm::cross(v1 - v0, v2 - v0));
+            // 法线朝向射线来源一侧
+            if (glm::dot(hit.normal, rays[k].direction) > 0.0f)
+                hit.normal = -hit.normal;
+        }
+        hits[k] = hit;
+    }
+}
@@ -0,0 +1,216 @@
+#include "RenderQueue.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include <algorithm>
+#include <chrono>
+
+namespace PartC
+{
+    namespace
+    {
+        const int SHADER_BITS = 8;
+        const int MESH_BITS = 16;
+        const int TEXTURE_BITS = 16;
+        const int DEPTH_BITS = 20;
+
+        const int MESH_SHIFT = 0;
+        const int DEPTH_SHIFT = MESH_SHIFT + MESH_BITS;
+        const int TEXTURE_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+        const int SHADER_SHIFT = TEXTURE_SHIFT + TEXTURE_BITS;
+        const int PASS_SHIFT = SHADER_SHIFT + SHADER_BITS;
+    }
+
+    uint32_t RenderQueue::CompactId(std::unordered_map<const void *, uint32_t> &ids, const void *ptr, uint32_t maxId)
+    {
+        auto it = ids.find(ptr);
+        if (it != ids.end())
+            return it->second;
+        // Past the key width, ids collide: sorting gets worse but stays correct
+        uint32_t id = std::min((uint32_t)ids.size(), maxId);
+        ids[ptr] = id;
+        return id;
+    }
+
+    void RenderQueue::Clear()
+    {
+        commands.clear();
+        order.clear();
+        shaderIds.clear();
+        meshIds.clear();
+        textureIds.clear();
+    }
+
+    void RenderQueue::Submit(const DrawCommand &command, float depth01)
+    {
+        if (!command.mesh || !command.shader)
+            return;
+
+        DrawCommand cmd = command;
+        uint64_t shaderId = CompactId(shaderIds, cmd.shader, (1u << SHADER_BITS) - 1);
+        uint64_t meshId = CompactId(meshIds, cmd.mesh, (1u << MESH_BITS) - 1);
+
+        // 0 is reserved for untextured meshes, so they also share one useTexture state;
+        // programs without material samplers (the depth shader) ignore textures altogether
+        uint64_t textureId = 0;
+        if (!cmd.mesh->textures.empty() && cmd.shader->standard.useTexture.IsValid())
+        {
+            // Atlas textures all share binding 0, so they sort (and skip binds) together
+            unsigned int glId = cmd.mesh->textures[0].BindingId();
+            auto it = textureIds.find(glId);
+            if (it == textureIds.end())
+            {
+                uint32_t id = std::min((uint32_t)textureIds.size() + 1, (1u << TEXTURE_BITS) - 1);
+                it = textureIds.insert(std::make_pair(glId, id)).first;
+            }
+            textureId = it->second;
+        }
+
+        uint64_t depth = (uint64_t)(std::min(std::max(depth01, 0.0f), 1.0f) * (float)((1u << DEPTH_BITS) - 1));
+
+        cmd.key = ((uint64_t)(cmd.pass & 0xF) << PASS_SHIFT) |
+                  (shaderId << SHADER_SHIFT) |
+                  (textureId << TEXTURE_SHIFT) |
+                  (depth << DEPTH_SHIFT) |
+                  (meshId << MESH_SHIFT);
+
+        order.push_back((uint32_t)commands.size());
+        commands.push_back(cmd);
+    }
+
+    void RenderQueue::RadixSort(std::vector<uint64_t> &keys, std::vector<uint32_t> &values,
+                                std::vector<uint64_t> &keyScratch, std::vector<uint32_t> &valueScratch)
+    {
+        const size_t count = keys.size();
+        keyScratch.resize(count);
+        valueScratch.resize(count);
+
+        // LSD radix sort, 8 bits per pass; stable, so equal keys keep submission order
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            size_t histogram[256] = {0};
+            for (size_t i = 0; i < count; i++)
+                histogram[(keys[i] >> shift) & 0xFF]++;
+
+            // Every key has the same byte here: this pass would not move anything
+            if (histogram[(keys[0] >> shift) & 0xFF] == count)
+                continue;
+
+            size_t offset = 0;
+            for (int b = 0; b < 256; b++)
+            {
+                size_t n = histogram[b];
+                histogram[b] = offset;
+                offset += n;
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                size_t dst = histogram[(keys[i] >> shift) & 0xFF]++;
+                keyScratch[dst] = keys[i];
+                valueScratch[dst] = values[i];
+            }
+            keys.swap(keyScratch);
+            values.swap(valueScratch);
+        }
+    }
+
+    void RenderQueue::Sort(bool enabled, RenderQueueStats &stats)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        stats.commands += (int)commands.size();
+        StateChangeCounts before = CountStateChanges(false);
+
+        for (size_t i = 0; i < commands.size(); i++)
+            order[i] = (uint32_t)i;
+
+        if (enabled && commands.size() > 1)
+        {
+            sortKeys.resize(commands.size());
+            for (size_t i = 0; i < commands.size(); i++)
+                sortKeys[i] = commands[i].key;
+            RadixSort(sortKeys, order, keyScratch, orderScratch);
+        }
+
+        StateChangeCounts after = CountStateChanges(true);
+        stats.unsorted.shaders += before.shaders;
+        stats.unsorted.meshes += before.meshes;
+        stats.unsorted.textures += before.textures;
+        stats.unsorted.textureToggles += before.textureToggles;
+        stats.unsorted.polygonModes += before.polygonModes;
+        stats.sorted.shaders += after.shaders;
+        stats.sorted.meshes += after.meshes;
+        stats.sorted.textures += after.textures;
+        stats.sorted.textureToggles += after.textureToggles;
+        stats.sorted.polygonModes += after.polygonModes;
+
+        auto finish = std::chrono::high_resolution_clock::now();
+        stats.sortMs += std::chrono::duration<float, std::milli>(finish - start).count();
+    }
+
+    bool RenderQueue::SameTextureSet(const Mesh *a, const Mesh *b)
+    {
+        if (a == b)
+            return true;
+        if (!a || !b || a->textures.size() != b->textures.size())
+            return false;
+        for (size_t i = 0; i < a->textures.size(); i++)
+        {
+            if (a->textures[i].BindingId() != b->textures[i].BindingId() || a->textures[i].type != b->textures[i].type)
+                return false;
+        }
+        return true;
+    }
+
+    StateChangeCounts RenderQueue::CountStateChanges(bool sortedOrder) const
+    {
+        // Mirrors the redundant-state checks in Renderer::ExecuteQueue
+        StateChangeCounts counts;
+        const Shader *shader = nullptr;
+        const Mesh *mesh = nullptr;
+        const Mesh *textureOwner = nullptr;
+        int useTexture = -1;
+        bool wireframe = false;
+
+        for (size_t i = 0; i < commands.size(); i++)
+        {
+            const DrawCommand &cmd = sortedOrder ? commands[order[i]] : commands[i];
+
+            if (cmd.shader != shader)
+            {
+                counts.shaders++;
+                shader = cmd.shader;
+                // useTexture and the sampler units are per-program uniforms
+                useTexture = -1;
+                textureOwner = nullptr;
+            }
+            if (cmd.mesh != mesh)
+            {
+                counts.meshes++;
+                mesh = cmd.mesh;
+            }
+
+            // Programs without material samplers (e.g. the depth shader) never bind textures
+            if (cmd.shader->standard.useTexture.IsValid())
+            {
+                int meshUsesTexture = cmd.mesh->textures.empty() ? 0 : 1;
+                if (meshUsesTexture != useTexture)
+                {
+                    counts.textureToggles++;
+                    useTexture = meshUsesTexture;
+                }
+                if (meshUsesTexture && !SameTextureSet(textureOwner, cmd.mesh))
+                {
+                    counts.textures++;
+                    textureOwner = cmd.mesh;
+                }
+            }
+            if (cmd.wireframe != wireframe)
+            {
+                counts.polygonModes++;
+                wireframe = cmd.wireframe;
+            }
+        }
+        return counts;
+    }
+}
@@ -1,6 +1,11 @@
 #include "Renderer.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "SceneContext.h"
+#include "TextureAtlas.h"
+#include "VirtualTexture.h"
+#include <algorithm>
+#include <cmath>
 
 namespace PartC
 {
@@ -9,69 +14,324 @@ namespace PartC
     unsigned int Renderer::shadowMapFBO;
     unsigned int Renderer::shadowMap;
     Shader *Renderer::depthShader = nullptr;
-    glm::mat4 Renderer::lightSpaceMatrix;
+    UniformHandle Renderer::depthCascadeIndex;
+    ShadowCascade Renderer::cascades[CASCADE_COUNT];
+    float Renderer::shadowDistance = 60.0f;
+    float Renderer::cascadeSplitLambda = 0.75f;
+    bool Renderer::enableShadowCache = true;
+    unsigned int Renderer::staticShadowMapFBO = 0;
+    unsigned int Renderer::staticShadowMap = 0;
+    ShadowCacheEntry Renderer::shadowCache[CASCADE_COUNT];
+    bool Renderer::headless = false;
+    bool Renderer::enableFrustumCulling = true;
+    bool Renderer::enableOcclusionCulling = true;
+    bool Renderer::enableDrawSorting = true;
+    bool Renderer::enableLod = true;
+    bool Renderer::enableMeshletCulling = true;
+    bool Renderer::enableConeCulling = true;
+    RenderStats Renderer::stats;
+    unsigned int Renderer::cameraUBO = 0;
+    unsigned int Renderer::lightUBO = 0;
+    glm::mat4 Renderer::frameViewProjection = glm::mat4(1.0f);
+    glm::vec3 Renderer::frameCameraPos = glm::vec3(0.0f);
 
-    void Renderer::InitShadowMap()
+    // std140: mat4 = 64 bytes, vec4 = 16 bytes, no implicit padding in between
+    static_assert(sizeof(CameraUniformData) == 144, "CameraUniformData must match CameraBlock (std140)");
+    static_assert(sizeof(LightUniformData) == 352, "LightUniformData must match LightBlock (std140)");
+
+    void Renderer::ResetStats()
     {
-        glGenFramebuffers(1, &shadowMapFBO);
+        stats = RenderStats();
+        Shader::stats = UniformStats();
+    }
 
-        glGenTextures(1, &shadowMap);
-        glBindTexture(GL_TEXTURE_2D, shadowMap);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    static unsigned int CreateShadowArray()
+    {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, Renderer::SHADOW_WIDTH, Renderer::SHADOW_HEIGHT,
+                     CASCADE_COUNT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
         float borderColor[] = {1.0, 1.0, 1.0, 1.0};
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+        glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        return texture;
+    }
 
+    void Renderer::InitShadowMap()
+    {
+        glGenFramebuffers(1, &shadowMapFBO);
+
+        // [CSM] 每个级联一层；[Shadow Cache] 静态层使用相同格式，便于 glBlitFramebuffer 拷贝
+        shadowMap = CreateShadowArray();
         glBindFramebuffer(GL_FRAMEBUFFER, shadowMapFBO);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMap, 0);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMap, 0, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+
+        glGenFramebuffers(1, &staticShadowMapFBO);
+        staticShadowMap = CreateShadowArray();
+        glBindFramebuffer(GL_FRAMEBUFFER, staticShadowMapFBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticShadowMap, 0, 0);
         glDrawBuffer(GL_NONE);
         glReadBuffer(GL_NONE);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        InvalidateShadowCache();
 
         depthShader = new Shader("assets/shaders/shadow_depth.vert", "assets/shaders/shadow_depth.frag");
+        depthCascadeIndex = depthShader->getUniform("cascadeIndex");
+    }
+
+    void Renderer::InitUniformBuffers()
+    {
+        glGenBuffers(1, &cameraUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraUniformData), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, Shader::CAMERA_BLOCK_BINDING, cameraUBO);
+
+        glGenBuffers(1, &lightUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, lightUBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(LightUniformData), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, Shader::LIGHT_BLOCK_BINDING, lightUBO);
+
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 
-    void Renderer::BeginShadowMap()
+    void Renderer::ExtractClipPlanes(const glm::mat4 &projection, float &nearPlane, float &farPlane)
     {
-        glm::mat4 lightProjection, lightView;
-        float near_plane = 1.0f, far_plane = 20.0f;
-        // Orthographic projection for directional light
-        lightProjection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
+        // glm::perspective: m[2][2] = -(f + n) / (f - n), m[3][2] = -2fn / (f - n)
+        nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+        farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+    }
+
+    ShadowCascade Renderer::FitShadowCascade(const glm::mat4 &view, const glm::mat4 &projection, float nearDistance,
+                                             float farDistance, const CullingBounds &casters, int resolution,
+                                             bool stable)
+    {
+        ShadowCascade cascade;
+        cascade.nearDistance = nearDistance;
+        cascade.farDistance = farDistance;
+
+        // Corners of the view frustum slice in world space
+        glm::mat4 invView = glm::inverse(view);
+        float tanX = 1.0f / projection[0][0];
+        float tanY = 1.0f / projection[1][1];
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int i = 0; i < 8; i++)
+        {
+            float d = (i < 4) ? nearDistance : farDistance;
+            float sx = (i & 1) ? 1.0f : -1.0f;
+            float sy = (i & 2) ? 1.0f : -1.0f;
+            corners[i] = glm::vec3(invView * glm::vec4(sx * tanX * d, sy * tanY * d, -d, 1.0f));
+            center += corners[i];
+        }
+        center /= 8.0f;
+
+        float radius = 0.0f;
+        for (int i = 0; i < 8; i++)
+            radius = std::max(radius, glm::length(corners[i] - center));
+        // Round up so float noise in the corners does not change the texel size every frame
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        glm::vec3 lightDir = glm::normalize(mainLight.direction);
+        glm::vec3 up = std::fabs(lightDir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+        float step = 0.0f;
+        if (stable)
+        {
+            // Snap the center on a coarse grid in light space; the margin keeps the slice covered
+            step = 2.0f * radius / resolution * SHADOW_CACHE_SNAP_TEXELS;
+            glm::mat3 lightRotation(glm::lookAt(glm::vec3(0.0f), lightDir, up));
+            glm::vec3 snapped = glm::round((lightRotation * center) / step) * step;
+            center = glm::transpose(lightRotation) * snapped;
+            radius += step;
+        }
+        glm::mat4 lightView = glm::lookAt(center - lightDir * radius, center, up);
+
+        // Receivers lie in [0, 2r] along the light; casters in front of the sphere
+        // whose footprint overlaps the map pull the near plane towards the light
+        float zNear = 0.0f;
+        float zFar = 2.0f * radius;
+        glm::mat3 absRotation(lightView);
+        for (int c = 0; c < 3; c++)
+            absRotation[c] = glm::abs(absRotation[c]);
+        for (size_t i = 0; i < casters.Size(); i++)
+        {
+            if (stable && !casters.objects[i]->isStatic)
+                continue;
+            glm::vec3 bmin(casters.minX[i], casters.minY[i], casters.minZ[i]);
+            glm::vec3 bmax(casters.maxX[i], casters.maxY[i], casters.maxZ[i]);
+            glm::vec3 c = glm::vec3(lightView * glm::vec4(0.5f * (bmin + bmax), 1.0f));
+            glm::vec3 e = absRotation * (0.5f * (bmax - bmin));
+            if (c.x - e.x > radius || c.x + e.x < -radius || c.y - e.y > radius || c.y + e.y < -radius)
+                continue;
+            zNear = std::min(zNear, -c.z - e.z);
+        }
+        if (stable)
+            zNear = std::floor(zNear / step) * step;
+
+        glm::mat4 lightProjection = glm::ortho(-radius, radius, -radius, radius, zNear, zFar);
+
+        // Texel snapping: move the projection so the world origin lands on a texel corner
+        glm::mat4 matrix = lightProjection * lightView;
+        float halfRes = resolution * 0.5f;
+        glm::vec2 origin = glm::vec2(matrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)) * halfRes;
+        glm::vec2 offset = (glm::round(origin) - origin) / halfRes;
+        lightProjection[3][0] += offset.x;
+        lightProjection[3][1] += offset.y;
+
+        cascade.lightSpaceMatrix = lightProjection * lightView;
+        cascade.texelSize = 2.0f * radius / resolution;
+        cascade.depthRange = zFar - zNear;
+        return cascade;
+    }
+
+    void Renderer::UpdateFrameUniforms(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &camPos,
+                                       const CullingBounds &casters)
+    {
+        UpdateFrameUniforms(view, projection, projection, camPos, casters);
+    }
+
+    void Renderer::UpdateFrameUniforms(const glm::mat4 &view, const glm::mat4 &projection,
+                                       const glm::mat4 &cascadeProjection, const glm::vec3 &camPos,
+                                       const CullingBounds &casters)
+    {
+        CameraUniformData camera;
+        camera.view = view;
+        camera.projection = projection;
+        camera.viewPos = glm::vec4(camPos, 1.0f);
+        frameViewProjection = projection * view;
+        frameCameraPos = camPos;
+        glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraUniformData), &camera);
+
+        // [CSM] Practical split scheme: blend of logarithmic and uniform splits
+        float nearPlane, farPlane;
+        ExtractClipPlanes(cascadeProjection, nearPlane, farPlane);
+        float shadowFar = std::min(shadowDistance, farPlane);
+
+        LightUniformData light;
+        float splitNear = nearPlane;
+        for (int i = 0; i < CASCADE_COUNT; i++)
+        {
+            float p = (float)(i + 1) / CASCADE_COUNT;
+            float logSplit = nearPlane * std::pow(shadowFar / nearPlane, p);
+            float uniformSplit = nearPlane + (shadowFar - nearPlane) * p;
+            float splitFar = cascadeSplitLambda * logSplit + (1.0f - cascadeSplitLambda) * uniformSplit;
+
+            cascades[i] = FitShadowCascade(view, cascadeProjection, splitNear, splitFar, casters, SHADOW_WIDTH,
+                                           enableShadowCache);
+            light.lightSpaceMatrices[i] = cascades[i].lightSpaceMatrix;
+            light.cascadeSplits[i] = splitFar;
+            light.cascadeBias[i] = cascades[i].texelSize / cascades[i].depthRange;
+            splitNear = splitFar;
+        }
+        light.direction = glm::vec4(mainLight.direction, 0.0f);
+        light.ambient = glm::vec4(mainLight.ambient, 0.0f);
+        light.diffuse = glm::vec4(mainLight.diffuse, 0.0f);
+        light.specular = glm::vec4(mainLight.specular, 0.0f);
+        glBindBuffer(GL_UNIFORM_BUFFER, lightUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightUniformData), &light);
 
-        // Look from light direction
-        // Note: direction is usually pointing FROM light TO object, so we negate it to get position
-        // But here we assume direction is direction vector.
-        // Let's assume light is far away.
-        glm::vec3 lightPos = -mainLight.direction * 10.0f;
-        lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
-        lightSpaceMatrix = lightProjection * lightView;
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
 
+    void Renderer::BeginShadowMap(int cascade)
+    {
         depthShader->use();
-        depthShader->setMat4("lightSpaceMatrix", lightSpaceMatrix);
+        depthShader->setInt(depthCascadeIndex, cascade);
 
         glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
         glBindFramebuffer(GL_FRAMEBUFFER, shadowMapFBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMap, 0, cascade);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        // Casters in front of the near plane still write depth 0 instead of being clipped
+        glEnable(GL_DEPTH_CLAMP);
+    }
+
+    void Renderer::BeginStaticShadowMap(int cascade)
+    {
+        depthShader->use();
+        depthShader->setInt(depthCascadeIndex, cascade);
+
+        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+        glBindFramebuffer(GL_FRAMEBUFFER, staticShadowMapFBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticShadowMap, 0, cascade);
         glClear(GL_DEPTH_BUFFER_BIT);
+        glEnable(GL_DEPTH_CLAMP);
+    }
+
+    void Renderer::BeginShadowMapFromCache(int cascade)
+    {
+        depthShader->use();
+        depthShader->setInt(depthCascadeIndex, cascade);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, staticShadowMapFBO);
+        glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticShadowMap, 0, cascade);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadowMapFBO);
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMap, 0, cascade);
+        glBlitFramebuffer(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT, 0, 0, SHADOW_WIDTH, SHADOW_HEIGHT,
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, shadowMapFBO);
+        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+        glEnable(GL_DEPTH_CLAMP);
     }
 
     void Renderer::EndShadowMap(int scrWidth, int scrHeight)
     {
+        glDisable(GL_DEPTH_CLAMP);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         glViewport(0, 0, scrWidth, scrHeight);
     }
 
+    uint64_t Renderer::ShadowCacheSignature(int cascade, const CullingBounds &bounds, const std::vector<uint32_t> &casters,
+                                            const std::vector<Mesh *> &meshes)
+    {
+        // FNV-1a over the light matrix and each static caster's mesh id + transform
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const void *data, size_t size)
+        {
+            const unsigned char *bytes = static_cast<const unsigned char *>(data);
+            for (size_t i = 0; i < size; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        };
+
+        mix(&cascades[cascade].lightSpaceMatrix, sizeof(glm::mat4));
+        for (uint32_t idx : casters)
+        {
+            const SceneObject *obj = bounds.objects[idx];
+            glm::mat4 model = obj->GetModelMatrix();
+            // The id, not the address: a freed mesh's address can be reused by a new one
+            mix(&meshes[idx]->id, sizeof(uint64_t));
+            mix(&model, sizeof(glm::mat4));
+        }
+        return hash;
+    }
+
+    void Renderer::InvalidateShadowCache()
+    {
+        for (int i = 0; i < CASCADE_COUNT; i++)
+            shadowCache[i] = ShadowCacheEntry();
+    }
+
     void Renderer::RenderMesh(Mesh *mesh, Shader &shader, const glm::mat4 &modelMatrix)
     {
         shader.use();
-        shader.setMat4("model", modelMatrix);
+        shader.setMat4(shader.standard.model, modelMatrix);
 
         // Calculate Normal Matrix: transpose(inverse(mat3(model)))
         // Note: Inverting a matrix is costly, so in a real engine we would cache this.
         glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(modelMatrix)));
-        shader.setMat3("normalMatrix", normalMatrix);
+        shader.setMat3(shader.standard.normalMatrix, normalMatrix);
 
         if (mesh)
         {
@@ -79,25 +339,98 @@ namespace PartC
         }
     }
 
-    void Renderer::SetupLights(Shader &shader, const glm::vec3 &camPos)
+    void Renderer::ExecuteQueue(const RenderQueue &queue)
     {
-        shader.use();
-        shader.setVec3("viewPos", camPos);
+        Shader *shader = nullptr;
+        Mesh *mesh = nullptr;
+        const Mesh *textureOwner = nullptr;
+        bool wireframe = false;
+        std::vector<MeshletRange> ranges;
+
+        for (size_t i = 0; i < queue.Size(); i++)
+        {
+            const DrawCommand &cmd = queue.Get(i);
+
+            if (cmd.shader != shader)
+            {
+                shader = cmd.shader;
+                shader->use();
+                textureOwner = nullptr;
+            }
+            if (cmd.mesh != mesh)
+            {
+                mesh = cmd.mesh;
+                mesh->BindVertexArray();
+            }
+
+            const StandardUniforms &uniforms = shader->standard;
+            if (uniforms.useTexture.IsValid())
+            {
+                shader->setInt(uniforms.useTexture, mesh->textures.empty() ? 0 : 1);
+                if (!mesh->textures.empty() && !RenderQueue::SameTextureSet(textureOwner, mesh))
+                {
+                    mesh->BindTextures(*shader);
+                    textureOwner = mesh;
+                }
+                // [Atlas] per draw: a uniform change instead of a texture bind
+                mesh->ApplyDiffuseSource(*shader);
+            }
+
+            if (cmd.wireframe != wireframe)
+            {
+                wireframe = cmd.wireframe;
+                glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
+                glLineWidth(wireframe ? 2.5f : 1.0f);
+            }
 
-        // Use static mainLight settings
-        shader.setVec3("dirLight.direction", mainLight.direction);
-        shader.setVec3("dirLight.ambient", mainLight.ambient);
-        shader.setVec3("dirLight.diffuse", mainLight.diffuse);
-        shader.setVec3("dirLight.specular", mainLight.specular);
+            // Handles the program does not declare are invalid and skipped
+            shader->setVec3(uniforms.albedo, cmd.albedo);
+            shader->setFloat(uniforms.roughness, cmd.roughness);
+            shader->setFloat(uniforms.metallic, cmd.metallic);
+            shader->setMat4(uniforms.model, cmd.model);
+            if (uniforms.normalMatrix.IsValid())
+                shader->setMat3(uniforms.normalMatrix, glm::mat3(glm::transpose(glm::inverse(cmd.model))));
 
-        // Material defaults
-        // shader.setFloat("material.shininess", 32.0f); // Removed for PBR
+            if (cmd.clusterCull && enableMeshletCulling && !mesh->meshlets.empty())
+            {
+                Meshlets::Cull(mesh->meshlets, cmd.model, frameViewProjection, frameCameraPos, enableConeCulling,
+                               ranges, stats.meshlets);
+                mesh->DrawRanges(ranges);
+            }
+            else
+            {
+                mesh->DrawElements();
+            }
+        }
+
+        if (wireframe)
+        {
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            glLineWidth(1.0f);
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void Renderer::SetupLights(Shader &shader)
+    {
+        shader.use();
+
+        // Light parameters and lightSpaceMatrix come from the LightBlock UBO (see UpdateFrameUniforms)
 
         // Shadow Map
-        shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
         glActiveTexture(GL_TEXTURE15); // Use a high slot for shadow map
-        glBindTexture(GL_TEXTURE_2D, shadowMap);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, shadowMap);
         shader.setInt("shadowMap", 15);
+
+        // [Atlas] 小纹理共享的数组纹理，整帧保持绑定
+        glActiveTexture(GL_TEXTURE0 + TextureAtlas::TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, TextureAtlas::TextureId());
+        shader.setInt("atlasPages", TextureAtlas::TEXTURE_UNIT);
+
+        // [VT] 页缓存与间接纹理由使用虚拟纹理的绘制各自绑定，采样器单元固定
+        shader.setInt("vtCache", VirtualTexture::CACHE_UNIT);
+        shader.setInt("vtIndirection", VirtualTexture::INDIRECTION_UNIT);
     }
 
     Mesh *GeometryGenerator::CreateSphere(float radius, int segments)
@@ -6,6 +6,7 @@
 #include <iomanip>
 #include "ModelLoader.h"
 #include "GeometryUtils.h"
+#include "MeshLOD.h"
 
 SceneContext::SceneContext() {}
 
@@ -13,7 +14,7 @@ SceneContext::~SceneContext()
 {
     for (auto obj : objects)
     {
-        // delete obj->mesh; // Mesh is shared resource, do not delete here
+        // obj->mesh 为共享持有，其他场景 (运行模式备份) 仍可能在用
         delete obj;
     }
     objects.clear();
@@ -54,10 +55,10 @@ void SceneContext::DrawAll(Shader &shader)
         model = glm::scale(model, obj->scale);
 
         // 设置 Shader Uniforms
-        shader.setMat4("model", model);
-        shader.setVec3("albedo", obj->color);
-        shader.setFloat("roughness", obj->roughness);
-        shader.setFloat("metallic", obj->metallic);
+        shader.setMat4(shader.standard.model, model);
+        shader.setVec3(shader.standard.albedo, obj->color);
+        shader.setFloat(shader.standard.roughness, obj->roughness);
+        shader.setFloat(shader.standard.metallic, obj->metallic);
 
         // 绘制
         if (obj->mesh)
@@ -67,6 +68,15 @@ void SceneContext::DrawAll(Shader &shader)
     }
 }
 
+size_t SceneContext::RaycastBatch(const Ray *rays, RayHit *hits, size_t count)
+{
+    if (!rays || !hits || count == 0)
+        return 0;
+
+    rayBVH.Build(*this);
+    return rayBVH.Trace(rays, hits, count);
+}
+
 void SceneContext::SaveScene(const std::string &filename)
 {
     std::ofstream out(filename);
@@ -76,7 +86,7 @@ void SceneContext::SaveScene(const std::string &filename)
         return;
     }
 
-    out << "SCENE_v1" << std::endl;
+    out << "SCENE_v2" << std::endl;
     out << objects.size() << std::endl;
 
     for (auto obj : objects)
@@ -91,6 +101,7 @@ void SceneContext::SaveScene(const std::string &filename)
         out << obj->scale.x << " " << obj->scale.y << " " << obj->scale.z << std::endl;
         out << obj->color.r << " " << obj->color.g << " " << obj->color.b << std::endl;
         out << obj->roughness << " " << obj->metallic << std::endl;
+        out << (obj->isStatic ? 1 : 0) << std::endl;
         out << std::quoted(obj->texturePath.empty() ? "NONE" : obj->texturePath) << std::endl;
 
         out << obj->components.size() << std::endl;
@@ -115,7 +126,13 @@ void SceneContext::LoadScene(const std::string &filename)
 
     std::string header;
     in >> header;
-    if (header != "SCENE_v1")
+    // v2 adds the static flag after the material line
+    int version = 0;
+    if (header == "SCENE_v1")
+        version = 1;
+    else if (header == "SCENE_v2")
+        version = 2;
+    if (version == 0)
     {
         std::cerr << "Invalid scene file format: " << filename << std::endl;
         return;
@@ -165,6 +182,12 @@ void SceneContext::LoadScene(const std::string &filename)
         in >> obj->scale.x >> obj->scale.y >> obj->scale.z;
         in >> obj->color.r >> obj->color.g >> obj->color.b;
         in >> obj->roughness >> obj->metallic;
+        if (version >= 2)
+        {
+            int isStatic = 0;
+            in >> isStatic;
+            obj->isStatic = isStatic != 0;
+        }
         in >> std::quoted(texPath);
 
         if (texPath != "NONE")
@@ -174,8 +197,9 @@ void SceneContext::LoadScene(const std::string &filename)
             {
                 obj->mesh->textures.clear();
                 Texture diffuseMap(texPath.c_str(), "diffuse");
-                Texture specularMap(texPath.c_str(), "specular");
-                if (diffuseMap.id != 0)
+                Texture specularMap = diffuseMap; // same cached image
+                specularMap.type = "specular";
+                if (diffuseMap.IsLoaded())
                 {
                     obj->mesh->textures.push_back(diffuseMap);
                     obj->mesh->textures.push_back(specularMap);
@@ -202,6 +226,9 @@ void SceneContext::LoadScene(const std::string &filename)
                 std::cerr << "Unknown component type: " << typeName << std::endl;
             }
         }
+        // [LOD] 导入网格的简化链在后台开始构建，首帧不再卡顿
+        if (obj->geometryType == GeometryType::None)
+            PartC::MeshLOD::BuildChain(obj);
         AddObject(obj);
     }
     in.close();
@@ -0,0 +1,220 @@
+#include "ScreenCapture.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace PartC
+{
+    int ScreenCapture::maxPendingEncodes = 8;
+
+    ScreenCapture::ScreenCapture() : encoder(std::make_shared<EncoderState>())
+    {
+    }
+
+    ScreenCapture::~ScreenCapture()
+    {
+        // GL objects are released by Shutdown while the context exists; jobs still
+        // writing keep their own reference to the encoder state
+    }
+
+    void ScreenCapture::Request(const std::string &path, ImageFormat format, PngCompression pngLevel)
+    {
+        requests.push_back({path, format, pngLevel});
+    }
+
+    void ScreenCapture::StartRecording(const std::string &prefix, ImageFormat format, PngCompression pngLevel)
+    {
+        recording = true;
+        recordPrefix = prefix;
+        recordFormat = format;
+        recordPngLevel = pngLevel;
+        recordFrame = 0;
+        dropped = 0;
+        stalledMs = 0.0f;
+    }
+
+    void ScreenCapture::StopRecording()
+    {
+        recording = false;
+    }
+
+    int ScreenCapture::PendingEncodes() const
+    {
+        std::lock_guard<std::mutex> lock(encoder->mutex);
+        return encoder->pending;
+    }
+
+    bool ScreenCapture::StartReadback(const CaptureRequest &request, int width, int height)
+    {
+        Readback &slot = slots[nextSlot];
+        if (slot.fence != nullptr)
+            return false; // still in flight
+        nextSlot = (nextSlot + 1) % PBO_COUNT;
+
+        const size_t size = (size_t)width * height * 4;
+        if (slot.pbo == 0)
+            glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        if (slot.size != size)
+        {
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, nullptr, GL_STREAM_READ);
+            slot.size = size;
+        }
+        // RGBA rows are always 4-byte aligned; into the bound buffer, so this returns at once
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        slot.request = request;
+        slot.width = width;
+        slot.height = height;
+        return true;
+    }
+
+    void ScreenCapture::Collect(bool wait)
+    {
+        // Oldest first, so files are queued in the order they were captured
+        for (int i = 0; i < PBO_COUNT; i++)
+        {
+            Readback &slot = slots[(nextSlot + i) % PBO_COUNT];
+            if (slot.fence == nullptr)
+                continue;
+            const GLuint64 timeout = wait ? 1000000000ull : 0;
+            GLenum status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                continue;
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            auto pixels = std::make_shared<std::vector<uint8_t>>(slot.size);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            const void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)slot.size, GL_MAP_READ_BIT);
+            bool copied = mapped != nullptr;
+            if (copied)
+            {
+                std::memcpy(pixels->data(), mapped, slot.size);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            lastMapMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            std::shared_ptr<EncoderState> state = encoder;
+            if (!copied)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->failed++;
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->pending++;
+            }
+            CaptureRequest request = slot.request;
+            int width = slot.width, height = slot.height;
+            ThreadPool::Instance().EnqueueBackground([state, pixels, request, width, height]()
+            {
+                auto encodeStart = std::chrono::high_resolution_clock::now();
+                bool ok = ImageWriter::Write(request.path, pixels->data(), width, height, 4, request.format,
+                                             request.pngLevel);
+                float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - encodeStart).count();
+                if (!ok)
+                    std::cerr << "Failed to save screenshot: " << request.path << std::endl;
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->pending--;
+                (ok ? state->written : state->failed)++;
+                state->lastEncodeMs = ms;
+                state->done.notify_all();
+            });
+        }
+    }
+
+    void ScreenCapture::RecordFrame(int width, int height)
+    {
+        char index[16];
+        std::snprintf(index, sizeof(index), "%06d", recordFrame++);
+        CaptureRequest request = {recordPrefix + index + ImageWriter::Extension(recordFormat), recordFormat, recordPngLevel};
+
+        if (blockWhenBehind)
+        {
+            // Back-pressure: wait for the oldest readback, then for the encoder to fall
+            // below its bound. Collect may hand over up to PBO_COUNT more images, so the
+            // encoder holds at most maxPendingEncodes + PBO_COUNT frames.
+            auto start = std::chrono::high_resolution_clock::now();
+            if (slots[nextSlot].fence != nullptr)
+                Collect(true);
+            {
+                std::unique_lock<std::mutex> lock(encoder->mutex);
+                const int bound = std::max(1, maxPendingEncodes);
+                encoder->done.wait(lock, [this, bound]() { return encoder->pending < bound; });
+            }
+            stalledMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            if (!StartReadback(request, width, height))
+                dropped++; // the GPU copy took over a second
+        }
+        else if (PendingEncodes() >= maxPendingEncodes || !StartReadback(request, width, height))
+        {
+            dropped++;
+        }
+    }
+
+    void ScreenCapture::EndFrame(int width, int height)
+    {
+        Collect(false);
+        if (width <= 0 || height <= 0)
+            return;
+
+        if (recording)
+            RecordFrame(width, height);
+        // Single screenshots take the other buffer while recording, or wait a frame
+        if (!requests.empty() && StartReadback(requests.front(), width, height))
+            requests.pop_front();
+    }
+
+    void ScreenCapture::Shutdown()
+    {
+        Collect(true);
+        requests.clear();
+        recording = false;
+        for (Readback &slot : slots)
+        {
+            if (slot.fence != nullptr)
+                glDeleteSync(slot.fence);
+            if (slot.pbo != 0)
+                glDeleteBuffers(1, &slot.pbo);
+            slot = Readback();
+        }
+
+        // Files being written are finished, not cut short
+        std::unique_lock<std::mutex> lock(encoder->mutex);
+        encoder->done.wait(lock, [this]() { return encoder->pending == 0; });
+    }
+
+    CaptureStats ScreenCapture::Stats() const
+    {
+        CaptureStats stats;
+        stats.requested = (int)requests.size();
+        for (const Readback &slot : slots)
+        {
+            if (slot.fence != nullptr)
+                stats.readbacks++;
+        }
+        {
+            std::lock_guard<std::mutex> lock(encoder->mutex);
+            stats.encoding = encoder->pending;
+            stats.written = encoder->written;
+            stats.failed = encoder->failed;
+            stats.lastEncodeMs = encoder->lastEncodeMs;
+        }
+        stats.recording = recording;
+        stats.recordedFrames = recordFrame;
+        stats.dropped = dropped;
+        stats.stalledMs = stalledMs;
+        stats.lastMapMs = lastMapMs;
+        return stats;
+    }
+}
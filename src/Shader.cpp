@@ -1,5 +1,9 @@
 #include "Shader.h"
 #include <glm/gtc/type_ptr.hpp>
+#include <cstring>
+#include <algorithm>
+
+UniformStats Shader::stats;
 
 Shader::Shader(const char *vertexPath, const char *fragmentPath)
 {
@@ -53,6 +57,8 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath)
     glAttachShader(ID, fragment);
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
+    cacheUniformLocations();
+    bindUniformBlocks();
     // 删除着色器，它们已经链接到我们的程序中了，已经不再需要了
     glDeleteShader(vertex);
     glDeleteShader(fragment);
@@ -63,29 +69,178 @@ void Shader::use()
     glUseProgram(ID);
 }
 
+void Shader::cacheUniformLocations()
+{
+    // [新增] 链接后一次性枚举所有活动 uniform，之后的 set 调用只查表
+    uniformLocations.clear();
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> nameBuffer(maxLength > 0 ? maxLength : 1);
+
+    int maxLocation = -1;
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), length);
+
+        int location = glGetUniformLocation(ID, name.c_str());
+        if (location < 0)
+            continue; // uniform block member
+        uniformLocations[name] = location;
+        maxLocation = std::max(maxLocation, location);
+
+        // Arrays are reported as "name[0]": register the bare name and every element too
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+        {
+            std::string base = name.substr(0, name.size() - 3);
+            uniformLocations[base] = location;
+            for (GLint e = 1; e < size; e++)
+            {
+                std::string element = base + "[" + std::to_string(e) + "]";
+                int elementLocation = glGetUniformLocation(ID, element.c_str());
+                uniformLocations[element] = elementLocation;
+                maxLocation = std::max(maxLocation, elementLocation);
+            }
+        }
+    }
+    uniformCache.assign(maxLocation + 1, CachedValue());
+
+    standard.model = getUniform("model");
+    standard.normalMatrix = getUniform("normalMatrix");
+    standard.albedo = getUniform("albedo");
+    standard.metallic = getUniform("metallic");
+    standard.roughness = getUniform("roughness");
+    standard.useTexture = getUniform("useTexture");
+    standard.materialDiffuse = getUniform("material.diffuse");
+    standard.materialSpecular = getUniform("material.specular");
+    standard.atlasLayer = getUniform("atlasLayer");
+    standard.atlasRect = getUniform("atlasRect");
+    standard.virtualTexture = getUniform("virtualTexture");
+    standard.vtSize = getUniform("vtSize");
+    standard.vtSlots = getUniform("vtSlots");
+}
+
+void Shader::bindUniformBlocks()
+{
+    // Programs that do not declare a block simply skip it
+    unsigned int cameraIndex = glGetUniformBlockIndex(ID, "CameraBlock");
+    if (cameraIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, cameraIndex, CAMERA_BLOCK_BINDING);
+
+    unsigned int lightIndex = glGetUniformBlockIndex(ID, "LightBlock");
+    if (lightIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, lightIndex, LIGHT_BLOCK_BINDING);
+}
+
+UniformHandle Shader::getUniform(const std::string &name) const
+{
+    UniformHandle handle;
+    auto it = uniformLocations.find(name);
+    if (it != uniformLocations.end())
+    {
+        handle.location = it->second;
+        return handle;
+    }
+
+    // Not in the active list (optimized out or misspelled): remember the miss as well
+    handle.location = glGetUniformLocation(ID, name.c_str());
+    uniformLocations[name] = handle.location;
+    return handle;
+}
+
+UniformHandle Shader::lookup(const std::string &name) const
+{
+    stats.nameLookups++;
+    return getUniform(name);
+}
+
+bool Shader::updateCache(int location, const void *value, size_t size) const
+{
+    if (location < 0)
+        return false;
+    if (location >= (int)uniformCache.size())
+        uniformCache.resize(location + 1);
+
+    CachedValue &cached = uniformCache[location];
+    if (cached.valid && std::memcmp(cached.data, value, size) == 0)
+    {
+        stats.skipped++;
+        return false;
+    }
+    std::memcpy(cached.data, value, size);
+    cached.valid = true;
+    stats.uploads++;
+    return true;
+}
+
 void Shader::setBool(const std::string &name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    setBool(lookup(name), value);
 }
 void Shader::setInt(const std::string &name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    setInt(lookup(name), value);
 }
 void Shader::setFloat(const std::string &name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    setFloat(lookup(name), value);
 }
 void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    setMat3(lookup(name), mat);
 }
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    setMat4(lookup(name), mat);
 }
 void Shader::setVec3(const std::string &name, const glm::vec3 &value) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    setVec3(lookup(name), value);
+}
+
+void Shader::setVec4(const std::string &name, const glm::vec4 &value) const
+{
+    setVec4(lookup(name), value);
+}
+
+void Shader::setBool(UniformHandle handle, bool value) const
+{
+    setInt(handle, (int)value);
+}
+void Shader::setInt(UniformHandle handle, int value) const
+{
+    if (updateCache(handle.location, &value, sizeof(value)))
+        glUniform1i(handle.location, value);
+}
+void Shader::setFloat(UniformHandle handle, float value) const
+{
+    if (updateCache(handle.location, &value, sizeof(value)))
+        glUniform1f(handle.location, value);
+}
+void Shader::setMat3(UniformHandle handle, const glm::mat3 &mat) const
+{
+    if (updateCache(handle.location, &mat[0][0], sizeof(glm::mat3)))
+        glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+void Shader::setMat4(UniformHandle handle, const glm::mat4 &mat) const
+{
+    if (updateCache(handle.location, &mat[0][0], sizeof(glm::mat4)))
+        glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+void Shader::setVec3(UniformHandle handle, const glm::vec3 &value) const
+{
+    if (updateCache(handle.location, &value[0], sizeof(glm::vec3)))
+        glUniform3fv(handle.location, 1, &value[0]);
+}
+
+void Shader::setVec4(UniformHandle handle, const glm::vec4 &value) const
+{
+    if (updateCache(handle.location, &value[0], sizeof(glm::vec4)))
+        glUniform4fv(handle.location, 1, &value[0]);
 }
 
 void Shader::checkCompileErrors(unsigned int shader, std::string type)
@@ -0,0 +1,614 @@
+#include "SoftwareRasterizer.h"
+#include "SceneContext.h"
+#include "Texture.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "ThreadPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFTWARE_RASTER_USE_SSE 1
+#endif
+
+namespace PartC
+{
+    namespace
+    {
+        const float PI = 3.14159265359f;
+        // Work granularity for the vertex and setup/binning stages
+        const size_t VERTEX_CHUNK = 4096;
+        const size_t TRIANGLE_BATCH = 4096;
+
+        float EdgeFunction(float ax, float ay, float bx, float by, float px, float py)
+        {
+            return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+        }
+
+        // ---- fragment.glsl ports ----
+        float DistributionGGX(const glm::vec3 &N, const glm::vec3 &H, float roughness)
+        {
+            float a = roughness * roughness;
+            float a2 = a * a;
+            float NdotH = std::max(glm::dot(N, H), 0.0f);
+            float denom = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+            return a2 / (PI * denom * denom);
+        }
+
+        float GeometrySchlickGGX(float NdotV, float roughness)
+        {
+            float r = roughness + 1.0f;
+            float k = (r * r) / 8.0f;
+            return NdotV / (NdotV * (1.0f - k) + k);
+        }
+
+        float GeometrySmith(const glm::vec3 &N, const glm::vec3 &V, const glm::vec3 &L, float roughness)
+        {
+            float NdotV = std::max(glm::dot(N, V), 0.0f);
+            float NdotL = std::max(glm::dot(N, L), 0.0f);
+            return GeometrySchlickGGX(NdotV, roughness) * GeometrySchlickGGX(NdotL, roughness);
+        }
+
+        glm::vec3 FresnelSchlick(float cosTheta, const glm::vec3 &F0)
+        {
+            return F0 + (glm::vec3(1.0f) - F0) * std::pow(glm::clamp(1.0f - cosTheta, 0.0f, 1.0f), 5.0f);
+        }
+
+        // GL_REPEAT + GL_LINEAR on level 0 (no mipmaps)
+        glm::vec3 SampleBilinear(const TextureImage &image, const glm::vec2 &uv)
+        {
+            float u = uv.x - std::floor(uv.x);
+            float v = uv.y - std::floor(uv.y);
+            float fx = u * image.width - 0.5f;
+            float fy = v * image.height - 0.5f;
+            int x0 = (int)std::floor(fx);
+            int y0 = (int)std::floor(fy);
+            float tx = fx - x0;
+            float ty = fy - y0;
+
+            auto fetch = [&](int x, int y)
+            {
+                x = ((x % image.width) + image.width) % image.width;
+                y = ((y % image.height) + image.height) % image.height;
+                const unsigned char *p = &image.pixels[((size_t)y * image.width + x) * image.channels];
+                if (image.channels >= 3)
+                    return glm::vec3(p[0], p[1], p[2]) / 255.0f;
+                return glm::vec3(p[0] / 255.0f, 0.0f, 0.0f); // GL_RED
+            };
+
+            glm::vec3 top = glm::mix(fetch(x0, y0), fetch(x0 + 1, y0), tx);
+            glm::vec3 bottom = glm::mix(fetch(x0, y0 + 1), fetch(x0 + 1, y0 + 1), tx);
+            return glm::mix(top, bottom, ty);
+        }
+    }
+
+    SoftwareRasterizer::SoftwareRasterizer(int width, int height)
+        : width(0), height(0), stride(0), lightSpace(1.0f), cameraPos(0.0f)
+    {
+        Resize(width, height);
+        shadowDepth.assign(SHADOW_SIZE * SHADOW_SIZE, 1.0f);
+    }
+
+    void SoftwareRasterizer::Resize(int w, int h)
+    {
+        width = std::max(1, w);
+        height = std::max(1, h);
+        stride = (width + 3) & ~3;
+        color.assign((size_t)width * height * 3, 0);
+        depth.assign((size_t)stride * height, 1.0f);
+    }
+
+    void SoftwareRasterizer::Render(const std::vector<SceneObject *> &objects, const glm::mat4 &view, const glm::mat4 &projection,
+                                    const glm::vec3 &camPos, SoftwareFrameStats &stats)
+    {
+        auto frameStart = std::chrono::high_resolution_clock::now();
+        ThreadPool &pool = ThreadPool::Instance();
+
+        light = Renderer::mainLight;
+        cameraPos = camPos;
+        bounds.Build(objects);
+
+        // One map fitted to the whole shadow distance (the GPU path splits it into cascades)
+        float nearPlane, farPlane;
+        Renderer::ExtractClipPlanes(projection, nearPlane, farPlane);
+        ShadowCascade cascade = Renderer::FitShadowCascade(view, projection, nearPlane,
+                                                           std::min(Renderer::shadowDistance, farPlane), bounds, SHADOW_SIZE);
+        lightSpace = cascade.lightSpaceMatrix;
+        shadowBias = cascade.texelSize / cascade.depthRange;
+        CullStats cullStats;
+
+        // [LOD] Same screen-size selection as the GPU path, shared by both passes
+        lodMeshes.resize(bounds.Size());
+        for (size_t i = 0; i < bounds.Size(); i++)
+        {
+            lodMeshes[i] = bounds.objects[i]->mesh.get();
+            if (Renderer::enableLod)
+            {
+                glm::vec3 bmin(bounds.minX[i], bounds.minY[i], bounds.minZ[i]);
+                glm::vec3 bmax(bounds.maxX[i], bounds.maxY[i], bounds.maxZ[i]);
+                lodMeshes[i] = MeshLOD::Select(bounds.objects[i], MeshLOD::ScreenSize(bmin, bmax, camPos, projection), stats.lod);
+            }
+        }
+
+        // 1. Shadow map (depth only)
+        std::fill(shadowDepth.begin(), shadowDepth.end(), 1.0f);
+        Target shadowTarget = {SHADOW_SIZE, SHADOW_SIZE, SHADOW_SIZE, shadowDepth.data(), nullptr};
+        Culling::FrustumCull(Frustum::FromMatrix(lightSpace), bounds, visible, cullStats);
+        RenderPass(lightSpace, shadowTarget, false, stats);
+        stats.shadowCasters += (int)visible.size();
+
+        auto shadowEnd = std::chrono::high_resolution_clock::now();
+
+        // 2. Main pass
+        unsigned char clear[3];
+        for (int i = 0; i < 3; i++)
+            clear[i] = (unsigned char)(glm::clamp(clearColor[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        pool.ParallelFor(height, 16, [&](size_t begin, size_t end)
+                         {
+            for (size_t y = begin; y < end; y++)
+            {
+                unsigned char *row = &color[y * width * 3];
+                for (int x = 0; x < width; x++)
+                {
+                    row[x * 3 + 0] = clear[0];
+                    row[x * 3 + 1] = clear[1];
+                    row[x * 3 + 2] = clear[2];
+                }
+                std::fill(depth.begin() + y * stride, depth.begin() + (y + 1) * stride, 1.0f);
+            } });
+
+        glm::mat4 viewProj = projection * view;
+        Target mainTarget = {width, height, stride, depth.data(), color.data()};
+        Culling::FrustumCull(Frustum::FromMatrix(viewProj), bounds, visible, cullStats);
+        if (Renderer::enableOcclusionCulling)
+            occlusionBuffer.Cull(bounds, visible, viewProj, stats.occlusion);
+        RenderPass(viewProj, mainTarget, true, stats);
+        stats.objects += (int)visible.size();
+
+        auto frameEnd = std::chrono::high_resolution_clock::now();
+        stats.shadowMs += std::chrono::duration<float, std::milli>(shadowEnd - frameStart).count();
+        stats.mainMs += std::chrono::duration<float, std::milli>(frameEnd - shadowEnd).count();
+        stats.totalMs += std::chrono::duration<float, std::milli>(frameEnd - frameStart).count();
+    }
+
+    void SoftwareRasterizer::RenderPass(const glm::mat4 &viewProj, const Target &target, bool clusterCull, SoftwareFrameStats &stats)
+    {
+        ThreadPool &pool = ThreadPool::Instance();
+
+        // Per-object constants; transformed vertices of all draws share one array
+        draws.clear();
+        size_t vertexCount = 0;
+        for (uint32_t idx : visible)
+        {
+            const SceneObject *obj = bounds.objects[idx];
+            DrawItem draw;
+            draw.object = obj;
+            draw.mesh = lodMeshes[idx];
+            draw.model = obj->GetModelMatrix();
+            draw.mvp = viewProj * draw.model;
+            draw.normalMatrix = glm::mat3(glm::transpose(glm::inverse(draw.model)));
+            draw.material.albedo = obj->color;
+            draw.material.roughness = obj->roughness;
+            draw.material.metallic = obj->metallic;
+            draw.material.diffuse = nullptr;
+            for (const Texture &tex : draw.mesh->textures)
+            {
+                if (tex.type == "diffuse" && tex.image)
+                {
+                    draw.material.diffuse = tex.image.get();
+                    break;
+                }
+            }
+            draw.firstVertex = vertexCount;
+            vertexCount += draw.mesh->vertices.size();
+            draws.push_back(draw);
+        }
+        vertices.resize(vertexCount);
+
+        // Stage 1: vertex transform (vertex.glsl)
+        struct VertexJob
+        {
+            uint32_t draw;
+            size_t begin, end;
+        };
+        std::vector<VertexJob> vertexJobs;
+        activeBatches = 0;
+        for (uint32_t d = 0; d < draws.size(); d++)
+        {
+            const Mesh *mesh = draws[d].mesh;
+            for (size_t v = 0; v < mesh->vertices.size(); v += VERTEX_CHUNK)
+                vertexJobs.push_back({d, v, std::min(v + VERTEX_CHUNK, mesh->vertices.size())});
+
+            // [Meshlet] Ranged draw: only the index ranges of visible meshlets
+            ranges.clear();
+            if (clusterCull && Renderer::enableMeshletCulling && !mesh->meshlets.empty())
+                Meshlets::Cull(mesh->meshlets, draws[d].model, viewProj, cameraPos, Renderer::enableConeCulling,
+                               ranges, stats.meshlets);
+            else
+                ranges.push_back({0, (uint32_t)mesh->indices.size()});
+
+            for (const MeshletRange &range : ranges)
+            {
+                size_t triEnd = (range.indexOffset + range.indexCount) / 3;
+                for (size_t t = range.indexOffset / 3; t < triEnd; t += TRIANGLE_BATCH)
+                {
+                    if (activeBatches == batches.size())
+                        batches.emplace_back();
+                    Batch &batch = batches[activeBatches++];
+                    batch.draw = d;
+                    batch.triBegin = t;
+                    batch.triEnd = std::min(t + TRIANGLE_BATCH, triEnd);
+                }
+            }
+        }
+
+        const bool shading = target.color != nullptr;
+        pool.ParallelFor(vertexJobs.size(), 1, [&](size_t begin, size_t end)
+                         {
+            for (size_t j = begin; j < end; j++)
+            {
+                const VertexJob &job = vertexJobs[j];
+                const DrawItem &draw = draws[job.draw];
+                const std::vector<Vertex> &src = draw.mesh->vertices;
+                ClipVertex *dst = &vertices[draw.firstVertex];
+                for (size_t i = job.begin; i < job.end; i++)
+                {
+                    dst[i].clip = draw.mvp * glm::vec4(src[i].Position, 1.0f);
+                    if (shading)
+                    {
+                        dst[i].worldPos = glm::vec3(draw.model * glm::vec4(src[i].Position, 1.0f));
+                        dst[i].normal = draw.normalMatrix * src[i].Normal;
+                        dst[i].uv = src[i].TexCoords;
+                    }
+                }
+            } });
+
+        // Stage 2: clip, set up and bin triangles
+        const int tilesX = (target.width + TILE_SIZE - 1) / TILE_SIZE;
+        const int tilesY = (target.height + TILE_SIZE - 1) / TILE_SIZE;
+        pool.ParallelFor(activeBatches, 1, [&](size_t begin, size_t end)
+                         {
+            for (size_t b = begin; b < end; b++)
+                SetupBatch(batches[b], target, tilesX, tilesY); });
+
+        // Stage 3: rasterize and shade, one job per tile
+        tilePixels.assign((size_t)tilesX * tilesY, 0);
+        pool.ParallelFor(tilePixels.size(), 1, [&](size_t begin, size_t end)
+                         {
+            for (size_t t = begin; t < end; t++)
+                tilePixels[t] = RasterizeTile((int)(t % tilesX), (int)(t / tilesX), tilesX, target); });
+
+        for (size_t b = 0; b < activeBatches; b++)
+        {
+            stats.triangles += batches[b].submitted;
+            stats.trianglesRasterized += batches[b].rasterized;
+        }
+        if (shading)
+        {
+            for (long long pixels : tilePixels)
+                stats.pixelsShaded += pixels;
+        }
+    }
+
+    void SoftwareRasterizer::SetupBatch(Batch &batch, const Target &target, int tilesX, int tilesY)
+    {
+        batch.triangles.clear();
+        batch.clipped.clear();
+        batch.submitted = 0;
+        batch.rasterized = 0;
+
+        const DrawItem &draw = draws[batch.draw];
+        const std::vector<unsigned int> &indices = draw.mesh->indices;
+        const ClipVertex *base = &vertices[draw.firstVertex];
+        for (size_t t = batch.triBegin; t < batch.triEnd; t++)
+            SetupTriangle(base[indices[t * 3]], base[indices[t * 3 + 1]], base[indices[t * 3 + 2]], batch, target);
+
+        // Bin into tiles: count, prefix sum, fill (CSR layout, triangle order preserved)
+        const size_t tileCount = (size_t)tilesX * tilesY;
+        batch.tileOffsets.assign(tileCount + 1, 0);
+        for (const TriangleSetup &tri : batch.triangles)
+        {
+            for (int ty = tri.minY / TILE_SIZE; ty <= tri.maxY / TILE_SIZE; ty++)
+                for (int tx = tri.minX / TILE_SIZE; tx <= tri.maxX / TILE_SIZE; tx++)
+                    batch.tileOffsets[ty * tilesX + tx + 1]++;
+        }
+        for (size_t t = 0; t < tileCount; t++)
+            batch.tileOffsets[t + 1] += batch.tileOffsets[t];
+
+        batch.tileTriangles.resize(batch.tileOffsets[tileCount]);
+        std::vector<uint32_t> cursor(batch.tileOffsets.begin(), batch.tileOffsets.end() - 1);
+        for (uint32_t i = 0; i < (uint32_t)batch.triangles.size(); i++)
+        {
+            const TriangleSetup &tri = batch.triangles[i];
+            for (int ty = tri.minY / TILE_SIZE; ty <= tri.maxY / TILE_SIZE; ty++)
+                for (int tx = tri.minX / TILE_SIZE; tx <= tri.maxX / TILE_SIZE; tx++)
+                    batch.tileTriangles[cursor[ty * tilesX + tx]++] = i;
+        }
+    }
+
+    void SoftwareRasterizer::SetupTriangle(const ClipVertex &a, const ClipVertex &b, const ClipVertex &c, Batch &batch, const Target &target)
+    {
+        batch.submitted++;
+
+        // Trivial reject against one clip plane shared by all three vertices
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (a.clip[axis] > a.clip.w && b.clip[axis] > b.clip.w && c.clip[axis] > c.clip.w)
+                return;
+            if (a.clip[axis] < -a.clip.w && b.clip[axis] < -b.clip.w && c.clip[axis] < -c.clip.w)
+                return;
+        }
+
+        float da = a.clip.z + a.clip.w;
+        float db = b.clip.z + b.clip.w;
+        float dc = c.clip.z + c.clip.w;
+        if (da >= 0.0f && db >= 0.0f && dc >= 0.0f)
+        {
+            AddTriangle(&a, &b, &c, batch, target);
+            return;
+        }
+
+        // Clip against the near plane (z >= -w); x/y are handled by the bounding box
+        const ClipVertex *in[3] = {&a, &b, &c};
+        const ClipVertex *poly[4];
+        int count = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            const ClipVertex &p = *in[i];
+            const ClipVertex &q = *in[(i + 1) % 3];
+            float dp = p.clip.z + p.clip.w;
+            float dq = q.clip.z + q.clip.w;
+            if (dp >= 0.0f)
+                poly[count++] = &p;
+            if ((dp >= 0.0f) != (dq >= 0.0f))
+            {
+                float t = dp / (dp - dq);
+                ClipVertex r;
+                r.clip = glm::mix(p.clip, q.clip, t);
+                r.worldPos = glm::mix(p.worldPos, q.worldPos, t);
+                r.normal = glm::mix(p.normal, q.normal, t);
+                r.uv = glm::mix(p.uv, q.uv, t);
+                batch.clipped.push_back(r);
+                poly[count++] = &batch.clipped.back();
+            }
+        }
+
+        for (int i = 1; i + 1 < count; i++)
+            AddTriangle(poly[0], poly[i], poly[i + 1], batch, target);
+    }
+
+    void SoftwareRasterizer::AddTriangle(const ClipVertex *a, const ClipVertex *b, const ClipVertex *c, Batch &batch, const Target &target)
+    {
+        const ClipVertex *v[3] = {a, b, c};
+        float sx[3], sy[3], sz[3], invW[3];
+        for (int i = 0; i < 3; i++)
+        {
+            invW[i] = 1.0f / v[i]->clip.w;
+            sx[i] = (v[i]->clip.x * invW[i] * 0.5f + 0.5f) * target.width;
+            sy[i] = (v[i]->clip.y * invW[i] * 0.5f + 0.5f) * target.height;
+            sz[i] = v[i]->clip.z * invW[i] * 0.5f + 0.5f;
+        }
+
+        float area = EdgeFunction(sx[0], sy[0], sx[1], sy[1], sx[2], sy[2]);
+        if (std::fabs(area) < 1e-12f)
+            return;
+
+        TriangleSetup tri;
+        tri.minX = std::max(0, (int)std::floor(std::min(sx[0], std::min(sx[1], sx[2]))));
+        tri.maxX = std::min(target.width - 1, (int)std::ceil(std::max(sx[0], std::max(sx[1], sx[2]))));
+        tri.minY = std::max(0, (int)std::floor(std::min(sy[0], std::min(sy[1], sy[2]))));
+        tri.maxY = std::min(target.height - 1, (int)std::ceil(std::max(sy[0], std::max(sy[1], sy[2]))));
+        if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+            return;
+
+        // Edge i is opposite vertex i; dividing by the signed area makes both
+        // windings produce positive barycentrics inside (no face culling, like the GL path)
+        float invArea = 1.0f / area;
+        tri.zA = tri.zB = tri.zC = 0.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            int j = (i + 1) % 3, k = (i + 2) % 3;
+            tri.edgeA[i] = (sy[j] - sy[k]) * invArea;
+            tri.edgeB[i] = (sx[k] - sx[j]) * invArea;
+            tri.edgeC[i] = ((sy[k] - sy[j]) * sx[j] - (sx[k] - sx[j]) * sy[j]) * invArea;
+            tri.zA += sz[i] * tri.edgeA[i];
+            tri.zB += sz[i] * tri.edgeB[i];
+            tri.zC += sz[i] * tri.edgeC[i];
+            tri.invW[i] = invW[i];
+            tri.v[i] = v[i];
+        }
+        tri.draw = batch.draw;
+
+        batch.triangles.push_back(tri);
+        batch.rasterized++;
+    }
+
+    long long SoftwareRasterizer::RasterizeTile(int tileX, int tileY, int tilesX, const Target &target)
+    {
+        const int tx0 = tileX * TILE_SIZE;
+        const int ty0 = tileY * TILE_SIZE;
+        const int tx1 = std::min(tx0 + TILE_SIZE, target.width) - 1;
+        const int ty1 = std::min(ty0 + TILE_SIZE, target.height) - 1;
+        const size_t tile = (size_t)tileY * tilesX + tileX;
+        long long pixels = 0;
+
+        for (size_t b = 0; b < activeBatches; b++)
+        {
+            const Batch &batch = batches[b];
+            for (uint32_t k = batch.tileOffsets[tile]; k < batch.tileOffsets[tile + 1]; k++)
+            {
+                const TriangleSetup &tri = batch.triangles[batch.tileTriangles[k]];
+                int x0 = std::max(tri.minX, tx0);
+                int x1 = std::min(tri.maxX, tx1);
+                int y0 = std::max(tri.minY, ty0);
+                int y1 = std::min(tri.maxY, ty1);
+                if (x0 > x1 || y0 > y1)
+                    continue;
+                // Tiles start at multiples of 4, so aligned groups of 4 never leave the tile
+                x0 &= ~3;
+
+#ifdef SOFTWARE_RASTER_USE_SSE
+                const __m128 laneOffset = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+                const __m128 e0A = _mm_set1_ps(tri.edgeA[0]), e1A = _mm_set1_ps(tri.edgeA[1]), e2A = _mm_set1_ps(tri.edgeA[2]);
+                const __m128 zA = _mm_set1_ps(tri.zA);
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 xLimit = _mm_set1_ps((float)x1 + 1.0f);
+
+                for (int y = y0; y <= y1; y++)
+                {
+                    const float py = y + 0.5f;
+                    const __m128 e0Row = _mm_set1_ps(tri.edgeB[0] * py + tri.edgeC[0]);
+                    const __m128 e1Row = _mm_set1_ps(tri.edgeB[1] * py + tri.edgeC[1]);
+                    const __m128 e2Row = _mm_set1_ps(tri.edgeB[2] * py + tri.edgeC[2]);
+                    const __m128 zRow = _mm_set1_ps(tri.zB * py + tri.zC);
+                    float *depthRow = target.depth + (size_t)y * target.stride;
+
+                    for (int x = x0; x <= x1; x += 4)
+                    {
+                        __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffset);
+                        __m128 e0 = _mm_add_ps(_mm_mul_ps(e0A, px), e0Row);
+                        __m128 e1 = _mm_add_ps(_mm_mul_ps(e1A, px), e1Row);
+                        __m128 e2 = _mm_add_ps(_mm_mul_ps(e2A, px), e2Row);
+                        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                                   _mm_and_ps(_mm_cmpge_ps(e2, zero), _mm_cmplt_ps(px, xLimit)));
+                        if (_mm_movemask_ps(inside) == 0)
+                            continue;
+
+                        __m128 z = _mm_add_ps(_mm_mul_ps(zA, px), zRow);
+                        __m128 stored = _mm_loadu_ps(depthRow + x);
+                        __m128 pass = _mm_and_ps(inside, _mm_and_ps(_mm_cmplt_ps(z, stored), _mm_cmpge_ps(z, zero)));
+                        int bits = _mm_movemask_ps(pass);
+                        if (bits == 0)
+                            continue;
+
+                        _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, stored)));
+
+                        if (target.color)
+                        {
+                            for (int lane = 0; lane < 4; lane++)
+                            {
+                                if (bits & (1 << lane))
+                                {
+                                    ShadePixel(tri, x + lane + 0.5f, py, (size_t)y * target.width + x + lane, target);
+                                    pixels++;
+                                }
+                            }
+                        }
+                    }
+                }
+#else
+                for (int y = y0; y <= y1; y++)
+                {
+                    const float py = y + 0.5f;
+                    float *depthRow = target.depth + (size_t)y * target.stride;
+                    for (int x = x0; x <= x1; x++)
+                    {
+                        const float px = x + 0.5f;
+                        float e0 = tri.edgeA[0] * px + tri.edgeB[0] * py + tri.edgeC[0];
+                        float e1 = tri.edgeA[1] * px + tri.edgeB[1] * py + tri.edgeC[1];
+                        float e2 = tri.edgeA[2] * px + tri.edgeB[2] * py + tri.edgeC[2];
+                        if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f)
+                            continue;
+                        float z = tri.zA * px + tri.zB * py + tri.zC;
+                        if (z < 0.0f || z >= depthRow[x])
+                            continue;
+                        depthRow[x] = z;
+                        if (target.color)
+                        {
+                            ShadePixel(tri, px, py, (size_t)y * target.width + x, target);
+                            pixels++;
+                        }
+                    }
+                }
+#endif
+            }
+        }
+        return pixels;
+    }
+
+    void SoftwareRasterizer::ShadePixel(const TriangleSetup &tri, float px, float py, size_t pixel, const Target &target) const
+    {
+        // Perspective-correct attribute interpolation
+        float w[3];
+        float sum = 0.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            w[i] = (tri.edgeA[i] * px + tri.edgeB[i] * py + tri.edgeC[i]) * tri.invW[i];
+            sum += w[i];
+        }
+        float norm = 1.0f / sum;
+        for (int i = 0; i < 3; i++)
+            w[i] *= norm;
+
+        const ClipVertex &v0 = *tri.v[0], &v1 = *tri.v[1], &v2 = *tri.v[2];
+        glm::vec3 worldPos = v0.worldPos * w[0] + v1.worldPos * w[1] + v2.worldPos * w[2];
+        glm::vec3 normal = v0.normal * w[0] + v1.normal * w[1] + v2.normal * w[2];
+        glm::vec2 uv = v0.uv * w[0] + v1.uv * w[1] + v2.uv * w[2];
+
+        glm::vec3 rgb = Shade(worldPos, normal, uv, draws[tri.draw].material);
+        unsigned char *out = &target.color[pixel * 3];
+        out[0] = (unsigned char)(glm::clamp(rgb.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+        out[1] = (unsigned char)(glm::clamp(rgb.g, 0.0f, 1.0f) * 255.0f + 0.5f);
+        out[2] = (unsigned char)(glm::clamp(rgb.b, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    glm::vec3 SoftwareRasterizer::Shade(const glm::vec3 &worldPos, const glm::vec3 &normal, const glm::vec2 &uv, const Material &material) const
+    {
+        glm::vec3 N = glm::normalize(normal);
+        glm::vec3 V = glm::normalize(cameraPos - worldPos);
+
+        glm::vec3 F0 = glm::mix(glm::vec3(0.04f), material.albedo, material.metallic);
+
+        glm::vec3 L = glm::normalize(-light.direction);
+        glm::vec3 H = glm::normalize(V + L);
+
+        float NDF = DistributionGGX(N, H, material.roughness);
+        float G = GeometrySmith(N, V, L, material.roughness);
+        glm::vec3 F = FresnelSchlick(std::max(glm::dot(H, V), 0.0f), F0);
+
+        float NdotL = std::max(glm::dot(N, L), 0.0f);
+        glm::vec3 specular = (NDF * G * F) / (4.0f * std::max(glm::dot(N, V), 0.0f) * NdotL + 0.0001f);
+        glm::vec3 kD = (glm::vec3(1.0f) - F) * (1.0f - material.metallic);
+
+        glm::vec3 albedo = material.diffuse ? SampleBilinear(*material.diffuse, uv) : material.albedo;
+
+        glm::vec3 Lo = (kD * albedo / PI + specular) * light.diffuse * NdotL;
+        float shadow = ShadowFactor(worldPos, N, L);
+        glm::vec3 rgb = light.ambient * albedo + (1.0f - shadow) * Lo;
+
+        // HDR tonemapping (Reinhard) + gamma
+        rgb = rgb / (rgb + glm::vec3(1.0f));
+        return glm::pow(rgb, glm::vec3(1.0f / 2.2f));
+    }
+
+    float SoftwareRasterizer::ShadowFactor(const glm::vec3 &worldPos, const glm::vec3 &normal, const glm::vec3 &lightDir) const
+    {
+        glm::vec4 lightPos = lightSpace * glm::vec4(worldPos, 1.0f);
+        glm::vec3 proj = glm::vec3(lightPos) / lightPos.w * 0.5f + 0.5f;
+        if (proj.z > 1.0f)
+            return 0.0f;
+
+        // Same texel-scaled slope bias as fragment.glsl
+        float NdotL = glm::clamp(glm::dot(normal, lightDir), 0.0f, 1.0f);
+        float slope = std::min(std::sqrt(1.0f - NdotL * NdotL) / std::max(NdotL, 0.05f), 4.0f);
+        float bias = shadowBias * (1.5f + slope);
+
+        // 3x3 PCF; outside the map behaves like GL_CLAMP_TO_BORDER with depth 1.0
+        int cx = (int)std::floor(proj.x * SHADOW_SIZE);
+        int cy = (int)std::floor(proj.y * SHADOW_SIZE);
+        float shadow = 0.0f;
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                int sx = cx + dx, sy = cy + dy;
+                float closest = 1.0f;
+                if (sx >= 0 && sy >= 0 && sx < SHADOW_SIZE && sy < SHADOW_SIZE)
+                    closest = shadowDepth[(size_t)sy * SHADOW_SIZE + sx];
+                if (proj.z - bias > closest)
+                    shadow += 1.0f;
+            }
+        }
+        return shadow / 9.0f;
+    }
+}
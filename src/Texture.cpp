@@ -1,4 +1,5 @@
 #include "Texture.h"
+#include "TextureManager.h"
 #include <iostream>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -6,41 +7,45 @@
 
 Texture::Texture() : id(0), type(""), path("") {}
 
-Texture::Texture(const char *path, const std::string &type) : type(type), path(path)
+Texture::Texture(const char *path, const std::string &type, const TextureParams &params) : id(0), type(type), path(path)
 {
-    glGenTextures(1, &id);
-
-    int width, height, nrComponents;
-    // stbi_set_flip_vertically_on_load(true); // Usually needed for OpenGL
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
+    // [TextureManager] 同一路径 + 参数只解码、上传一次
+    entry = PartC::TextureManager::Acquire(path, params);
+    if (entry)
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, id);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
+        id = entry->id;
+        image = entry->image;
     }
     else
     {
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
     }
 }
 
+Texture::Texture(const unsigned char *data, int width, int height, int channels, const std::string &type, const std::string &path,
+                 const TextureParams &params)
+    : id(0), type(type), path(path)
+{
+    entry = PartC::TextureManager::Create(data, width, height, channels, params);
+    id = entry->id;
+    image = entry->image;
+}
+
+int Texture::AtlasLayer() const
+{
+    return entry ? entry->atlasLayer : -1;
+}
+
+glm::vec4 Texture::AtlasRect() const
+{
+    return entry ? entry->atlasRect : glm::vec4(0.0f);
+}
+
+PartC::VirtualTexture *Texture::Virtual() const
+{
+    return entry ? entry->virtualTexture.get() : nullptr;
+}
+
 void Texture::Bind(int unit) const
 {
     glActiveTexture(GL_TEXTURE0 + unit);
@@ -0,0 +1,295 @@
+#include "TextureAtlas.h"
+#include "TextureContainer.h"
+#include "BlockCompression.h"
+#include "ColorSpace.h"
+#include <algorithm>
+#include <climits>
+
+namespace PartC
+{
+    bool TextureAtlas::enabled = true;
+    int TextureAtlas::maxTextureSize = 256;
+    std::vector<TextureAtlas::Page> TextureAtlas::pages;
+    unsigned int TextureAtlas::arrayId = 0;
+    int TextureAtlas::capacity = 0;
+    int TextureAtlas::rejected = 0;
+
+    namespace
+    {
+        int AlignCell(int size) { return (size + 7) & ~7; }
+
+        // One level as RGBA8, channels mapped the way GL expands RED / RG / RGB
+        std::vector<uint8_t> LevelToRGBA(const TextureContainer &container, const TextureLevel &level)
+        {
+            if (container.format != BlockFormat::None)
+                return BlockCompression::Decode(level.data, level.width, level.height, container.format);
+
+            const int channels = container.channels;
+            const size_t count = (size_t)level.width * level.height;
+            std::vector<uint8_t> rgba(count * 4);
+            for (size_t i = 0; i < count; i++)
+            {
+                const unsigned char *src = level.data + i * channels;
+                uint8_t *dst = &rgba[i * 4];
+                dst[0] = src[0];
+                dst[1] = channels > 1 ? src[1] : 0;
+                dst[2] = channels > 2 ? src[2] : 0;
+                dst[3] = channels > 3 ? src[3] : 255;
+            }
+            return rgba;
+        }
+
+        // [Atlas] 2x2 box filter of an RGBA8 level, for containers whose chain stops
+        // before MIP_LEVELS; colour is averaged in linear light like TextureContainer
+        std::vector<uint8_t> HalveRGBA(const std::vector<uint8_t> &texels, int &width, int &height, int channels, bool srgb)
+        {
+            const SrgbTables &tables = Srgb();
+            const int halfWidth = std::max(1, width / 2), halfHeight = std::max(1, height / 2);
+            std::vector<uint8_t> half((size_t)halfWidth * halfHeight * 4);
+            for (int y = 0; y < halfHeight; y++)
+            {
+                const int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+                for (int x = 0; x < halfWidth; x++)
+                {
+                    const int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+                    const uint8_t *taps[4] = {&texels[((size_t)y0 * width + x0) * 4], &texels[((size_t)y0 * width + x1) * 4],
+                                              &texels[((size_t)y1 * width + x0) * 4], &texels[((size_t)y1 * width + x1) * 4]};
+                    uint8_t *out = &half[((size_t)y * halfWidth + x) * 4];
+                    for (int c = 0; c < 4; c++)
+                    {
+                        // Alpha is the last source channel of 2- and 4-channel images
+                        const bool color = srgb && c < 3 && !(channels == 2 && c == 1);
+                        float sum = 0.0f;
+                        for (const uint8_t *tap : taps)
+                            sum += color ? tables.decode[tap[c]] : tap[c] / 255.0f;
+                        const float v = sum * 0.25f;
+                        out[c] = color ? tables.encode[(int)(v * (SrgbTables::ENCODE_SIZE - 1) + 0.5f)]
+                                       : (uint8_t)(v * 255.0f + 0.5f);
+                    }
+                }
+            }
+            width = halfWidth;
+            height = halfHeight;
+            return half;
+        }
+    }
+
+    bool TextureAtlas::Place(Page &page, int width, int height, int &x, int &y)
+    {
+        // Bottom-left: the lowest position, ties to the narrowest segment
+        int bestY = INT_MAX, bestWidth = INT_MAX;
+        int bestIndex = -1;
+        for (size_t i = 0; i < page.skyline.size(); i++)
+        {
+            const int left = page.skyline[i].x;
+            if (left + width > PAGE_SIZE)
+                break;
+            int top = 0;
+            for (size_t j = i; j < page.skyline.size() && page.skyline[j].x < left + width; j++)
+                top = std::max(top, page.skyline[j].y);
+            if (top + height > PAGE_SIZE)
+                continue;
+            if (top < bestY || (top == bestY && page.skyline[i].width < bestWidth))
+            {
+                bestY = top;
+                bestWidth = page.skyline[i].width;
+                bestIndex = (int)i;
+            }
+        }
+        if (bestIndex < 0)
+            return false;
+
+        x = page.skyline[bestIndex].x;
+        y = bestY;
+        SkylineSegment segment = {x, y + height, width};
+        page.skyline.insert(page.skyline.begin() + bestIndex, segment);
+
+        // Cut the segments the new one covers
+        for (size_t i = bestIndex + 1; i < page.skyline.size();)
+        {
+            const int end = segment.x + segment.width;
+            if (page.skyline[i].x >= end)
+                break;
+            int overlap = end - page.skyline[i].x;
+            page.skyline[i].x += overlap;
+            page.skyline[i].width -= overlap;
+            if (page.skyline[i].width > 0)
+                break;
+            page.skyline.erase(page.skyline.begin() + i);
+        }
+        for (size_t i = 0; i + 1 < page.skyline.size();)
+        {
+            if (page.skyline[i].y == page.skyline[i + 1].y)
+            {
+                page.skyline[i].width += page.skyline[i + 1].width;
+                page.skyline.erase(page.skyline.begin() + i + 1);
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        page.regions++;
+        page.area += (long long)width * height;
+        return true;
+    }
+
+    void TextureAtlas::Grow(int layers)
+    {
+        unsigned int grown = 0;
+        glGenTextures(1, &grown);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, grown);
+        for (int level = 0; level < MIP_LEVELS; level++)
+        {
+            const int size = PAGE_SIZE >> level;
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size, size, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, MIP_LEVELS - 1);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        if (arrayId != 0)
+        {
+            // Copy the existing layers through a read framebuffer (no glCopyImageSubData in 3.3)
+            GLint previousRead = 0;
+            glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+            unsigned int fbo = 0;
+            glGenFramebuffers(1, &fbo);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+            for (int level = 0; level < MIP_LEVELS; level++)
+            {
+                const int size = PAGE_SIZE >> level;
+                for (int layer = 0; layer < capacity; layer++)
+                {
+                    glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, arrayId, level, layer);
+                    glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, 0, 0, size, size);
+                }
+            }
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)previousRead);
+            glDeleteFramebuffers(1, &fbo);
+            glDeleteTextures(1, &arrayId);
+        }
+
+        arrayId = grown;
+        capacity = layers;
+    }
+
+    bool TextureAtlas::Insert(const TextureContainer &container, const TextureParams &params, int &layer, glm::vec4 &rect)
+    {
+        if (!enabled || container.width > maxTextureSize || container.height > maxTextureSize ||
+            params.wrap != GL_REPEAT || params.magFilter != GL_LINEAR || params.minFilter != GL_LINEAR_MIPMAP_LINEAR)
+            return false;
+
+        const int cellWidth = AlignCell(container.width + 2 * GUTTER);
+        const int cellHeight = AlignCell(container.height + 2 * GUTTER);
+        if (cellWidth > PAGE_SIZE || cellHeight > PAGE_SIZE)
+            return false;
+        int x = 0, y = 0;
+        layer = -1;
+        for (size_t i = 0; i < pages.size() && layer < 0; i++)
+        {
+            if (Place(pages[i], cellWidth, cellHeight, x, y))
+                layer = (int)i;
+        }
+        if (layer < 0)
+        {
+            if ((int)pages.size() >= MAX_LAYERS)
+            {
+                rejected++;
+                return false;
+            }
+            if ((int)pages.size() >= capacity)
+                Grow(std::min(MAX_LAYERS, std::max(1, capacity * 2)));
+            Page page;
+            page.skyline.push_back({0, 0, PAGE_SIZE});
+            pages.push_back(page);
+            layer = (int)pages.size() - 1;
+            Place(pages.back(), cellWidth, cellHeight, x, y);
+        }
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrayId);
+        // The array samples all MIP_LEVELS levels of every layer: levels the container
+        // lacks are box-filtered from the last one it has
+        std::vector<uint8_t> texels;
+        int width = 0, height = 0;
+        for (int m = 0; m < MIP_LEVELS; m++)
+        {
+            if (m < (int)container.levels.size())
+            {
+                const TextureLevel &level = container.levels[m];
+                texels = LevelToRGBA(container, level);
+                width = level.width;
+                height = level.height;
+            }
+            else
+            {
+                texels = HalveRGBA(texels, width, height, container.channels, container.srgb);
+            }
+
+            // The level plus its gutter, wrapped around like GL_REPEAT
+            const int gutter = GUTTER >> m;
+            const int paddedWidth = width + 2 * gutter, paddedHeight = height + 2 * gutter;
+            std::vector<uint8_t> padded((size_t)paddedWidth * paddedHeight * 4);
+            for (int py = 0; py < paddedHeight; py++)
+            {
+                const int sy = ((py - gutter) % height + height) % height;
+                for (int px = 0; px < paddedWidth; px++)
+                {
+                    const int sx = ((px - gutter) % width + width) % width;
+                    std::copy_n(&texels[((size_t)sy * width + sx) * 4], 4, &padded[((size_t)py * paddedWidth + px) * 4]);
+                }
+            }
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, m, x >> m, y >> m, layer, paddedWidth, paddedHeight, 1, GL_RGBA,
+                            GL_UNSIGNED_BYTE, padded.data());
+        }
+
+        rect = glm::vec4((float)(x + GUTTER), (float)(y + GUTTER), (float)container.width, (float)container.height) /
+               (float)PAGE_SIZE;
+        return true;
+    }
+
+    void TextureAtlas::Release(int layer)
+    {
+        if (layer < 0 || layer >= (int)pages.size())
+            return;
+        Page &page = pages[layer];
+        if (--page.regions > 0)
+            return;
+        // Regions are not freed one by one: an empty page starts over
+        page.skyline.assign(1, {0, 0, PAGE_SIZE});
+        page.area = 0;
+    }
+
+    void TextureAtlas::Shutdown()
+    {
+        if (arrayId != 0)
+            glDeleteTextures(1, &arrayId);
+        arrayId = 0;
+        capacity = 0;
+        pages.clear();
+    }
+
+    TextureAtlasStats TextureAtlas::Stats()
+    {
+        TextureAtlasStats stats;
+        stats.capacity = capacity;
+        stats.rejected = rejected;
+        long long area = 0;
+        for (const Page &page : pages)
+        {
+            if (page.regions == 0)
+                continue;
+            stats.layers++;
+            stats.textures += page.regions;
+            area += page.area;
+        }
+        if (stats.layers > 0)
+            stats.occupancy = (float)((double)area / ((double)stats.layers * PAGE_SIZE * PAGE_SIZE));
+        stats.bytes = (size_t)capacity * PAGE_SIZE * PAGE_SIZE * 4 * 4 / 3;
+        return stats;
+    }
+}
@@ -0,0 +1,560 @@
+#include "TextureContainer.h"
+#include "ThreadPool.h"
+#include "CacheUtil.h"
+#include "ColorSpace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTURE_CONTAINER_USE_SSE 1
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PartC
+{
+    bool TextureContainer::useTextureCache = true;
+    MipFilter TextureContainer::mipFilter = MipFilter::Kaiser;
+    BlockFormat TextureContainer::compression = BlockFormat::None;
+
+    namespace
+    {
+        const uint32_t CONTAINER_VERSION = 2;
+        const char CONTAINER_MAGIC[8] = {'T', 'E', 'X', 'M', 'I', 'P', '\0', '\0'};
+        const uint32_t FLAG_SRGB = 1;
+        const uint32_t MAX_LEVELS = 32;
+
+        // Kaiser window: radius in destination texels and shape parameter
+        const float KAISER_RADIUS = 2.0f;
+        const float KAISER_ALPHA = 4.0f;
+
+        struct ContainerHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t width, height, channels, levelCount;
+            uint32_t flags;
+            uint32_t filter;
+            uint32_t format; // BlockFormat
+            uint32_t reserved;
+            uint64_t sourceSize;
+            int64_t sourceTime;
+        };
+
+        struct LevelRecord
+        {
+            uint64_t offset; // from the start of the file
+            uint64_t bytes;
+            uint32_t width, height;
+        };
+
+        size_t Align16(size_t value) { return (value + 15) & ~(size_t)15; }
+
+        // Alpha (the last channel of 2- and 4-channel images) is coverage, not colour
+        bool IsColorChannel(int channel, int channels)
+        {
+            return !((channels == 2 || channels == 4) && channel == channels - 1);
+        }
+
+        float BesselI0(float x)
+        {
+            // Power series; converges quickly for the small arguments used here
+            float sum = 1.0f, term = 1.0f;
+            for (int k = 1; k < 20; k++)
+            {
+                float t = x / (2.0f * k);
+                term *= t * t;
+                sum += term;
+            }
+            return sum;
+        }
+
+        float Sinc(float x)
+        {
+            if (std::fabs(x) < 1e-5f)
+                return 1.0f;
+            const float pi = 3.14159265358979f;
+            return std::sin(pi * x) / (pi * x);
+        }
+
+        // Fixed-width tap lists for one axis: output i reads indices[i * taps + k] with
+        // weights[i * taps + k]; indices are clamped to the edge, unused taps weigh 0
+        struct AxisFilter
+        {
+            int taps = 0;
+            std::vector<int> indices;
+            std::vector<float> weights;
+        };
+
+        AxisFilter BuildAxisFilter(int src, int dst, MipFilter filter)
+        {
+            AxisFilter axis;
+            const float scale = (float)src / (float)dst;
+            const float support = filter == MipFilter::Box ? 0.5f * scale : KAISER_RADIUS * scale;
+            axis.taps = (int)std::ceil(2.0f * support) + 2;
+            axis.indices.assign((size_t)dst * axis.taps, 0);
+            axis.weights.assign((size_t)dst * axis.taps, 0.0f);
+
+            for (int i = 0; i < dst; i++)
+            {
+                const float center = (i + 0.5f) * scale; // continuous coordinates, texel j covers [j, j + 1]
+                const int first = (int)std::floor(center - support);
+                float sum = 0.0f;
+                for (int k = 0; k < axis.taps; k++)
+                {
+                    int j = first + k;
+                    float w;
+                    if (filter == MipFilter::Box)
+                    {
+                        // Coverage of texel j by the destination texel's footprint
+                        w = std::max(0.0f, std::min(j + 1.0f, center + support) - std::max((float)j, center - support));
+                    }
+                    else
+                    {
+                        float t = (j + 0.5f - center) / scale; // in destination texels
+                        float x = t / KAISER_RADIUS;
+                        w = std::fabs(x) < 1.0f ? Sinc(t) * BesselI0(KAISER_ALPHA * std::sqrt(1.0f - x * x)) : 0.0f;
+                    }
+                    axis.indices[(size_t)i * axis.taps + k] = std::clamp(j, 0, src - 1);
+                    axis.weights[(size_t)i * axis.taps + k] = w;
+                    sum += w;
+                }
+                for (int k = 0; k < axis.taps; k++)
+                    axis.weights[(size_t)i * axis.taps + k] /= sum;
+            }
+            return axis;
+        }
+
+#ifdef TEXTURE_CONTAINER_USE_SSE
+        // 一个 texel 的 1-4 个通道装进一个寄存器，不读越过该 texel 的末尾
+        template <int CHANNELS>
+        inline __m128 LoadTexel(const float *texel)
+        {
+            if constexpr (CHANNELS == 1)
+                return _mm_load_ss(texel);
+            else if constexpr (CHANNELS == 2)
+                return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(texel)));
+            else if constexpr (CHANNELS == 3)
+                return _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double *>(texel))), _mm_load_ss(texel + 2));
+            else
+                return _mm_loadu_ps(texel);
+        }
+
+        // Horizontal pass for one row: the taps of a destination texel are gathered from
+        // scattered source texels, which defeats auto-vectorization, so all channels of a
+        // texel accumulate in one register instead
+        template <int CHANNELS>
+        void FilterRowSse(const float *in, float *out, int dstW, const AxisFilter &horizontal)
+        {
+            for (int x = 0; x < dstW; x++)
+            {
+                const int *index = &horizontal.indices[(size_t)x * horizontal.taps];
+                const float *weight = &horizontal.weights[(size_t)x * horizontal.taps];
+                __m128 sum = _mm_setzero_ps();
+                for (int k = 0; k < horizontal.taps; k++)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[k]), LoadTexel<CHANNELS>(in + (size_t)index[k] * CHANNELS)));
+
+                if constexpr (CHANNELS == 4)
+                {
+                    _mm_storeu_ps(out + (size_t)x * 4, sum);
+                }
+                else
+                {
+                    alignas(16) float lanes[4];
+                    _mm_store_ps(lanes, sum);
+                    for (int c = 0; c < CHANNELS; c++)
+                        out[(size_t)x * CHANNELS + c] = lanes[c];
+                }
+            }
+        }
+#endif
+
+        void FilterRow(const float *in, float *out, int dstW, int channels, const AxisFilter &horizontal)
+        {
+#ifdef TEXTURE_CONTAINER_USE_SSE
+            switch (channels)
+            {
+            case 1: FilterRowSse<1>(in, out, dstW, horizontal); return;
+            case 2: FilterRowSse<2>(in, out, dstW, horizontal); return;
+            case 3: FilterRowSse<3>(in, out, dstW, horizontal); return;
+            case 4: FilterRowSse<4>(in, out, dstW, horizontal); return;
+            }
+#endif
+            for (int x = 0; x < dstW; x++)
+            {
+                const int *index = &horizontal.indices[(size_t)x * horizontal.taps];
+                const float *weight = &horizontal.weights[(size_t)x * horizontal.taps];
+                for (int k = 0; k < horizontal.taps; k++)
+                {
+                    const float *texel = in + (size_t)index[k] * channels;
+                    for (int c = 0; c < channels; c++)
+                        out[x * channels + c] += weight[k] * texel[c];
+                }
+            }
+        }
+
+        // Separable resample of a linear float image; rows run in parallel
+        void Downsample(const std::vector<float> &src, int srcW, int srcH, std::vector<float> &dst, int dstW, int dstH,
+                        int channels, MipFilter filter, std::vector<float> &scratch)
+        {
+            ThreadPool &pool = ThreadPool::Instance();
+            const AxisFilter horizontal = BuildAxisFilter(srcW, dstW, filter);
+            const AxisFilter vertical = BuildAxisFilter(srcH, dstH, filter);
+            const size_t dstRow = (size_t)dstW * channels;
+
+            // 1. Horizontal: srcH rows of dstW texels
+            scratch.assign(dstRow * srcH, 0.0f);
+            pool.ParallelFor(srcH, 16, [&](size_t begin, size_t end)
+                             {
+                for (size_t y = begin; y < end; y++)
+                    FilterRow(&src[y * srcW * channels], &scratch[y * dstRow], dstW, channels, horizontal); });
+
+            // 2. Vertical: whole rows scaled and added, contiguous floats the compiler vectorizes
+            dst.assign(dstRow * dstH, 0.0f);
+            pool.ParallelFor(dstH, 16, [&](size_t begin, size_t end)
+                             {
+                for (size_t y = begin; y < end; y++)
+                {
+                    float *out = &dst[y * dstRow];
+                    for (int k = 0; k < vertical.taps; k++)
+                    {
+                        const float w = vertical.weights[y * vertical.taps + k];
+                        if (w == 0.0f)
+                            continue;
+                        const float *in = &scratch[(size_t)vertical.indices[y * vertical.taps + k] * dstRow];
+                        for (size_t i = 0; i < dstRow; i++)
+                            out[i] += w * in[i];
+                    }
+                } });
+        }
+    }
+
+    TextureContainer::~TextureContainer()
+    {
+        if (!mapped)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(mapped);
+        CloseHandle((HANDLE)mappingHandle);
+        CloseHandle((HANDLE)fileHandle);
+#else
+        munmap(mapped, mappedSize);
+#endif
+    }
+
+    std::string TextureContainer::CachePath(const std::string &sourcePath)
+    {
+        return sourcePath + ".texcache";
+    }
+
+    std::unique_ptr<TextureContainer> TextureContainer::Build(const unsigned char *pixels, int width, int height, int channels,
+                                                              bool srgb, MipFilter filter)
+    {
+        std::unique_ptr<TextureContainer> container(new TextureContainer());
+        container->width = width;
+        container->height = height;
+        container->channels = channels;
+        container->srgb = srgb;
+        container->filter = filter;
+
+        // Level sizes and their offsets in one allocation
+        std::vector<size_t> offsets;
+        size_t total = 0;
+        for (int w = width, h = height;; w = std::max(1, w / 2), h = std::max(1, h / 2))
+        {
+            TextureLevel level;
+            level.width = w;
+            level.height = h;
+            level.bytes = (size_t)w * h * channels;
+            container->levels.push_back(level);
+            offsets.push_back(total);
+            total = Align16(total + level.bytes);
+            if (w == 1 && h == 1)
+                break;
+        }
+        container->storage.resize(total);
+        std::memcpy(container->storage.data(), pixels, container->levels[0].bytes);
+
+        // Filter in linear light
+        const SrgbTables &tables = Srgb();
+        bool color[4];
+        for (int c = 0; c < channels; c++)
+            color[c] = srgb && IsColorChannel(c, channels);
+
+        std::vector<float> current(container->levels[0].bytes), next, scratch;
+        for (size_t i = 0; i < current.size(); i += channels)
+        {
+            for (int c = 0; c < channels; c++)
+                current[i + c] = color[c] ? tables.decode[pixels[i + c]] : pixels[i + c] / 255.0f;
+        }
+
+        for (size_t l = 1; l < container->levels.size(); l++)
+        {
+            const TextureLevel &src = container->levels[l - 1];
+            const TextureLevel &dst = container->levels[l];
+            Downsample(current, src.width, src.height, next, dst.width, dst.height, channels, filter, scratch);
+
+            unsigned char *out = &container->storage[offsets[l]];
+            for (size_t i = 0; i < next.size(); i += channels)
+            {
+                for (int c = 0; c < channels; c++)
+                {
+                    // Kaiser lobes can overshoot
+                    float v = std::clamp(next[i + c], 0.0f, 1.0f);
+                    out[i + c] = color[c] ? tables.encode[(int)(v * (SrgbTables::ENCODE_SIZE - 1) + 0.5f)]
+                                          : (unsigned char)(v * 255.0f + 0.5f);
+                }
+            }
+            current.swap(next);
+        }
+
+        for (size_t l = 0; l < container->levels.size(); l++)
+            container->levels[l].data = &container->storage[offsets[l]];
+        return container;
+    }
+
+    bool TextureContainer::Save(const std::string &sourcePath) const
+    {
+        ContainerHeader header = {};
+        if (!SourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+            return false;
+        std::memcpy(header.magic, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+        header.version = CONTAINER_VERSION;
+        header.width = (uint32_t)width;
+        header.height = (uint32_t)height;
+        header.channels = (uint32_t)channels;
+        header.levelCount = (uint32_t)levels.size();
+        header.flags = srgb ? FLAG_SRGB : 0;
+        header.filter = (uint32_t)filter;
+        header.format = (uint32_t)format;
+
+        std::vector<LevelRecord> records(levels.size());
+        size_t offset = Align16(sizeof(ContainerHeader) + records.size() * sizeof(LevelRecord));
+        for (size_t l = 0; l < levels.size(); l++)
+        {
+            records[l].offset = offset;
+            records[l].bytes = levels[l].bytes;
+            records[l].width = (uint32_t)levels[l].width;
+            records[l].height = (uint32_t)levels[l].height;
+            offset = Align16(offset + levels[l].bytes);
+        }
+
+        // Read-only asset folders simply go without a container
+        std::ofstream file(CachePath(sourcePath), std::ios::binary);
+        if (!file.is_open())
+            return false;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(LevelRecord));
+        const char padding[16] = {0};
+        size_t position = sizeof(header) + records.size() * sizeof(LevelRecord);
+        for (size_t l = 0; l < levels.size(); l++)
+        {
+            file.write(padding, records[l].offset - position);
+            file.write(reinterpret_cast<const char *>(levels[l].data), levels[l].bytes);
+            position = records[l].offset + levels[l].bytes;
+        }
+        return (bool)file;
+    }
+
+    std::unique_ptr<TextureContainer> TextureContainer::Open(const std::string &sourcePath, bool srgb)
+    {
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        if (!SourceStamp(sourcePath, sourceSize, sourceTime))
+            return nullptr;
+
+        std::unique_ptr<TextureContainer> container(new TextureContainer());
+        const std::string path = CachePath(sourcePath);
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return nullptr;
+        LARGE_INTEGER size;
+        HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0
+                             ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL)
+                             : NULL;
+        void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (!view)
+        {
+            if (mapping)
+                CloseHandle(mapping);
+            CloseHandle(file);
+            return nullptr;
+        }
+        container->fileHandle = file;
+        container->mappingHandle = mapping;
+        container->mapped = view;
+        container->mappedSize = (size_t)size.QuadPart;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return nullptr;
+        struct stat info;
+        void *view = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+            view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps the file alive
+        if (view == MAP_FAILED)
+            return nullptr;
+        container->mapped = view;
+        container->mappedSize = (size_t)info.st_size;
+        // Start reading now, on the loading thread, rather than on first touch during upload
+        madvise(view, container->mappedSize, MADV_WILLNEED);
+#endif
+
+        const unsigned char *bytes = static_cast<const unsigned char *>(container->mapped);
+        ContainerHeader header;
+        if (container->mappedSize < sizeof(header))
+            return nullptr;
+        std::memcpy(&header, bytes, sizeof(header));
+        if (std::memcmp(header.magic, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) != 0 || header.version != CONTAINER_VERSION ||
+            header.sourceSize != sourceSize || header.sourceTime != sourceTime ||
+            (header.flags & FLAG_SRGB) != (srgb ? FLAG_SRGB : 0u) || header.filter != (uint32_t)mipFilter ||
+            header.channels < 1 || header.channels > 4 || header.levelCount < 1 || header.levelCount > MAX_LEVELS ||
+            header.format > (uint32_t)BlockFormat::BC7)
+            return nullptr;
+        // Precompressed assets are taken as they are; otherwise the format must be the requested one
+        const BlockFormat format = (BlockFormat)header.format;
+        if (compression != BlockFormat::None &&
+            format != CompressedFormat(compression, (int)header.width, (int)header.height, (int)header.channels))
+            return nullptr;
+
+        const size_t tableEnd = sizeof(header) + header.levelCount * sizeof(LevelRecord);
+        if (container->mappedSize < tableEnd)
+            return nullptr;
+        container->width = (int)header.width;
+        container->height = (int)header.height;
+        container->channels = (int)header.channels;
+        container->srgb = srgb;
+        container->filter = (MipFilter)header.filter;
+        container->format = format;
+        container->levels.resize(header.levelCount);
+        for (uint32_t l = 0; l < header.levelCount; l++)
+        {
+            LevelRecord record;
+            std::memcpy(&record, bytes + sizeof(header) + l * sizeof(LevelRecord), sizeof(record));
+            uint64_t expected = format == BlockFormat::None
+                                    ? (uint64_t)record.width * record.height * header.channels
+                                    : (uint64_t)BlockCompression::EncodedSize((int)record.width, (int)record.height, format);
+            if (record.bytes != expected ||
+                record.offset < tableEnd || record.offset + record.bytes > container->mappedSize)
+            {
+                std::cerr << "Warning: Corrupt texture container: " << path << std::endl;
+                return nullptr;
+            }
+            TextureLevel &level = container->levels[l];
+            level.width = (int)record.width;
+            level.height = (int)record.height;
+            level.bytes = (size_t)record.bytes;
+            level.data = bytes + record.offset;
+        }
+        return container;
+    }
+
+    BlockFormat TextureContainer::CompressedFormat(BlockFormat requested, int width, int height, int channels)
+    {
+        // Level 0 in whole blocks; smaller mips may be 1 or 2 texels wide
+        if (width % 4 != 0 || height % 4 != 0)
+            return BlockFormat::None;
+        return BlockCompression::Choose(requested, channels);
+    }
+
+    void TextureContainer::Compress(BlockFormat requested)
+    {
+        const BlockFormat target = CompressedFormat(requested, width, height, channels);
+        if (format != BlockFormat::None || target == BlockFormat::None)
+            return;
+
+        std::vector<std::vector<uint8_t>> blocks(levels.size());
+        size_t total = 0;
+        for (size_t l = 0; l < levels.size(); l++)
+        {
+            blocks[l] = BlockCompression::Encode(levels[l].data, levels[l].width, levels[l].height, channels, target);
+            total = Align16(total + blocks[l].size());
+        }
+        std::vector<uint8_t> decoded = BlockCompression::Decode(blocks[0].data(), width, height, target);
+        psnr = BlockCompression::PSNR(levels[0].data, channels, decoded.data(), width, height);
+
+        std::vector<unsigned char> compressed(total);
+        size_t offset = 0;
+        for (size_t l = 0; l < levels.size(); l++)
+        {
+            std::memcpy(&compressed[offset], blocks[l].data(), blocks[l].size());
+            levels[l].data = &compressed[offset]; // the vector's buffer survives the swap
+            levels[l].bytes = blocks[l].size();
+            offset = Align16(offset + blocks[l].size());
+        }
+        storage.swap(compressed);
+        format = target;
+    }
+
+    bool TextureContainer::Upload(unsigned int id, const TextureParams &params) const
+    {
+        GLenum pixelFormat = GL_RGB;
+        if (channels == 1)
+            pixelFormat = GL_RED;
+        else if (channels == 2)
+            pixelFormat = GL_RG;
+        else if (channels == 4)
+            pixelFormat = GL_RGBA;
+
+        glBindTexture(GL_TEXTURE_2D, id);
+        // Rows are tightly packed; small RGB levels are not 4-byte aligned
+        GLint alignment = 4;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        const int levelCount = params.UsesMipmaps() ? (int)levels.size() : 1;
+        const bool native = BlockCompression::IsSupported(format);
+        for (int l = 0; l < levelCount; l++)
+        {
+            const TextureLevel &level = levels[l];
+            if (format == BlockFormat::None)
+            {
+                glTexImage2D(GL_TEXTURE_2D, l, pixelFormat, level.width, level.height, 0, pixelFormat, GL_UNSIGNED_BYTE,
+                             level.data);
+            }
+            else if (native)
+            {
+                glCompressedTexImage2D(GL_TEXTURE_2D, l, BlockCompression::GLFormat(format), level.width, level.height, 0,
+                                       (GLsizei)level.bytes, level.data);
+            }
+            else
+            {
+                std::vector<uint8_t> rgba = BlockCompression::Decode(level.data, level.width, level.height, format);
+                glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                             rgba.data());
+            }
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, params.minFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, params.magFilter);
+        return native;
+    }
+
+    size_t TextureContainer::Bytes() const
+    {
+        size_t total = 0;
+        for (const TextureLevel &level : levels)
+            total += level.bytes;
+        return total;
+    }
+}
@@ -0,0 +1,382 @@
+#include "TextureManager.h"
+#include "TextureAtlas.h"
+#include "Renderer.h"
+#include "ThreadPool.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+namespace PartC
+{
+    size_t TextureManager::budgetBytes = (size_t)256 << 20;
+    std::unordered_map<std::string, std::shared_ptr<TextureEntry>> TextureManager::entries;
+    size_t TextureManager::cachedBytes = 0;
+    uint64_t TextureManager::useClock = 0;
+    int TextureManager::hits = 0;
+    int TextureManager::decodes = 0;
+    int TextureManager::evictions = 0;
+    std::atomic<int> TextureManager::containerLoads(0);
+    bool TextureManager::asyncDecode = true;
+    float TextureManager::uploadBudgetMs = 4.0f;
+    std::deque<TextureManager::PendingUpload> TextureManager::uploads;
+    std::mutex TextureManager::uploadMutex;
+    std::atomic<int> TextureManager::pendingDecodes(0);
+    int TextureManager::frameUploads = 0;
+    float TextureManager::frameUploadMs = 0.0f;
+    std::atomic<bool> TextureManager::shutDown(false);
+
+    TextureEntry::~TextureEntry()
+    {
+        if (TextureManager::IsShutDown())
+            return;
+        if (id != 0)
+            glDeleteTextures(1, &id);
+        if (atlasLayer >= 0)
+            TextureAtlas::Release(atlasLayer);
+    }
+
+    namespace
+    {
+        void UploadPixels(unsigned int id, const unsigned char *data, int width, int height, int nrComponents,
+                          const TextureParams &params)
+        {
+            GLenum format = GL_RGB;
+            if (nrComponents == 1)
+                format = GL_RED;
+            else if (nrComponents == 3)
+                format = GL_RGB;
+            else if (nrComponents == 4)
+                format = GL_RGBA;
+
+            glBindTexture(GL_TEXTURE_2D, id);
+            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+            if (params.UsesMipmaps())
+                glGenerateMipmap(GL_TEXTURE_2D);
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.wrap);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.wrap);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, params.minFilter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, params.magFilter);
+        }
+
+        std::shared_ptr<TextureEntry> MakeEntry(const unsigned char *data, int width, int height, int nrComponents,
+                                                const TextureParams &params)
+        {
+            auto entry = std::make_shared<TextureEntry>();
+            entry->width = width;
+            entry->height = height;
+            entry->channels = nrComponents;
+            entry->bytes = (size_t)width * height * nrComponents;
+
+            // [Headless] 没有 GL 上下文时保留 CPU 副本
+            if (Renderer::headless)
+            {
+                entry->image = std::make_shared<TextureImage>();
+                entry->image->width = width;
+                entry->image->height = height;
+                entry->image->channels = nrComponents;
+                entry->image->pixels.assign(data, data + entry->bytes);
+            }
+            else
+            {
+                glGenTextures(1, &entry->id);
+                UploadPixels(entry->id, data, width, height, nrComponents, params);
+                if (params.UsesMipmaps())
+                    entry->bytes += entry->bytes / 3; // the mip chain adds a third
+            }
+            return entry;
+        }
+
+        std::shared_ptr<TextureEntry> MakeEntry(const TextureContainer &container, const TextureParams &params)
+        {
+            auto entry = std::make_shared<TextureEntry>();
+            entry->width = container.width;
+            entry->height = container.height;
+            entry->channels = container.channels;
+            entry->bytes = params.UsesMipmaps() ? container.Bytes() : container.levels[0].bytes;
+            // [Atlas] An atlased entry owns no GL texture of its own
+            if (TextureAtlas::Insert(container, params, entry->atlasLayer, entry->atlasRect))
+                return entry;
+            glGenTextures(1, &entry->id);
+            if (!container.Upload(entry->id, params))
+                entry->blockFallback = true;
+            else
+                entry->format = container.format;
+            return entry;
+        }
+    }
+
+    std::string TextureManager::MakeKey(const std::string &path, const TextureParams &params)
+    {
+        // "a/../b.png" and "./b.png" name the same file
+        std::error_code ec;
+        std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+        std::string normalized = ec ? path : absolute.lexically_normal().string();
+        return normalized + "|" + std::to_string(params.wrap) + "|" + std::to_string(params.minFilter) + "|" +
+               std::to_string(params.magFilter) + (params.srgb ? "|srgb" : "|linear");
+    }
+
+    std::shared_ptr<TextureEntry> TextureManager::Acquire(const std::string &path, const TextureParams &params)
+    {
+        std::string key = MakeKey(path, params);
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            hits++;
+            it->second->lastUse = ++useClock;
+            return it->second;
+        }
+
+        int width, height, nrComponents;
+        std::shared_ptr<TextureEntry> entry;
+        std::shared_ptr<VirtualTexture> virtualTexture;
+        if (VirtualTexture::enabled && !Renderer::headless)
+            virtualTexture = VirtualTexture::Open(path);
+
+        if (virtualTexture)
+        {
+            // [VT] The material binds a grey placeholder; the shader samples the page cache
+            entry = std::make_shared<TextureEntry>();
+            entry->virtualTexture = virtualTexture;
+            entry->width = virtualTexture->Width();
+            entry->height = virtualTexture->Height();
+            entry->channels = 4;
+            entry->bytes = virtualTexture->Bytes();
+
+            const unsigned char grey[3] = {128, 128, 128};
+            glGenTextures(1, &entry->id);
+            UploadPixels(entry->id, grey, 1, 1, 3, params);
+        }
+        else if (asyncDecode && !Renderer::headless)
+        {
+            // [Async] Header only: a file that is missing or not an image still fails here
+            if (!stbi_info(path.c_str(), &width, &height, &nrComponents))
+                return nullptr;
+            entry = std::make_shared<TextureEntry>();
+            entry->width = width;
+            entry->height = height;
+            entry->channels = nrComponents;
+            entry->bytes = (size_t)width * height * nrComponents;
+            if (params.UsesMipmaps())
+                entry->bytes += entry->bytes / 3;
+            entry->ready = false;
+
+            const unsigned char grey[3] = {128, 128, 128};
+            glGenTextures(1, &entry->id);
+            UploadPixels(entry->id, grey, 1, 1, 3, params);
+
+            pendingDecodes++;
+            std::weak_ptr<TextureEntry> weak = entry;
+            bool srgb = params.srgb;
+            ThreadPool::Instance().EnqueueBackground([weak, path, srgb]()
+                                                     { Decode(weak, path, srgb); });
+        }
+        else if (!Renderer::headless)
+        {
+            std::shared_ptr<TextureContainer> container = LoadContainer(path, params.srgb);
+            if (!container)
+                return nullptr;
+            entry = MakeEntry(*container, params);
+            decodes++;
+        }
+        else
+        {
+            unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
+            if (!data)
+                return nullptr;
+            entry = MakeEntry(data, width, height, nrComponents, params);
+            stbi_image_free(data);
+            decodes++;
+        }
+
+        entry->key = key;
+        entry->path = path;
+        entry->params = params;
+        entry->lastUse = ++useClock;
+        entries[key] = entry;
+        cachedBytes += entry->bytes;
+        if (cachedBytes > budgetBytes)
+            Trim(budgetBytes);
+        return entry;
+    }
+
+    std::shared_ptr<TextureContainer> TextureManager::LoadContainer(const std::string &path, bool srgb)
+    {
+        if (TextureContainer::useTextureCache)
+        {
+            std::shared_ptr<TextureContainer> cached = TextureContainer::Open(path, srgb);
+            if (cached)
+            {
+                containerLoads++;
+                return cached;
+            }
+        }
+
+        int width, height, nrComponents;
+        unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
+        if (!data)
+            return nullptr;
+        std::shared_ptr<TextureContainer> container =
+            TextureContainer::Build(data, width, height, nrComponents, srgb, TextureContainer::mipFilter);
+        stbi_image_free(data);
+        container->Compress(TextureContainer::compression);
+        if (TextureContainer::useTextureCache)
+            container->Save(path);
+        return container;
+    }
+
+    void TextureManager::Decode(std::weak_ptr<TextureEntry> entry, std::string path, bool srgb)
+    {
+        // Worker thread: decoding, mip filtering and file I/O, no GL
+        PendingUpload upload = {entry, nullptr};
+        // Skip the decode if the texture was evicted while queued
+        if (!shutDown && !entry.expired())
+            upload.container = LoadContainer(path, srgb);
+
+        {
+            std::lock_guard<std::mutex> lock(uploadMutex);
+            if (!shutDown)
+                uploads.push_back(upload);
+        }
+        pendingDecodes--;
+    }
+
+    int TextureManager::ProcessUploads(float budgetMs)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        int uploaded = 0;
+        float elapsed = 0.0f;
+
+        while (elapsed < budgetMs)
+        {
+            PendingUpload upload;
+            {
+                std::lock_guard<std::mutex> lock(uploadMutex);
+                if (uploads.empty())
+                    break;
+                upload = uploads.front();
+                uploads.pop_front();
+            }
+
+            std::shared_ptr<TextureEntry> entry = upload.entry.lock();
+            if (entry)
+            {
+                entry->ready = true;
+                if (upload.container)
+                {
+                    // Same GL id as the placeholder: Texture copies holding the id see the image
+                    // [Atlas] Texture copies read the region through the shared entry as well
+                    if (!TextureAtlas::Insert(*upload.container, entry->params, entry->atlasLayer, entry->atlasRect))
+                    {
+                        if (!upload.container->Upload(entry->id, entry->params))
+                            entry->blockFallback = true;
+                        else
+                            entry->format = upload.container->format;
+                    }
+                    if (entry->params.UsesMipmaps())
+                    {
+                        // Replace the estimate made from the image header: the chain may be block-compressed
+                        cachedBytes -= entry->bytes;
+                        entry->bytes = upload.container->Bytes();
+                        cachedBytes += entry->bytes;
+                    }
+                    entry->width = upload.container->width;
+                    entry->height = upload.container->height;
+                    entry->channels = upload.container->channels;
+                    decodes++;
+                    uploaded++;
+                }
+                else
+                {
+                    std::cout << "Texture failed to decode at path: " << entry->path << std::endl;
+                }
+            }
+
+            elapsed = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        frameUploads = uploaded;
+        frameUploadMs = elapsed;
+        return uploaded;
+    }
+
+    std::shared_ptr<TextureEntry> TextureManager::Create(const unsigned char *data, int width, int height, int channels,
+                                                         const TextureParams &params)
+    {
+        return MakeEntry(data, width, height, channels, params);
+    }
+
+    int TextureManager::Trim(size_t targetBytes)
+    {
+        // use_count 1: only the cache holds the entry
+        std::vector<TextureEntry *> unused;
+        for (auto &kv : entries)
+        {
+            if (kv.second.use_count() == 1)
+                unused.push_back(kv.second.get());
+        }
+        std::sort(unused.begin(), unused.end(), [](const TextureEntry *a, const TextureEntry *b)
+                  { return a->lastUse < b->lastUse; });
+
+        int released = 0;
+        for (TextureEntry *entry : unused)
+        {
+            if (cachedBytes <= targetBytes)
+                break;
+            cachedBytes -= entry->bytes;
+            std::string key = entry->key;
+            entries.erase(key); // destroys the entry
+            released++;
+        }
+        evictions += released;
+        return released;
+    }
+
+    void TextureManager::Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(uploadMutex);
+            uploads.clear();
+        }
+        entries.clear();
+        cachedBytes = 0;
+        TextureAtlas::Shutdown();
+        shutDown = true;
+    }
+
+    TextureCacheStats TextureManager::Stats()
+    {
+        TextureCacheStats stats;
+        stats.entries = (int)entries.size();
+        for (auto &kv : entries)
+        {
+            if (kv.second.use_count() > 1)
+                stats.referenced++;
+            if (kv.second->format != BlockFormat::None)
+                stats.compressed++;
+            if (kv.second->blockFallback)
+                stats.blockFallbacks++;
+            if (kv.second->atlasLayer >= 0)
+                stats.atlased++;
+            if (kv.second->virtualTexture)
+                stats.virtualTextures++;
+        }
+        stats.bytes = cachedBytes;
+        stats.budgetBytes = budgetBytes;
+        stats.hits = hits;
+        stats.decodes = decodes;
+        stats.evictions = evictions;
+        stats.containerLoads = containerLoads.load();
+        stats.pendingDecodes = pendingDecodes.load();
+        {
+            std::lock_guard<std::mutex> lock(uploadMutex);
+            stats.pendingUploads = (int)uploads.size();
+        }
+        stats.frameUploads = frameUploads;
+        stats.frameUploadMs = frameUploadMs;
+        return stats;
+    }
+}
@@ -0,0 +1,156 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+ThreadPool::ThreadPool()
+{
+    unsigned int hw = std::thread::hardware_concurrency();
+    // Leave one core for the main (GL) thread, which also helps in ParallelFor
+    size_t workerCount = hw > 1 ? hw - 1 : 1;
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back([this]()
+                             { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (auto &t : workers)
+    {
+        if (t.joinable())
+            t.join();
+    }
+}
+
+void ThreadPool::Enqueue(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        jobs.push_back(std::move(job));
+    }
+    queueCondition.notify_one();
+}
+
+void ThreadPool::EnqueueBackground(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        backgroundJobs.push_back(std::move(job));
+    }
+    queueCondition.notify_one();
+}
+
+bool ThreadPool::RunPendingJob()
+{
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (jobs.empty())
+            return false;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+    }
+    job();
+    return true;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]()
+                                { return stopping || !jobs.empty() || !backgroundJobs.empty(); });
+            if (!jobs.empty())
+            {
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            else if (stopping)
+            {
+                return;
+            }
+            else
+            {
+                job = std::move(backgroundJobs.front());
+                backgroundJobs.pop_front();
+            }
+        }
+        job();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &func)
+{
+    if (count == 0)
+        return;
+    if (grainSize == 0)
+        grainSize = 1;
+
+    size_t chunkCount = (count + grainSize - 1) / grainSize;
+    if (chunkCount == 1 || workers.empty())
+    {
+        func(0, count);
+        return;
+    }
+
+    // Completion state lives on this stack frame: it is only touched under doneMutex, and
+    // the caller returns only after seeing remaining == 0 under it, i.e. after the last
+    // job has finished notifying and released the mutex
+    size_t remaining = chunkCount;
+    std::exception_ptr firstError; // rethrown on the calling thread once every chunk is done
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+
+    for (size_t c = 0; c < chunkCount; c++)
+    {
+        size_t begin = c * grainSize;
+        size_t end = std::min(count, begin + grainSize);
+        Enqueue([&, begin, end]()
+                {
+            // A throwing chunk still counts as finished, or the caller would wait forever
+            std::exception_ptr error;
+            try
+            {
+                func(begin, end);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (error && !firstError)
+                firstError = error;
+            if (--remaining == 0)
+                doneCondition.notify_all(); });
+    }
+
+    // Help drain the queue instead of idling; this also keeps nested calls from deadlocking
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (remaining == 0)
+            {
+                if (firstError)
+                    std::rethrow_exception(firstError);
+                return;
+            }
+        }
+        if (!RunPendingJob())
+        {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            doneCondition.wait_for(lock, std::chrono::microseconds(200), [&]()
+                                   { return remaining == 0; });
+        }
+    }
+}
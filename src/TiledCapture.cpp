@@ -0,0 +1,138 @@
+#include "TiledCapture.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+
+namespace PartC
+{
+    int TiledCapture::tileSize = 1024;
+    int TiledCapture::maxImageSize = 32768;
+
+    TiledCapture::~TiledCapture()
+    {
+        Release();
+    }
+
+    bool TiledCapture::Begin(const std::string &path, int w, int h, const glm::mat4 &projection, PngCompression level)
+    {
+        if (w <= 0 || h <= 0 || w > maxImageSize || h > maxImageSize)
+        {
+            std::cerr << "[Tiled] Unsupported image size " << w << "x" << h << std::endl;
+            return false;
+        }
+
+        GLint maxRenderbuffer = 0, maxViewport[2] = {0, 0};
+        glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxRenderbuffer);
+        glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewport);
+        tile = std::max(64, tileSize);
+        if (maxRenderbuffer > 0)
+            tile = std::min(tile, (int)maxRenderbuffer);
+        if (maxViewport[0] > 0 && maxViewport[1] > 0)
+            tile = std::min(tile, (int)std::min(maxViewport[0], maxViewport[1]));
+
+        width = w;
+        height = h;
+        columns = (width + tile - 1) / tile;
+        rows = (height + tile - 1) / tile;
+        fullProjection = projection;
+
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &colorBuffer);
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, tile, tile);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, tile, tile);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cerr << "[Tiled] Offscreen framebuffer incomplete (" << tile << "x" << tile << ")" << std::endl;
+            Release();
+            return false;
+        }
+
+        if (!writer.Open(path, width, height, level))
+        {
+            std::cerr << "[Tiled] Failed to open " << path << std::endl;
+            Release();
+            return false;
+        }
+        strip.assign((size_t)width * tile * 3, 0);
+        ok = true;
+        return true;
+    }
+
+    CaptureTile TiledCapture::Tile(int row, int column) const
+    {
+        CaptureTile result;
+        result.x = column * tile;
+        result.y = row * tile;
+        result.width = std::min(tile, width - result.x);
+        result.height = std::min(tile, height - result.y);
+
+        // Tile rectangle in the full image's NDC (y up), then the clip-space transform that
+        // maps it onto [-1, 1]: x' = sx * x + tx * w, so it commutes with the perspective divide
+        float left = -1.0f + 2.0f * result.x / width;
+        float right = -1.0f + 2.0f * (result.x + result.width) / width;
+        float top = 1.0f - 2.0f * result.y / height;
+        float bottom = 1.0f - 2.0f * (result.y + result.height) / height;
+        glm::mat4 crop(1.0f);
+        crop[0][0] = 2.0f / (right - left);
+        crop[1][1] = 2.0f / (top - bottom);
+        crop[3][0] = -(right + left) / (right - left);
+        crop[3][1] = -(top + bottom) / (top - bottom);
+        result.projection = crop * fullProjection;
+        return result;
+    }
+
+    void TiledCapture::ReadTile(const CaptureTile &tile)
+    {
+        if (!ok)
+            return;
+        // Straight into the strip at the tile's column; strip row 0 is the bottom of the
+        // row of tiles, like the tile's own rows (all tiles of a row share a height)
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glPixelStorei(GL_PACK_ROW_LENGTH, width);
+        glReadPixels(0, 0, tile.width, tile.height, GL_RGB, GL_UNSIGNED_BYTE, strip.data() + (size_t)tile.x * 3);
+        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+    bool TiledCapture::EndRow(int row)
+    {
+        if (!ok)
+            return false;
+        // PNG wants the top row first: walk the bottom-up strip backwards
+        const int stripHeight = std::min(tile, height - row * tile);
+        const ptrdiff_t stride = (ptrdiff_t)width * 3;
+        ok = writer.AppendRows(strip.data() + stride * (stripHeight - 1), stripHeight, 3, -stride);
+        return ok;
+    }
+
+    bool TiledCapture::End()
+    {
+        bool finished = ok && writer.Finish();
+        Release();
+        ok = false;
+        return finished;
+    }
+
+    void TiledCapture::Release()
+    {
+        if (fbo != 0)
+            glDeleteFramebuffers(1, &fbo);
+        if (colorBuffer != 0)
+            glDeleteRenderbuffers(1, &colorBuffer);
+        if (depthBuffer != 0)
+            glDeleteRenderbuffers(1, &depthBuffer);
+        fbo = colorBuffer = depthBuffer = 0;
+        std::vector<uint8_t>().swap(strip);
+    }
+}
@@ -0,0 +1,141 @@
+#include "VertexCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace PartC
+{
+    void VertexCodec::EncodeOctahedral(const glm::vec3 &normal, int16_t out[2])
+    {
+        // Project onto the octahedron |x| + |y| + |z| = 1, fold the lower half over the diagonals
+        float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+        if (sum <= 0.0f)
+        {
+            out[0] = out[1] = 0; // degenerate normals decode to +Z
+            return;
+        }
+        float x = normal.x / sum, y = normal.y / sum;
+        if (normal.z < 0.0f)
+        {
+            float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = fx;
+            y = fy;
+        }
+        out[0] = (int16_t)std::lround(std::clamp(x, -1.0f, 1.0f) * 32767.0f);
+        out[1] = (int16_t)std::lround(std::clamp(y, -1.0f, 1.0f) * 32767.0f);
+    }
+
+    glm::vec3 VertexCodec::DecodeOctahedral(const int16_t in[2])
+    {
+        // Same arithmetic as DecodeOctahedral in vertex.glsl
+        glm::vec3 n(std::max(in[0] / 32767.0f, -1.0f), std::max(in[1] / 32767.0f, -1.0f), 0.0f);
+        n.z = 1.0f - std::fabs(n.x) - std::fabs(n.y);
+        float t = std::max(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    uint16_t VertexCodec::FloatToHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000u;
+        uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+        if (magnitude > 0x7F800000u)
+            return (uint16_t)(sign | 0x7E00u); // NaN
+        if (magnitude >= (143u << 23))
+            return (uint16_t)(sign | 0x7C00u); // too large (or infinite)
+        if (magnitude < (113u << 23))
+            return (uint16_t)sign; // below the smallest normal half: flush to zero
+        // Rebias the exponent (127 -> 15) and round the dropped 13 mantissa bits to nearest
+        return (uint16_t)(sign | ((magnitude - (112u << 23) + (1u << 12)) >> 13));
+    }
+
+    float VertexCodec::HalfToFloat(uint16_t half)
+    {
+        uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+        uint32_t exponent = (half >> 10) & 0x1Fu;
+        uint32_t mantissa = half & 0x3FFu;
+        if (exponent == 0)
+        {
+            float value = std::ldexp((float)mantissa, -24);
+            return sign ? -value : value;
+        }
+        uint32_t bits = exponent == 31 ? (sign | 0x7F800000u | (mantissa << 13))
+                                       : (sign | ((exponent + 112u) << 23) | (mantissa << 13));
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    bool VertexCodec::CanUseHalfTexCoords(const std::vector<Vertex> &vertices)
+    {
+        for (const Vertex &v : vertices)
+        {
+            if (!(std::fabs(v.TexCoords.x) <= HALF_UV_LIMIT && std::fabs(v.TexCoords.y) <= HALF_UV_LIMIT))
+                return false;
+        }
+        return true;
+    }
+
+    std::vector<uint8_t> VertexCodec::Encode(const std::vector<Vertex> &vertices, bool halfTexCoords)
+    {
+        const size_t stride = Stride(halfTexCoords);
+        std::vector<uint8_t> packed(vertices.size() * stride);
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            uint8_t *dst = &packed[i * stride];
+            std::memcpy(dst, &vertices[i].Position, sizeof(float) * 3);
+
+            int16_t normal[2];
+            EncodeOctahedral(vertices[i].Normal, normal);
+            std::memcpy(dst + NORMAL_OFFSET, normal, sizeof(normal));
+
+            if (halfTexCoords)
+            {
+                uint16_t uv[2] = {FloatToHalf(vertices[i].TexCoords.x), FloatToHalf(vertices[i].TexCoords.y)};
+                std::memcpy(dst + TEXCOORD_OFFSET, uv, sizeof(uv));
+            }
+            else
+            {
+                std::memcpy(dst + TEXCOORD_OFFSET, &vertices[i].TexCoords, sizeof(float) * 2);
+            }
+        }
+        return packed;
+    }
+
+    std::vector<Vertex> VertexCodec::Decode(const std::vector<uint8_t> &packed, bool halfTexCoords)
+    {
+        const size_t stride = Stride(halfTexCoords);
+        std::vector<Vertex> vertices(packed.size() / stride);
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const uint8_t *src = &packed[i * stride];
+            std::memcpy(&vertices[i].Position, src, sizeof(float) * 3);
+
+            int16_t normal[2];
+            std::memcpy(normal, src + NORMAL_OFFSET, sizeof(normal));
+            vertices[i].Normal = DecodeOctahedral(normal);
+
+            if (halfTexCoords)
+            {
+                uint16_t uv[2];
+                std::memcpy(uv, src + TEXCOORD_OFFSET, sizeof(uv));
+                vertices[i].TexCoords = glm::vec2(HalfToFloat(uv[0]), HalfToFloat(uv[1]));
+            }
+            else
+            {
+                std::memcpy(&vertices[i].TexCoords, src + TEXCOORD_OFFSET, sizeof(float) * 2);
+            }
+        }
+        return vertices;
+    }
+
+    std::vector<uint16_t> VertexCodec::EncodeShortIndices(const std::vector<unsigned int> &indices)
+    {
+        return std::vector<uint16_t>(indices.begin(), indices.end());
+    }
+}
@@ -0,0 +1,695 @@
+#include "VirtualTexture.h"
+#include "TextureManager.h"
+#include "ThreadPool.h"
+#include "CacheUtil.h"
+#include "ColorSpace.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include <glad/glad.h>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace PartC
+{
+    float VirtualTextureFeedback::lodBias = 0.0f;
+    int VirtualTextureFeedback::maxPagesPerTriangle = 16;
+
+    bool VirtualTexture::enabled = true;
+    int VirtualTexture::cacheSlotsPerRow = 16;
+    int VirtualTexture::uploadsPerFrame = 16;
+    int VirtualTexture::loadsInFlight = 32;
+    std::vector<std::weak_ptr<VirtualTexture>> VirtualTexture::instances;
+
+    namespace
+    {
+        const uint32_t VTEX_VERSION = 1;
+        const char VTEX_MAGIC[8] = {'V', 'I', 'R', 'T', 'E', 'X', '\0', '\0'};
+        const uint32_t FLAG_SRGB = 1;
+        const size_t DATA_OFFSET = 64; // tiles start here
+        const int MAX_TILES = 4096;    // per axis at level 0, see VirtualPage::Key
+
+        struct VirtualHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t width, height, levelCount;
+            uint32_t tileSize, border;
+            uint32_t flags;
+            uint32_t reserved;
+            uint64_t sourceSize;
+            int64_t sourceTime;
+        };
+        static_assert(sizeof(VirtualHeader) <= DATA_OFFSET, "header overlaps the tiles");
+
+        int TileCount(int texels) { return (texels + VirtualTextureFile::TILE_SIZE - 1) / VirtualTextureFile::TILE_SIZE; }
+
+        int LevelCount(int tilesX, int tilesY)
+        {
+            int levels = 1;
+            while ((std::max(tilesX, tilesY) + (1 << (levels - 1)) - 1) >> (levels - 1) > 1)
+                levels++;
+            return levels;
+        }
+
+        // Channels mapped the way GL expands RED / RG / RGB
+        std::vector<uint8_t> ToRGBA(const unsigned char *pixels, int width, int height, int channels)
+        {
+            const size_t count = (size_t)width * height;
+            std::vector<uint8_t> rgba(count * 4);
+            for (size_t i = 0; i < count; i++)
+            {
+                const unsigned char *src = pixels + i * channels;
+                uint8_t *dst = &rgba[i * 4];
+                dst[0] = src[0];
+                dst[1] = channels > 1 ? src[1] : 0;
+                dst[2] = channels > 2 ? src[2] : 0;
+                dst[3] = channels > 3 ? src[3] : 255;
+            }
+            return rgba;
+        }
+
+        // Next level, ceil(width / 2) x ceil(height / 2): 2x2 average in linear light
+        // (alpha stays linear); odd edges repeat the last row / column
+        std::vector<uint8_t> Halve(const std::vector<uint8_t> &level, int width, int height, bool srgb)
+        {
+            const int halfWidth = (width + 1) / 2, halfHeight = (height + 1) / 2;
+            std::vector<uint8_t> half((size_t)halfWidth * halfHeight * 4);
+            const SrgbTables &tables = Srgb();
+            ThreadPool::Instance().ParallelFor(halfHeight, 16, [&](size_t begin, size_t end)
+            {
+                for (size_t y = begin; y < end; y++)
+                {
+                    const int y0 = (int)y * 2, y1 = std::min(y0 + 1, height - 1);
+                    for (int x = 0; x < halfWidth; x++)
+                    {
+                        const int x0 = x * 2, x1 = std::min(x0 + 1, width - 1);
+                        const uint8_t *taps[4] = {&level[((size_t)y0 * width + x0) * 4], &level[((size_t)y0 * width + x1) * 4],
+                                                  &level[((size_t)y1 * width + x0) * 4], &level[((size_t)y1 * width + x1) * 4]};
+                        uint8_t *dst = &half[((size_t)y * halfWidth + x) * 4];
+                        for (int c = 0; c < 4; c++)
+                        {
+                            if (srgb && c < 3)
+                            {
+                                float sum = 0.0f;
+                                for (const uint8_t *tap : taps)
+                                    sum += tables.decode[tap[c]];
+                                dst[c] = tables.encode[(int)(sum * 0.25f * (SrgbTables::ENCODE_SIZE - 1) + 0.5f)];
+                            }
+                            else
+                            {
+                                dst[c] = (uint8_t)((taps[0][c] + taps[1][c] + taps[2][c] + taps[3][c] + 2) / 4);
+                            }
+                        }
+                    }
+                }
+            });
+            return half;
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    // VirtualTextureFile
+
+    std::string VirtualTextureFile::PathFor(const std::string &sourcePath)
+    {
+        return sourcePath + ".vtex";
+    }
+
+    int VirtualTextureFile::TilesX(int level) const
+    {
+        return std::max(1, (TileCount(width) + (1 << level) - 1) >> level);
+    }
+
+    int VirtualTextureFile::TilesY(int level) const
+    {
+        return std::max(1, (TileCount(height) + (1 << level) - 1) >> level);
+    }
+
+    bool VirtualTextureFile::Build(const unsigned char *pixels, int width, int height, int channels, bool srgb,
+                                   const std::string &sourcePath)
+    {
+        if (width <= 0 || height <= 0 || channels < 1 || channels > 4 || TileCount(width) > MAX_TILES ||
+            TileCount(height) > MAX_TILES)
+            return false;
+
+        VirtualHeader header = {};
+        if (!SourceStamp(sourcePath, header.sourceSize, header.sourceTime))
+            return false;
+        std::memcpy(header.magic, VTEX_MAGIC, sizeof(VTEX_MAGIC));
+        header.version = VTEX_VERSION;
+        header.width = (uint32_t)width;
+        header.height = (uint32_t)height;
+        header.levelCount = (uint32_t)LevelCount(TileCount(width), TileCount(height));
+        header.tileSize = TILE_SIZE;
+        header.border = BORDER;
+        header.flags = srgb ? FLAG_SRGB : 0;
+
+        std::ofstream out(PathFor(sourcePath), std::ios::binary);
+        if (!out.is_open())
+            return false;
+        const char padding[DATA_OFFSET] = {0};
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(padding, DATA_OFFSET - sizeof(header));
+
+        // Only one level is held at a time, next to the source
+        std::vector<uint8_t> level = ToRGBA(pixels, width, height, channels);
+        std::vector<uint8_t> tile(TILE_BYTES);
+        int levelWidth = width, levelHeight = height;
+        for (uint32_t l = 0; l < header.levelCount; l++)
+        {
+            const int tilesX = TileCount(levelWidth), tilesY = TileCount(levelHeight);
+            for (int ty = 0; ty < tilesY; ty++)
+            {
+                for (int tx = 0; tx < tilesX; tx++)
+                {
+                    for (int py = 0; py < PADDED_SIZE; py++)
+                    {
+                        const int sy = std::clamp(ty * TILE_SIZE + py - BORDER, 0, levelHeight - 1);
+                        for (int px = 0; px < PADDED_SIZE; px++)
+                        {
+                            const int sx = std::clamp(tx * TILE_SIZE + px - BORDER, 0, levelWidth - 1);
+                            std::memcpy(&tile[((size_t)py * PADDED_SIZE + px) * 4], &level[((size_t)sy * levelWidth + sx) * 4], 4);
+                        }
+                    }
+                    out.write(reinterpret_cast<const char *>(tile.data()), tile.size());
+                }
+            }
+            if (l + 1 < header.levelCount)
+            {
+                level = Halve(level, levelWidth, levelHeight, srgb);
+                levelWidth = (levelWidth + 1) / 2;
+                levelHeight = (levelHeight + 1) / 2;
+            }
+        }
+        return (bool)out;
+    }
+
+    std::unique_ptr<VirtualTextureFile> VirtualTextureFile::Open(const std::string &sourcePath)
+    {
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        if (!SourceStamp(sourcePath, sourceSize, sourceTime))
+            return nullptr;
+        const std::string path = PathFor(sourcePath);
+        std::error_code error;
+        const uint64_t fileSize = (uint64_t)std::filesystem::file_size(path, error);
+        if (error)
+            return nullptr;
+
+        std::unique_ptr<VirtualTextureFile> file(new VirtualTextureFile());
+        file->file.open(path, std::ios::binary);
+        VirtualHeader header;
+        if (!file->file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+            return nullptr;
+        if (std::memcmp(header.magic, VTEX_MAGIC, sizeof(VTEX_MAGIC)) != 0 || header.version != VTEX_VERSION ||
+            header.tileSize != (uint32_t)TILE_SIZE || header.border != (uint32_t)BORDER || header.width == 0 ||
+            header.height == 0 || TileCount((int)header.width) > MAX_TILES || TileCount((int)header.height) > MAX_TILES)
+            return nullptr;
+        if (header.sourceSize != sourceSize || header.sourceTime != sourceTime)
+        {
+            std::cerr << "[VT] " << path << " is older than its image, rebuild it with TextureConvert --virtual" << std::endl;
+            return nullptr;
+        }
+
+        file->width = (int)header.width;
+        file->height = (int)header.height;
+        file->levels = LevelCount(TileCount(file->width), TileCount(file->height));
+        if ((int)header.levelCount != file->levels)
+            return nullptr;
+        uint64_t tiles = 0;
+        for (int l = 0; l < file->levels; l++)
+        {
+            file->levelOffsets.push_back(tiles);
+            tiles += (uint64_t)file->TilesX(l) * file->TilesY(l);
+        }
+        if (fileSize < DATA_OFFSET + tiles * TILE_BYTES)
+            return nullptr;
+        return file;
+    }
+
+    bool VirtualTextureFile::ReadTile(const VirtualPage &page, std::vector<uint8_t> &texels)
+    {
+        if (page.level < 0 || page.level >= levels || page.x < 0 || page.x >= TilesX(page.level) || page.y < 0 ||
+            page.y >= TilesY(page.level))
+            return false;
+        const uint64_t tile = levelOffsets[page.level] + (uint64_t)page.y * TilesX(page.level) + page.x;
+        texels.resize(TILE_BYTES);
+        std::lock_guard<std::mutex> lock(fileMutex);
+        file.clear();
+        file.seekg((std::streamoff)(DATA_OFFSET + tile * TILE_BYTES));
+        return (bool)file.read(reinterpret_cast<char *>(texels.data()), TILE_BYTES);
+    }
+
+    // ------------------------------------------------------------------------
+    // VirtualTextureCache
+
+    VirtualTextureCache::VirtualTextureCache(int tilesX, int tilesY, int levels, int slotsPerRow)
+        : tilesX(tilesX), tilesY(tilesY), levels(levels), slotsPerRow(std::clamp(slotsPerRow, 1, 255)),
+          slots((size_t)this->slotsPerRow * this->slotsPerRow)
+    {
+    }
+
+    void VirtualTextureCache::BeginFrame()
+    {
+        frame++;
+        requested.clear();
+        Request({levels - 1, 0, 0});
+    }
+
+    void VirtualTextureCache::Request(const VirtualPage &page)
+    {
+        if (page.level < 0 || page.level >= levels || page.x < 0 || page.x >= TilesX(page.level) || page.y < 0 ||
+            page.y >= TilesY(page.level))
+            return;
+        VirtualPage current = page;
+        while (true)
+        {
+            auto inserted = requested.emplace(current.Key(), 0);
+            inserted.first->second++;
+            if (!inserted.second)
+                break; // its parents were requested along with it
+            auto it = resident.find(current.Key());
+            if (it != resident.end())
+                slots[it->second].lastRequest = frame;
+            if (current.level == levels - 1)
+                break;
+            current = {current.level + 1, current.x >> 1, current.y >> 1};
+        }
+    }
+
+    std::vector<VirtualPage> VirtualTextureCache::SelectLoads(int maxCount)
+    {
+        struct Candidate
+        {
+            VirtualPage page;
+            int gap; // levels between the page and the page shown instead
+        };
+        std::vector<Candidate> candidates;
+        for (const auto &kv : requested)
+        {
+            if (resident.count(kv.first) || loading.count(kv.first))
+                continue;
+            Candidate candidate = {VirtualPage::FromKey(kv.first), 0};
+            int fallback = candidate.page.level + 1;
+            while (fallback < levels &&
+                   !resident.count(VirtualPage{fallback, candidate.page.x >> (fallback - candidate.page.level),
+                                               candidate.page.y >> (fallback - candidate.page.level)}
+                                       .Key()))
+                fallback++;
+            candidate.gap = fallback - candidate.page.level;
+            candidates.push_back(candidate);
+        }
+
+        const size_t count = std::min(candidates.size(), (size_t)std::max(0, maxCount));
+        std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                          [](const Candidate &a, const Candidate &b)
+                          {
+                              if (a.page.level != b.page.level)
+                                  return a.page.level > b.page.level;
+                              if (a.gap != b.gap)
+                                  return a.gap > b.gap;
+                              return a.page.Key() < b.page.Key();
+                          });
+
+        std::vector<VirtualPage> loads;
+        for (size_t i = 0; i < count; i++)
+        {
+            loading.insert(candidates[i].page.Key());
+            loads.push_back(candidates[i].page);
+        }
+        return loads;
+    }
+
+    int VirtualTextureCache::Insert(const VirtualPage &page)
+    {
+        const uint32_t key = page.Key();
+        loading.erase(key);
+        auto it = resident.find(key);
+        if (it != resident.end())
+            return it->second;
+
+        // A free slot, else the least recently requested page not wanted this frame
+        int chosen = -1;
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            if (!slots[i].used)
+            {
+                chosen = (int)i;
+                break;
+            }
+            if (slots[i].lastRequest < frame && (chosen < 0 || slots[i].lastRequest < slots[chosen].lastRequest))
+                chosen = (int)i;
+        }
+        if (chosen < 0)
+        {
+            dropped++;
+            return -1;
+        }
+
+        Slot &slot = slots[chosen];
+        if (slot.used)
+        {
+            resident.erase(slot.key);
+            evictions++;
+        }
+        slot.key = key;
+        slot.used = true;
+        slot.lastRequest = frame;
+        resident[key] = chosen;
+        indirectionDirty = true;
+        return chosen;
+    }
+
+    void VirtualTextureCache::Cancel(const VirtualPage &page)
+    {
+        loading.erase(page.Key());
+    }
+
+    int VirtualTextureCache::SlotOf(const VirtualPage &page) const
+    {
+        auto it = resident.find(page.Key());
+        return it != resident.end() ? it->second : -1;
+    }
+
+    int VirtualTextureCache::ResidentLevel(int x, int y) const
+    {
+        for (int l = 0; l < levels; l++)
+        {
+            if (resident.count(VirtualPage{l, x >> l, y >> l}.Key()))
+                return l;
+        }
+        return -1;
+    }
+
+    bool VirtualTextureCache::UpdateIndirection(std::vector<uint8_t> &rgba)
+    {
+        const size_t size = (size_t)tilesX * tilesY * 4;
+        if (!indirectionDirty && rgba.size() == size)
+            return false;
+        rgba.assign(size, 0);
+
+        // Coarse pages first, finer ones overwrite the tiles they cover
+        std::vector<std::pair<VirtualPage, int>> pages;
+        pages.reserve(resident.size());
+        for (const auto &kv : resident)
+            pages.push_back({VirtualPage::FromKey(kv.first), kv.second});
+        std::sort(pages.begin(), pages.end(), [](const std::pair<VirtualPage, int> &a, const std::pair<VirtualPage, int> &b)
+                  { return a.first.level > b.first.level; });
+
+        for (const auto &entry : pages)
+        {
+            const VirtualPage &page = entry.first;
+            const int x0 = page.x << page.level, y0 = page.y << page.level;
+            const int x1 = std::min(tilesX, (page.x + 1) << page.level);
+            const int y1 = std::min(tilesY, (page.y + 1) << page.level);
+            const uint8_t texel[4] = {(uint8_t)(entry.second % slotsPerRow), (uint8_t)(entry.second / slotsPerRow),
+                                      (uint8_t)page.level, 255};
+            for (int y = y0; y < y1; y++)
+            {
+                for (int x = x0; x < x1; x++)
+                    std::memcpy(&rgba[((size_t)y * tilesX + x) * 4], texel, 4);
+            }
+        }
+        indirectionDirty = false;
+        return true;
+    }
+
+    VirtualTextureStats VirtualTextureCache::Stats() const
+    {
+        VirtualTextureStats stats;
+        stats.requested = (int)requested.size();
+        stats.resident = (int)resident.size();
+        stats.loading = (int)loading.size();
+        for (const auto &kv : requested)
+        {
+            if (!resident.count(kv.first))
+                stats.missing++;
+        }
+        stats.slots = (int)slots.size();
+        stats.evictions = evictions;
+        stats.dropped = dropped;
+        return stats;
+    }
+
+    // ------------------------------------------------------------------------
+    // VirtualTextureFeedback
+
+    void VirtualTextureFeedback::Accumulate(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                            const glm::mat4 &modelViewProjection, const glm::vec2 &viewport, int width,
+                                            int height, VirtualTextureCache &cache)
+    {
+        const float texels = (float)width * (float)height;
+        const float tileTexels = (float)VirtualTextureFile::TILE_SIZE;
+        const int lastLevel = cache.Levels() - 1;
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            glm::vec4 clip[3];
+            glm::vec2 uv[3];
+            for (int k = 0; k < 3; k++)
+            {
+                const Vertex &vertex = vertices[indices[i + k]];
+                clip[k] = modelViewProjection * glm::vec4(vertex.Position, 1.0f);
+                uv[k] = glm::clamp(vertex.TexCoords, glm::vec2(0.0f), glm::vec2(1.0f));
+            }
+
+            // Outside if all three vertices are beyond the same clip plane
+            bool outside = false;
+            for (int axis = 0; axis < 3 && !outside; axis++)
+            {
+                bool allBelow = true, allAbove = true;
+                for (int k = 0; k < 3; k++)
+                {
+                    allBelow = allBelow && clip[k][axis] < -clip[k].w;
+                    allAbove = allAbove && clip[k][axis] > clip[k].w;
+                }
+                outside = allBelow || allAbove;
+            }
+            if (outside)
+                continue;
+
+            int level = 0;
+            const bool crossesNear = clip[0].z < -clip[0].w || clip[1].z < -clip[1].w || clip[2].z < -clip[2].w;
+            if (!crossesNear)
+            {
+                glm::vec2 screen[3];
+                for (int k = 0; k < 3; k++)
+                    screen[k] = (glm::vec2(clip[k]) / clip[k].w * 0.5f + 0.5f) * viewport;
+                const glm::vec2 e1 = screen[1] - screen[0], e2 = screen[2] - screen[0];
+                const glm::vec2 t1 = uv[1] - uv[0], t2 = uv[2] - uv[0];
+                const float pixelArea = std::max(0.5f * std::fabs(e1.x * e2.y - e1.y * e2.x), 1.0f);
+                const float texelArea = 0.5f * std::fabs(t1.x * t2.y - t1.y * t2.x) * texels;
+                if (texelArea > 0.0f)
+                    level = (int)std::floor(0.5f * std::log2(texelArea / pixelArea) + lodBias);
+                level = std::clamp(level, 0, lastLevel);
+            }
+
+            const glm::vec2 uvMin = glm::min(uv[0], glm::min(uv[1], uv[2]));
+            const glm::vec2 uvMax = glm::max(uv[0], glm::max(uv[1], uv[2]));
+            int x0, y0, x1, y1;
+            while (true)
+            {
+                const float scale = tileTexels * (float)(1 << level);
+                x0 = std::min((int)(uvMin.x * width / scale), cache.TilesX(level) - 1);
+                x1 = std::min((int)(uvMax.x * width / scale), cache.TilesX(level) - 1);
+                y0 = std::min((int)(uvMin.y * height / scale), cache.TilesY(level) - 1);
+                y1 = std::min((int)(uvMax.y * height / scale), cache.TilesY(level) - 1);
+                if (level == lastLevel || (x1 - x0 + 1) * (y1 - y0 + 1) <= maxPagesPerTriangle)
+                    break;
+                level++;
+            }
+            for (int y = y0; y <= y1; y++)
+            {
+                for (int x = x0; x <= x1; x++)
+                    cache.Request({level, x, y});
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    // VirtualTexture
+
+    VirtualTexture::VirtualTexture(std::unique_ptr<VirtualTextureFile> file, int slotsPerRow)
+        : file(std::move(file)),
+          cache(this->file->TilesX(0), this->file->TilesY(0), this->file->levels, slotsPerRow),
+          queue(std::make_shared<LoadQueue>())
+    {
+    }
+
+    VirtualTexture::~VirtualTexture()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->closed = true;
+            queue->tiles.clear();
+        }
+        if (TextureManager::IsShutDown())
+            return;
+        if (cacheId != 0)
+            glDeleteTextures(1, &cacheId);
+        if (indirectionId != 0)
+            glDeleteTextures(1, &indirectionId);
+    }
+
+    std::shared_ptr<VirtualTexture> VirtualTexture::Open(const std::string &sourcePath)
+    {
+        std::unique_ptr<VirtualTextureFile> file = VirtualTextureFile::Open(sourcePath);
+        if (!file)
+            return nullptr;
+
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        const int slotsPerRow =
+            std::clamp(std::min(cacheSlotsPerRow, (int)maxSize / VirtualTextureFile::PADDED_SIZE), 1, 255);
+        std::shared_ptr<VirtualTexture> texture(new VirtualTexture(std::move(file), slotsPerRow));
+
+        const int cacheSize = slotsPerRow * VirtualTextureFile::PADDED_SIZE;
+        glGenTextures(1, &texture->cacheId);
+        glBindTexture(GL_TEXTURE_2D, texture->cacheId);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cacheSize, cacheSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // One texel per level-0 tile, fetched with texelFetch
+        texture->cache.UpdateIndirection(texture->indirection);
+        glGenTextures(1, &texture->indirectionId);
+        glBindTexture(GL_TEXTURE_2D, texture->indirectionId);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture->cache.TilesX(0), texture->cache.TilesY(0), 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, texture->indirection.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        instances.push_back(texture);
+        return texture;
+    }
+
+    void VirtualTexture::BeginFrameAll()
+    {
+        instances.erase(std::remove_if(instances.begin(), instances.end(),
+                                       [](const std::weak_ptr<VirtualTexture> &weak) { return weak.expired(); }),
+                        instances.end());
+        for (const std::weak_ptr<VirtualTexture> &weak : instances)
+        {
+            if (std::shared_ptr<VirtualTexture> texture = weak.lock())
+                texture->cache.BeginFrame();
+        }
+    }
+
+    void VirtualTexture::UpdateAll()
+    {
+        for (const std::weak_ptr<VirtualTexture> &weak : instances)
+        {
+            if (std::shared_ptr<VirtualTexture> texture = weak.lock())
+                texture->Update();
+        }
+    }
+
+    void VirtualTexture::AddFeedback(const Mesh &mesh, const glm::mat4 &modelViewProjection, const glm::vec2 &viewport)
+    {
+        VirtualTextureFeedback::Accumulate(mesh.vertices, mesh.indices, modelViewProjection, viewport, file->width,
+                                           file->height, cache);
+    }
+
+    void VirtualTexture::Update()
+    {
+        // Tiles read since the last frame go into slots first: their slots may be
+        // taken from pages this frame's feedback no longer wants
+        const int slotsPerRow = cache.SlotsPerRow();
+        glActiveTexture(GL_TEXTURE0 + CACHE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, cacheId);
+        for (int uploaded = 0; uploaded < uploadsPerFrame;)
+        {
+            LoadedTile tile;
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                if (queue->tiles.empty())
+                    break;
+                tile = std::move(queue->tiles.front());
+                queue->tiles.pop_front();
+            }
+            if (tile.texels.empty())
+            {
+                cache.Cancel(tile.page);
+                continue;
+            }
+            const int slot = cache.Insert(tile.page);
+            if (slot < 0)
+                continue;
+            // Rows of PADDED_SIZE RGBA8 texels are 4-byte aligned
+            glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % slotsPerRow) * VirtualTextureFile::PADDED_SIZE,
+                            (slot / slotsPerRow) * VirtualTextureFile::PADDED_SIZE, VirtualTextureFile::PADDED_SIZE,
+                            VirtualTextureFile::PADDED_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, tile.texels.data());
+            uploaded++;
+        }
+
+        const int reads = loadsInFlight - (int)cache.LoadingCount();
+        for (const VirtualPage &page : cache.SelectLoads(reads))
+        {
+            std::shared_ptr<VirtualTextureFile> source = file;
+            std::shared_ptr<LoadQueue> target = queue;
+            ThreadPool::Instance().EnqueueBackground([source, target, page]()
+            {
+                LoadedTile tile;
+                tile.page = page;
+                if (!source->ReadTile(page, tile.texels))
+                    tile.texels.clear();
+                std::lock_guard<std::mutex> lock(target->mutex);
+                if (!target->closed)
+                    target->tiles.push_back(std::move(tile));
+            });
+        }
+
+        if (cache.UpdateIndirection(indirection))
+        {
+            glBindTexture(GL_TEXTURE_2D, indirectionId);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cache.TilesX(0), cache.TilesY(0), GL_RGBA, GL_UNSIGNED_BYTE,
+                            indirection.data());
+        }
+    }
+
+    void VirtualTexture::Bind(Shader &shader) const
+    {
+        glActiveTexture(GL_TEXTURE0 + CACHE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, cacheId);
+        glActiveTexture(GL_TEXTURE0 + INDIRECTION_UNIT);
+        glBindTexture(GL_TEXTURE_2D, indirectionId);
+        shader.setVec4(shader.standard.vtSize, glm::vec4((float)file->width, (float)file->height,
+                                                         (float)VirtualTextureFile::TILE_SIZE,
+                                                         (float)VirtualTextureFile::BORDER));
+        shader.setFloat(shader.standard.vtSlots, (float)cache.SlotsPerRow());
+    }
+
+    size_t VirtualTexture::Bytes() const
+    {
+        const size_t cacheSize = (size_t)cache.SlotsPerRow() * VirtualTextureFile::PADDED_SIZE;
+        return cacheSize * cacheSize * 4 + (size_t)cache.TilesX(0) * cache.TilesY(0) * 4;
+    }
+
+    VirtualTextureStats VirtualTexture::TotalStats()
+    {
+        VirtualTextureStats total;
+        for (const std::weak_ptr<VirtualTexture> &weak : instances)
+        {
+            std::shared_ptr<VirtualTexture> texture = weak.lock();
+            if (!texture)
+                continue;
+            VirtualTextureStats stats = texture->Stats();
+            total.requested += stats.requested;
+            total.resident += stats.resident;
+            total.loading += stats.loading;
+            total.missing += stats.missing;
+            total.slots += stats.slots;
+            total.evictions += stats.evictions;
+            total.dropped += stats.dropped;
+        }
+        return total;
+    }
+}
@@ -24,6 +24,12 @@ void MeshColliderComponent::Start()
     }
 }
 
+void MeshColliderComponent::SetMesh(std::shared_ptr<Mesh> mesh)
+{
+    sharedMesh = mesh;
+    RecalculateBounds();
+}
+
 void MeshColliderComponent::RecalculateBounds()
 {
     if (!sharedMesh || sharedMesh->vertices.empty())
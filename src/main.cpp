@@ -1,13 +1,59 @@
 #include "Application.h"
 #include <iostream>
+#include <cstdlib>
+#include <string>
 
-int main()
+static void PrintUsage(const char *exe)
 {
+    std::cout << "Usage: " << exe << " [--headless] [--scene file.scn] [--output image.bmp]\n"
+              << "       [--width W] [--height H] [--frames N] [--timing report.json] [--image-bench]\n"
+              << "  --headless     render without a window or GPU (software rasterizer)\n"
+              << "  --image-bench  also write the frame as BMP, fast PNG and default PNG and report MB/s"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    // [Headless] 命令行参数：CI / 批量渲染时不创建窗口
+    bool headless = false;
+    int width = 1280, height = 720;
+    HeadlessOptions options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--headless")
+            headless = true;
+        else if (arg == "--scene" && hasValue)
+            options.scenePath = argv[++i];
+        else if (arg == "--output" && hasValue)
+            options.outputPath = argv[++i];
+        else if (arg == "--timing" && hasValue)
+            options.timingPath = argv[++i];
+        else if (arg == "--width" && hasValue)
+            width = std::atoi(argv[++i]);
+        else if (arg == "--height" && hasValue)
+            height = std::atoi(argv[++i]);
+        else if (arg == "--frames" && hasValue)
+            options.frames = std::atoi(argv[++i]);
+        else if (arg == "--image-bench")
+            options.imageBench = true;
+        else
+        {
+            PrintUsage(argv[0]);
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+
     // 实例化 Part A 的核心应用对象
-    Application app("Graphics Engine Group Project", 1280, 720);
+    Application app("Graphics Engine Group Project", width, height);
 
     try
     {
+        if (headless)
+            return app.RunHeadless(options);
+
         // 启动引擎
         app.Run();
     }
@@ -18,4 +64,4 @@ int main()
     }
 
     return 0;
-}
\ No newline at end of file
+}
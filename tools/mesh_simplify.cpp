@@ -0,0 +1,77 @@
+#include "ModelLoader.h"
+#include "MeshSimplifier.h"
+#include "Renderer.h"
+#include <iostream>
+#include <cstdlib>
+#include <string>
+
+static void PrintUsage(const char *exe)
+{
+    std::cout << "Usage: " << exe << " input.obj output.obj [--ratio R | --triangles N] [--error E]\n"
+              << "       [--normal-weight W] [--uv-weight W] [--no-seams]\n"
+              << "  --ratio      fraction of the triangles to keep (default 0.5)\n"
+              << "  --error      stop early at this error, as a fraction of the model size\n"
+              << "  --no-seams   weld by position only (normals / UVs may smear across seams)" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    // [QEM] 离线网格简化工具：不创建窗口，Mesh 只保留 CPU 数据
+    std::string inputPath, outputPath;
+    float ratio = 0.5f;
+    long long triangles = 0;
+    PartC::SimplifyOptions options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--ratio" && hasValue)
+            ratio = (float)std::atof(argv[++i]);
+        else if (arg == "--triangles" && hasValue)
+            triangles = std::atoll(argv[++i]);
+        else if (arg == "--error" && hasValue)
+            options.maxError = (float)std::atof(argv[++i]);
+        else if (arg == "--normal-weight" && hasValue)
+            options.normalWeight = (float)std::atof(argv[++i]);
+        else if (arg == "--uv-weight" && hasValue)
+            options.uvWeight = (float)std::atof(argv[++i]);
+        else if (arg == "--no-seams")
+            options.preserveSeams = false;
+        else if (arg[0] != '-' && inputPath.empty())
+            inputPath = arg;
+        else if (arg[0] != '-' && outputPath.empty())
+            outputPath = arg;
+        else
+        {
+            PrintUsage(argv[0]);
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+    if (inputPath.empty() || outputPath.empty() || ratio <= 0.0f || ratio > 1.0f || triangles < 0)
+    {
+        PrintUsage(argv[0]);
+        return -1;
+    }
+
+    PartC::Renderer::headless = true;
+    Mesh *mesh = ModelLoader::LoadMesh(inputPath);
+    if (!mesh)
+        return -1;
+
+    size_t inputTriangles = mesh->indices.size() / 3;
+    options.targetTriangles = triangles > 0 ? (size_t)triangles : (size_t)(inputTriangles * ratio);
+    PartC::SimplifyResult result = PartC::MeshSimplifier::Simplify(*mesh, options);
+
+    std::cout << "[Simplify] " << result.trianglesIn << " -> " << result.trianglesOut << " triangles (target "
+              << options.targetTriangles << "), " << result.verticesIn << " -> " << result.verticesOut << " vertices\n"
+              << "[Simplify] error " << result.error << " (" << result.relativeError * 100.0f << "% of model size), "
+              << result.passes << " passes, " << result.ms << " ms" << std::endl;
+
+    if (!result.mesh)
+    {
+        std::cerr << "Error: nothing could be removed from " << inputPath << std::endl;
+        return -1;
+    }
+    return ModelLoader::ExportMesh(result.mesh, outputPath) ? 0 : -1;
+}
@@ -0,0 +1,130 @@
+#include "TextureContainer.h"
+#include "VirtualTexture.h"
+#include "Renderer.h"
+#include "stb_image.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void PrintUsage(const char *exe)
+{
+    std::cout << "Usage: " << exe << " image [image ...] [--box] [--linear] [--bc1 | --bc3 | --bc7] [--virtual]\n"
+              << "  writes <image>.texcache next to each image (full mip chain)\n"
+              << "  --box      area-average mips instead of Kaiser-windowed sinc\n"
+              << "  --linear   data / normal maps: filter the stored values, no sRGB decode\n"
+              << "  --bc1 / --bc3   S3TC blocks (BC1 without alpha, BC3 with)\n"
+              << "  --bc7      BPTC blocks (mode 6)\n"
+              << "  --virtual  writes <image>.vtex instead: 128x128 pages streamed at runtime (very large images)"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    // [Mips] 离线预计算 mip 链：运行时 TextureManager 直接映射 .texcache
+    std::vector<std::string> inputs;
+    bool srgb = true;
+    bool virtualTexture = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--box")
+            PartC::TextureContainer::mipFilter = PartC::MipFilter::Box;
+        else if (arg == "--kaiser")
+            PartC::TextureContainer::mipFilter = PartC::MipFilter::Kaiser;
+        else if (arg == "--linear")
+            srgb = false;
+        else if (arg == "--virtual")
+            virtualTexture = true;
+        else if (arg == "--bc1")
+            PartC::TextureContainer::compression = PartC::BlockFormat::BC1;
+        else if (arg == "--bc3")
+            PartC::TextureContainer::compression = PartC::BlockFormat::BC3;
+        else if (arg == "--bc7")
+            PartC::TextureContainer::compression = PartC::BlockFormat::BC7;
+        else if (arg[0] != '-')
+            inputs.push_back(arg);
+        else
+        {
+            PrintUsage(argv[0]);
+            return arg == "--help" ? 0 : -1;
+        }
+    }
+    if (inputs.empty())
+    {
+        PrintUsage(argv[0]);
+        return -1;
+    }
+
+    PartC::Renderer::headless = true;
+    int failed = 0;
+    for (const std::string &input : inputs)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        int width, height, channels;
+        unsigned char *data = stbi_load(input.c_str(), &width, &height, &channels, 0);
+        if (!data)
+        {
+            std::cerr << "Error: cannot decode " << input << std::endl;
+            failed++;
+            continue;
+        }
+
+        if (virtualTexture)
+        {
+            // [VT] 分页的 mip 链，运行时只读取反馈需要的页面
+            bool built = PartC::VirtualTextureFile::Build(data, width, height, channels, srgb, input);
+            stbi_image_free(data);
+            if (!built)
+            {
+                std::cerr << "Error: cannot write " << PartC::VirtualTextureFile::PathFor(input) << std::endl;
+                failed++;
+                continue;
+            }
+            auto file = PartC::VirtualTextureFile::Open(input);
+            float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            int pages = 0;
+            for (int l = 0; file && l < file->levels; l++)
+                pages += file->TilesX(l) * file->TilesY(l);
+            std::cout << "[VT] " << input << ": " << width << "x" << height << ", " << (file ? file->levels : 0)
+                      << " levels, " << pages << " pages, "
+                      << (double)pages * PartC::VirtualTextureFile::TILE_BYTES / 1048576.0 << " MB, " << ms << " ms"
+                      << std::endl;
+            continue;
+        }
+
+        auto container = PartC::TextureContainer::Build(data, width, height, channels, srgb,
+                                                        PartC::TextureContainer::mipFilter);
+        stbi_image_free(data);
+
+        // [BCn] 编码吞吐按所有 mip 层的像素计
+        auto encodeStart = std::chrono::high_resolution_clock::now();
+        container->Compress(PartC::TextureContainer::compression);
+        float encodeMs =
+            std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - encodeStart).count();
+        if (!container->Save(input))
+        {
+            std::cerr << "Error: cannot write " << PartC::TextureContainer::CachePath(input) << std::endl;
+            failed++;
+            continue;
+        }
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "[Mips] " << input << ": " << width << "x" << height << "x" << channels << ", "
+                  << container->levels.size() << " levels, " << container->Bytes() / 1024 << " KB, " << ms << " ms"
+                  << std::endl;
+        if (container->format != PartC::BlockFormat::None)
+        {
+            double texels = 0.0;
+            for (const PartC::TextureLevel &level : container->levels)
+                texels += (double)level.width * level.height;
+            std::cout << "[BCn] " << PartC::BlockCompression::Name(container->format) << ": PSNR " << container->psnr
+                      << " dB, " << encodeMs << " ms (" << texels / 1000.0 / encodeMs << " Mtexels/s)" << std::endl;
+        }
+        else if (PartC::TextureContainer::compression != PartC::BlockFormat::None)
+        {
+            std::cout << "[BCn] " << input << " left uncompressed (1-2 channels or size not a multiple of 4)" << std::endl;
+        }
+    }
+    return failed == 0 ? 0 : -1;
+}